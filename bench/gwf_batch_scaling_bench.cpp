@@ -0,0 +1,148 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+/*
+ * Thread scaling of batch translation. Every corpus is generated into a temporary directory and translated with 1, 2,
+ * 4, ... workers up to the given count; speedup and efficiency of each run are measured against the run with one
+ * worker. A line of JSON is written per run:
+ *
+ *   gwf_batch_scaling_bench [uniform|skewed|giant|all] [max threads, hardware threads by default]
+ *
+ * Corpora:
+ *   uniform - many small diagrams of one size;
+ *   skewed  - diagram sizes follow Zipf's law, the largest one is twice the second and 64 times the smallest;
+ *   giant   - one large diagram. Files are the unit of parallelism, there is no intra-file parallel mode, so this
+ *             corpus shows the ceiling of one worker rather than scaling.
+ *
+ * Workers never outnumber files, so the sweep stops at the number of files of a corpus.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gwf_batch_translator.hpp"
+#include "gwf_generator.hpp"
+
+namespace
+{
+// Diagram with the given number of nodes, other elements are proportional to them
+GWFGenerator::Params MakeParams(std::size_t nodesCount, uint64_t seed)
+{
+  GWFGenerator::Params params;
+  params.m_seed = seed;
+  params.m_nodesCount = nodesCount;
+  params.m_stringLinksCount = nodesCount / 10;
+  params.m_numericLinksCount = nodesCount / 20;
+  params.m_imageLinksCount = nodesCount / 200;
+  params.m_busesCount = nodesCount / 100;
+  params.m_rootContoursCount = std::max<std::size_t>(nodesCount / 500, 1);
+  params.m_contourDepth = 2;
+  params.m_contourFanOut = 2;
+  params.m_pairsCount = nodesCount;
+  params.m_arcsCount = nodesCount / 2;
+  params.m_attributeChainsCount = nodesCount / 50;
+  params.m_attributeChainLength = 2;
+  params.m_hubsCount = std::max<std::size_t>(nodesCount / 1000, 1);
+  params.m_hubConnectorsPercent = 10;
+  return params;
+}
+
+std::vector<std::size_t> GetCorpusSizes(std::string const & corpus)
+{
+  if (corpus == "uniform")
+    return std::vector<std::size_t>(256, 500);
+
+  if (corpus == "skewed")
+  {
+    std::vector<std::size_t> sizes;
+    for (std::size_t rank = 1; rank <= 64; ++rank)
+      sizes.push_back(64000 / rank);
+    return sizes;
+  }
+
+  if (corpus == "giant")
+    return {200000};
+
+  return {};
+}
+
+std::vector<std::string> GenerateCorpus(std::string const & corpus, std::filesystem::path const & directory)
+{
+  std::vector<std::string> filePaths;
+  std::vector<std::size_t> const & sizes = GetCorpusSizes(corpus);
+  for (std::size_t i = 0; i < sizes.size(); ++i)
+  {
+    std::string const & filePath = (directory / (corpus + "_" + std::to_string(i) + ".gwf")).string();
+    std::ofstream file(filePath);
+    GWFGenerator::Generate(MakeParams(sizes[i], i + 1), file);
+    filePaths.push_back(filePath);
+  }
+  return filePaths;
+}
+
+void RunCorpus(std::string const & corpus, std::size_t maxThreadsCount, std::filesystem::path const & directory)
+{
+  std::vector<std::string> const & filePaths = GenerateCorpus(corpus, directory);
+
+  std::size_t const lastThreadsCount = std::min(maxThreadsCount, filePaths.size());
+  std::vector<std::size_t> threadsCounts;
+  for (std::size_t threadsCount = 1; threadsCount < lastThreadsCount; threadsCount *= 2)
+    threadsCounts.push_back(threadsCount);
+  threadsCounts.push_back(lastThreadsCount);
+
+  GWFBatchTranslator::Stats baseline;
+  for (std::size_t const threadsCount : threadsCounts)
+  {
+    GWFBatchTranslator::Stats stats;
+    auto const & results = GWFBatchTranslator::Translate(filePaths, threadsCount, &stats);
+    std::size_t const failuresCount = std::count_if(
+        results.cbegin(),
+        results.cend(),
+        [](GWFBatchTranslator::Result const & result)
+        {
+          return !result.m_errorMessage.empty();
+        });
+
+    if (threadsCount == 1)
+      baseline = stats;
+    std::cout << "{\"corpus\": \"" << corpus << "\", \"files\": " << filePaths.size()
+              << ", \"failures\": " << failuresCount << ", \"run\": " << stats.ToJSON(&baseline) << "}" << std::endl;
+  }
+
+  for (std::string const & filePath : filePaths)
+    std::filesystem::remove(filePath);
+}
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  std::string const corpus = argc > 1 ? argv[1] : "all";
+  std::size_t const maxThreadsCount =
+      argc > 2 ? std::stoul(argv[2]) : std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+
+  std::vector<std::string> corpora = {corpus};
+  if (corpus == "all")
+    corpora = {"uniform", "skewed", "giant"};
+  else if (GetCorpusSizes(corpus).empty())
+  {
+    std::cerr << "Unknown corpus `" << corpus << "`, expected uniform, skewed, giant or all.\n";
+    return EXIT_FAILURE;
+  }
+
+  std::filesystem::path const directory = std::filesystem::temp_directory_path() / "gwf_batch_scaling_bench";
+  std::filesystem::create_directories(directory);
+  for (std::string const & name : corpora)
+    RunCorpus(name, maxThreadsCount, directory);
+  std::filesystem::remove_all(directory);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,107 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+#include "gwf_allocation_counter.hpp"
+#include "gwf_perf_counters.hpp"
+#include "gwf_translator_stats.hpp"
+
+/*!
+ * Reporting shared by the benchmark drivers. Stages are measured with GWFTranslatorStats::ScopedMeasurement, which sums
+ * figures of all repetitions, and are written per repetition and per unit of input. Allocations are exact only in
+ * builds with GWF_TRANSLATOR_COUNT_ALLOCATIONS defined, otherwise they're growth of live bytes; reports say which.
+ * Hardware counters, if the drivers enable them, are written per repetition and per element of every stage.
+ */
+class GWFBench
+{
+public:
+  // Enables hardware counters and opens them for the calling thread, they stay disabled if the kernel refuses all of
+  // them. Returns whether they're enabled.
+  static bool EnableCounters()
+  {
+    GWFPerfCounters::Enable();
+    GWFPerfCounters::Read();
+    for (std::size_t i = 0; i < static_cast<std::size_t>(GWFPerfCounters::Counter::Count); ++i)
+    {
+      if (GWFPerfCounters::IsAvailable(static_cast<GWFPerfCounters::Counter>(i)))
+        return true;
+    }
+    GWFPerfCounters::Disable();
+    return false;
+  }
+
+  // Writes `"name": {...}` with figures of one repetition, rates of elements and bytes are left out if they're zero,
+  // as well as counters the kernel refused
+  static void WriteFigures(
+      std::ostream & json,
+      std::string const & name,
+      GWFTranslatorStats::Figures const & figures,
+      std::size_t repetitionsCount,
+      std::size_t elementsCount,
+      std::size_t bytesCount)
+  {
+    double const wallTime = figures.m_wallTime / repetitionsCount;
+    json << "\"" << name << "\": {\"wall_time\": " << wallTime
+         << ", \"cpu_time\": " << figures.m_cpuTime / repetitionsCount
+         << ", \"allocations\": " << figures.m_allocationsCount / repetitionsCount
+         << ", \"allocated_bytes\": " << figures.m_allocatedBytes / repetitionsCount;
+
+    if (elementsCount > 0)
+      json << ", \"ns_per_element\": " << wallTime * 1e9 / elementsCount
+           << ", \"elements_per_second\": " << (wallTime > 0 ? elementsCount / wallTime : 0);
+    if (bytesCount > 0)
+      json << ", \"bytes_per_second\": " << (wallTime > 0 ? bytesCount / wallTime : 0);
+    if (GWFPerfCounters::IsEnabled())
+      WriteCounters(json, figures.m_counters, repetitionsCount, elementsCount);
+    json << "}";
+  }
+
+  static char const * GetAllocationsKind()
+  {
+    return GWFAllocationCounter::IsExact() ? "exact" : "live_bytes_growth";
+  }
+
+private:
+  static void WriteCounters(
+      std::ostream & json,
+      GWFPerfCounters::Values const & counters,
+      std::size_t repetitionsCount,
+      std::size_t elementsCount)
+  {
+    using Counter = GWFPerfCounters::Counter;
+
+    std::stringstream perElement;
+    json << ", \"counters\": {";
+    bool isFirst = true;
+    for (std::size_t i = 0; i < counters.size(); ++i)
+    {
+      auto const counter = static_cast<Counter>(i);
+      if (!GWFPerfCounters::IsAvailable(counter))
+        continue;
+
+      if (!isFirst)
+      {
+        json << ", ";
+        perElement << ", ";
+      }
+      isFirst = false;
+
+      char const * name = GWFPerfCounters::GetCounterName(counter);
+      double const value = static_cast<double>(counters[i]) / repetitionsCount;
+      json << "\"" << name << "\": " << value;
+      perElement << "\"" << name << "\": " << (elementsCount > 0 ? value / elementsCount : 0);
+    }
+    json << "}";
+    if (elementsCount > 0)
+      json << ", \"counters_per_element\": {" << perElement.str() << "}";
+  }
+};
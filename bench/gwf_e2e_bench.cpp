@@ -0,0 +1,295 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+/*
+ * End-to-end cost of translation and a gate against its regressions. A fixed corpus is generated into
+ * bench/gwf_e2e_corpus and translated by both pipelines: TranslateXMLFileContentToSCs, and TranslateImpl into a local
+ * sc-memory. Wall and CPU time, peak RSS and bytes of output are written as one line of JSON and compared with the
+ * committed baseline bench/gwf_e2e_baseline.json, see GWFTranslatorStats::FindRegressions. Run from the root of the
+ * repository:
+ *
+ *   gwf_e2e_bench [check|baseline|freeze, check by default] [threshold percent, 20 by default]
+ *                 [repetitions, 20 by default]
+ *
+ * Modes:
+ *   check    - the exit status is non-zero if any cost exceeds its baseline by more than the threshold;
+ *   baseline - the report replaces the baseline, on the machine the gate runs on;
+ *   freeze   - golden files of the corpus that are missing are written by the reference pipeline, see
+ *              GWFOutputChecker::FreezeReference. Nothing is measured.
+ *
+ * Before anything is measured, output of TranslateXMLFileContentToSCs is checked against the committed golden files
+ * next to the corpus. The first divergent element of every divergent file is reported, and the exit status is
+ * non-zero in any mode. If the generator changes the corpus on purpose, its golden files are removed and frozen again.
+ *
+ * Time of a pipeline is the least of its repetitions, so that a single preempted run doesn't fail the gate. Peak RSS
+ * is reset before each pipeline if the kernel allows it, otherwise it's the high-water mark of the process so far.
+ * Figures that are missing from the baseline aren't compared.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sc-memory/sc_debug.hpp>
+#include <sc-memory/sc_memory.hpp>
+
+#include "gwf_generator.hpp"
+#include "gwf_output_checker.hpp"
+#include "gwf_translator.hpp"
+#include "gwf_translator_stats.hpp"
+
+namespace
+{
+std::string const CORPUS_DIRECTORY_PATH = "bench/gwf_e2e_corpus";
+std::string const BASELINE_FILE_PATH = "bench/gwf_e2e_baseline.json";
+
+std::size_t const NODES_COUNT = 500;
+
+std::vector<std::string> const SHAPES = {"flat", "contoured", "connectors"};
+
+// Image contents are left out: their blobs and paths depend on the machine
+GWFGenerator::Params MakeParams(std::string const & shape)
+{
+  GWFGenerator::Params params;
+  params.m_seed = 1;
+  params.m_nodesCount = NODES_COUNT;
+  params.m_stringLinksCount = NODES_COUNT / 10;
+  params.m_numericLinksCount = NODES_COUNT / 20;
+  params.m_pairsCount = NODES_COUNT;
+
+  if (shape == "contoured")
+  {
+    params.m_rootContoursCount = 2;
+    params.m_contourDepth = 4;
+    params.m_contourFanOut = 2;
+    params.m_contouredElementsPercent = 90;
+  }
+  else if (shape == "connectors")
+  {
+    params.m_pairsCount = 2 * NODES_COUNT;
+    params.m_arcsCount = NODES_COUNT / 2;
+    params.m_attributeChainsCount = NODES_COUNT / 20;
+    params.m_attributeChainLength = 5;
+    params.m_busesCount = NODES_COUNT / 100;
+    params.m_hubsCount = 1;
+    params.m_hubConnectorsPercent = 10;
+  }
+  return params;
+}
+
+// Returns paths of the generated files
+std::vector<std::string> GenerateCorpus()
+{
+  std::filesystem::create_directories(CORPUS_DIRECTORY_PATH);
+
+  std::vector<std::string> filePaths;
+  for (std::string const & shape : SHAPES)
+  {
+    std::string const filePath = CORPUS_DIRECTORY_PATH + "/" + shape + ".gwf";
+    std::ofstream file(filePath, std::ios::binary);
+    GWFGenerator::Generate(MakeParams(shape), file);
+    if (!file)
+      SC_THROW_EXCEPTION(utils::ExceptionInvalidState, "gwf_e2e_bench: Unable to write `" << filePath << "`.");
+    filePaths.push_back(filePath);
+  }
+  return filePaths;
+}
+
+std::string ReadFile(std::string const & filePath)
+{
+  std::ifstream file(filePath, std::ios::binary);
+  std::stringstream content;
+  content << file.rdbuf();
+  return content.str();
+}
+
+// Writing 5 to clear_refs resets the high-water mark of RSS, which getrusage doesn't see
+void ResetPeakRSS()
+{
+  std::ofstream("/proc/self/clear_refs") << "5";
+}
+
+std::size_t ReadPeakRSS()
+{
+  std::ifstream file("/proc/self/status");
+  std::string line;
+  while (std::getline(file, line))
+  {
+    if (line.rfind("VmHWM:", 0) == 0)
+      return std::stoul(line.substr(line.find_first_not_of(" \t", 6))) * 1024;
+  }
+  return GWFTranslatorStats::GetPeakRSS();
+}
+
+struct PipelineFigures
+{
+  double m_wallTime = std::numeric_limits<double>::max();
+  double m_cpuTime = std::numeric_limits<double>::max();
+  std::size_t m_peakRSS = 0;
+  std::size_t m_outputBytes = 0;
+};
+
+// translate translates one file and returns the number of bytes of its output
+PipelineFigures RunPipeline(
+    std::vector<std::string> const & filePaths,
+    std::size_t repetitionsCount,
+    std::function<std::size_t(std::string const &)> const & translate)
+{
+  ResetPeakRSS();
+
+  PipelineFigures figures;
+  for (std::size_t i = 0; i < repetitionsCount; ++i)
+  {
+    GWFTranslatorStats stats;
+    std::size_t outputBytes = 0;
+    {
+      GWFTranslatorStats::ScopedMeasurement const measurement(&stats);
+      for (auto const & filePath : filePaths)
+        outputBytes += translate(filePath);
+    }
+    figures.m_wallTime = std::min(figures.m_wallTime, stats.m_total.m_wallTime);
+    figures.m_cpuTime = std::min(figures.m_cpuTime, stats.m_total.m_cpuTime);
+    figures.m_outputBytes = outputBytes;
+  }
+
+  figures.m_peakRSS = ReadPeakRSS();
+  return figures;
+}
+
+void WritePipeline(std::ostream & json, std::string const & name, PipelineFigures const & figures)
+{
+  json << "\"" << name << "\": {\"wall_time\": " << figures.m_wallTime << ", \"cpu_time\": " << figures.m_cpuTime
+       << ", \"peak_rss\": " << figures.m_peakRSS << ", \"output_bytes\": " << figures.m_outputBytes << "}";
+}
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  std::string const mode = argc > 1 ? argv[1] : "check";
+  double const thresholdPercent = argc > 2 ? std::stod(argv[2]) : 20;
+  std::size_t const repetitionsCount = argc > 3 ? std::max<std::size_t>(std::stoul(argv[3]), 1) : 20;
+
+  if (mode != "check" && mode != "baseline" && mode != "freeze")
+  {
+    std::cerr << "Unknown mode `" << mode << "`, expected check, baseline or freeze.\n";
+    return EXIT_FAILURE;
+  }
+
+  std::vector<std::string> const filePaths = GenerateCorpus();
+
+  if (mode == "freeze")
+  {
+    std::cout << GWFOutputChecker::FreezeReference(filePaths) << " golden files have been written.\n";
+    return EXIT_SUCCESS;
+  }
+
+  // The candidate reads a file by its path, so files are checked one by one
+  std::vector<GWFOutputChecker::Divergence> divergences;
+  for (auto const & filePath : filePaths)
+  {
+    auto const & fileDivergences = GWFOutputChecker::Check(
+        {filePath},
+        [&filePath](std::string const &)
+        {
+          return GWFTranslator::TranslateXMLFileContentToSCs(filePath);
+        });
+    divergences.insert(divergences.cend(), fileDivergences.cbegin(), fileDivergences.cend());
+  }
+
+  for (auto const & divergence : divergences)
+    std::cerr << "Output of `" << divergence.m_filePath << "` diverges from its golden file: "
+              << divergence.m_description << ".\n";
+  if (!divergences.empty())
+    return EXIT_FAILURE;
+
+  std::size_t elementsCount = 0;
+  std::size_t inputBytes = 0;
+  for (auto const & filePath : filePaths)
+  {
+    GWFTranslatorStats stats;
+    GWFTranslator::TranslateXMLFileContentToSCs(filePath, &stats);
+    elementsCount += stats.GetElementsCount();
+    inputBytes += std::filesystem::file_size(filePath);
+  }
+
+  PipelineFigures const xmlToSCs = RunPipeline(
+      filePaths,
+      repetitionsCount,
+      [](std::string const & filePath)
+      {
+        return GWFTranslator::TranslateXMLFileContentToSCs(filePath).size();
+      });
+
+  std::string const repoPath = (std::filesystem::temp_directory_path() / "gwf_e2e_bench_repo").string();
+  sc_memory_params memoryParams;
+  sc_memory_params_clear(&memoryParams);
+  memoryParams.clear = SC_TRUE;
+  memoryParams.repo_path = repoPath.c_str();
+  ScMemory::Initialize(memoryParams);
+
+  PipelineFigures translateImpl;
+  bool isTranslated = true;
+  {
+    ScMemoryContext context;
+    GWFTranslator translator(context);
+    translateImpl = RunPipeline(
+        filePaths,
+        repetitionsCount,
+        [&translator, &isTranslated](std::string const & filePath)
+        {
+          Translator::Params params;
+          params.m_fileName = filePath;
+          params.m_autoFormatInfo = false;
+          isTranslated = translator.Translate(params) && isTranslated;
+          return translator.GetStats().m_outputBytes;
+        });
+  }
+
+  ScMemory::Shutdown(false);
+  std::filesystem::remove_all(repoPath);
+
+  std::stringstream report;
+  report << "{\"corpus\": {\"files\": " << filePaths.size() << ", \"elements\": " << elementsCount
+         << ", \"input_bytes\": " << inputBytes << "}, \"repetitions\": " << repetitionsCount << ", \"pipelines\": {";
+  WritePipeline(report, "xml_to_scs", xmlToSCs);
+  report << ", ";
+  WritePipeline(report, "translate_impl", translateImpl);
+  report << "}}";
+  std::cout << report.str() << std::endl;
+
+  if (!isTranslated)
+  {
+    std::cerr << "TranslateImpl has failed.\n";
+    return EXIT_FAILURE;
+  }
+
+  if (mode == "baseline")
+  {
+    std::ofstream(BASELINE_FILE_PATH) << report.str() << "\n";
+    return EXIT_SUCCESS;
+  }
+
+  std::string const baseline = ReadFile(BASELINE_FILE_PATH);
+  if (baseline.empty())
+  {
+    std::cerr << "Baseline `" << BASELINE_FILE_PATH << "` is missing, run in baseline mode.\n";
+    return EXIT_FAILURE;
+  }
+
+  std::vector<std::string> const regressions =
+      GWFTranslatorStats::FindRegressions(report.str(), baseline, thresholdPercent);
+  for (auto const & regression : regressions)
+    std::cerr << "Regression of " << regression << ".\n";
+
+  return regressions.empty() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
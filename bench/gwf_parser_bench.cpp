@@ -0,0 +1,144 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+/*
+ * Parser throughput. Diagrams of several shapes and sizes are generated in memory, and every public phase of GWFParser
+ * is measured on its own, as well as Parse as a whole. A line of JSON is written per diagram:
+ *
+ *   gwf_parser_bench [largest number of nodes, 100000 by default] [repetitions, 5 by default]
+ *
+ * Shapes:
+ *   flat       - nodes and pairs without contours;
+ *   contoured  - most elements are in contours nested 6 levels deep;
+ *   connectors - three connectors per node, arcs to arcs included;
+ *   images     - every tenth node is a link with image content, so the text is mostly base64.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "gwf_bench.hpp"
+#include "gwf_generator.hpp"
+#include "gwf_parser.hpp"
+
+namespace
+{
+using Phase = GWFTranslatorStats::Phase;
+
+std::vector<std::string> const SHAPES = {"flat", "contoured", "connectors", "images"};
+
+GWFGenerator::Params MakeParams(std::string const & shape, std::size_t nodesCount)
+{
+  GWFGenerator::Params params;
+  params.m_seed = nodesCount;
+  params.m_nodesCount = nodesCount;
+  params.m_stringLinksCount = nodesCount / 10;
+  params.m_numericLinksCount = nodesCount / 20;
+  params.m_pairsCount = nodesCount;
+
+  if (shape == "contoured")
+  {
+    params.m_rootContoursCount = std::max<std::size_t>(nodesCount / 1000, 1);
+    params.m_contourDepth = 6;
+    params.m_contourFanOut = 2;
+    params.m_contouredElementsPercent = 90;
+  }
+  else if (shape == "connectors")
+  {
+    params.m_pairsCount = 2 * nodesCount;
+    params.m_arcsCount = nodesCount / 2;
+    params.m_attributeChainsCount = nodesCount / 20;
+    params.m_attributeChainLength = 5;
+    params.m_busesCount = nodesCount / 100;
+  }
+  else if (shape == "images")
+  {
+    params.m_imageLinksCount = nodesCount / 10;
+    params.m_imageSize = 4 * 1024;
+  }
+  return params;
+}
+
+void RunDiagram(std::string const & shape, std::size_t nodesCount, std::size_t repetitionsCount)
+{
+  std::string const xmlStr = GWFGenerator::Generate(MakeParams(shape, nodesCount));
+
+  GWFTranslatorStats phases;
+  GWFTranslatorStats parse;
+  std::size_t elementsCount = 0;
+  for (std::size_t i = 0; i < repetitionsCount; ++i)
+  {
+    SCgElements elementsWithoutParents;
+    SCgElements allElements;
+    SCgConnectors connectors;
+    SCgContours contours;
+    GWFParser::XmlDocumentPtr document(nullptr, &xmlFreeDoc);
+    {
+      GWFTranslatorStats::ScopedMeasurement const measurement(&phases, Phase::XMLParse);
+      document = GWFParser::ReadDocument(xmlStr);
+    }
+    {
+      GWFTranslatorStats::ScopedMeasurement const measurement(&phases, Phase::ElementCreation);
+      GWFParser::ProcessStaticSector(
+          GWFParser::FindStaticSector(document.get()), elementsWithoutParents, allElements, connectors, contours);
+    }
+    {
+      GWFTranslatorStats::ScopedMeasurement const measurement(&phases, Phase::ConnectorResolution);
+      GWFParser::FillConnectors(connectors, allElements);
+    }
+    {
+      GWFTranslatorStats::ScopedMeasurement const measurement(&phases, Phase::ContourResolution);
+      GWFParser::FillContours(contours, allElements);
+    }
+    elementsCount = allElements.size();
+  }
+
+  // Elements are freed after the measurement, as the phases above free them after theirs
+  for (std::size_t i = 0; i < repetitionsCount; ++i)
+  {
+    SCgElements elements;
+    GWFTranslatorStats::ScopedMeasurement const measurement(&parse);
+    GWFParser::Parse(xmlStr, elements);
+  }
+
+  std::cout << "{\"shape\": \"" << shape << "\", \"nodes\": " << nodesCount << ", \"elements\": " << elementsCount
+            << ", \"bytes\": " << xmlStr.size() << ", \"repetitions\": " << repetitionsCount
+            << ", \"allocations_kind\": \"" << GWFBench::GetAllocationsKind() << "\", \"phases\": {";
+  for (Phase const phase :
+       {Phase::XMLParse, Phase::ElementCreation, Phase::ConnectorResolution, Phase::ContourResolution})
+  {
+    GWFBench::WriteFigures(
+        std::cout,
+        GWFTranslatorStats::GetPhaseName(phase),
+        phases.GetPhase(phase),
+        repetitionsCount,
+        elementsCount,
+        xmlStr.size());
+    std::cout << ", ";
+  }
+  GWFBench::WriteFigures(std::cout, "parse", parse.m_total, repetitionsCount, elementsCount, xmlStr.size());
+  std::cout << "}}" << std::endl;
+}
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  std::size_t const maxNodesCount = argc > 1 ? std::stoul(argv[1]) : 100000;
+  std::size_t const repetitionsCount = argc > 2 ? std::max<std::size_t>(std::stoul(argv[2]), 1) : 5;
+
+  GWFBench::EnableCounters();
+  xmlInitParser();
+  for (std::string const & shape : SHAPES)
+  {
+    for (std::size_t nodesCount = 1000; nodesCount <= maxNodesCount; nodesCount *= 10)
+      RunDiagram(shape, nodesCount, repetitionsCount);
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,202 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+/*
+ * Growth of translation cost on diagram shapes that used to make it superlinear, and a gate against such growth
+ * coming back. Every shape is swept over sizes that double, parsing and writing are measured apart, and the exponent
+ * of cost over the number of elements is fitted by least squares on a log-log scale. A stage fails if its exponent
+ * exceeds the exponent of n·log n over the same sizes by more than the tolerance. A line of JSON is written per shape
+ * and stage, and the exit status is non-zero if any stage fails:
+ *
+ *   gwf_shapes_bench [smallest number of nodes, 32000 by default] [sizes, 3 by default] [tolerance]
+ *
+ * Cost is the number of retired instructions if GWFPerfCounters can read them, and wall time otherwise. Time per
+ * element also grows while the working set outgrows CPU caches, so by default the sweep starts at about 100000
+ * elements, where the working set is past them, and the tolerance is 0.3 for time and 0.15 for instructions. A sweep
+ * takes minutes.
+ *
+ * Shapes:
+ *   arc_chains    - chains of arcs to arcs whose number grows with the diagram, see complex arcs of SCsWriter::Write;
+ *   deep_contours - one chain of nested contours whose depth grows as the square root of the diagram, see
+ *                   SCsWriter::CollectNodes. Every level is indented, so SCs text of a depth that grows linearly would
+ *                   itself be quadratic;
+ *   hubs          - one node that every other connector starts from, so its fan-out grows with the diagram.
+ *
+ * Cost of a size is the least of several runs, so that a single preempted run doesn't fail the gate.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "gwf_generator.hpp"
+#include "gwf_parser.hpp"
+#include "gwf_perf_counters.hpp"
+#include "gwf_translator_stats.hpp"
+#include "sc_scs_writer.hpp"
+
+namespace
+{
+std::size_t const RUNS_COUNT = 3;
+
+std::vector<std::string> const SHAPES = {"arc_chains", "deep_contours", "hubs"};
+std::vector<std::string> const STAGES = {"parse", "write"};
+
+GWFGenerator::Params MakeParams(std::string const & shape, std::size_t nodesCount)
+{
+  GWFGenerator::Params params;
+  params.m_seed = nodesCount;
+  params.m_nodesCount = nodesCount;
+  params.m_pairsCount = nodesCount;
+
+  if (shape == "arc_chains")
+  {
+    params.m_arcsCount = nodesCount / 2;
+    params.m_attributeChainsCount = nodesCount / 10;
+    params.m_attributeChainLength = 8;
+  }
+  else if (shape == "deep_contours")
+  {
+    params.m_rootContoursCount = 1;
+    params.m_contourFanOut = 1;
+    params.m_contourDepth = static_cast<std::size_t>(std::sqrt(nodesCount));
+    params.m_contouredElementsPercent = 90;
+  }
+  else if (shape == "hubs")
+  {
+    params.m_arcsCount = nodesCount;
+    params.m_hubsCount = 1;
+    params.m_hubConnectorsPercent = 50;
+  }
+  return params;
+}
+
+bool IsCostCounted()
+{
+  return GWFPerfCounters::IsEnabled() && GWFPerfCounters::IsAvailable(GWFPerfCounters::Counter::Instructions);
+}
+
+// Instructions or seconds of the cheapest run of a stage
+double MeasureStage(std::string const & stage, std::string const & xmlStr)
+{
+  double bestCost = std::numeric_limits<double>::max();
+  for (std::size_t i = 0; i < RUNS_COUNT; ++i)
+  {
+    GWFTranslatorStats stats;
+    SCgElements elements;
+    if (stage == "parse")
+    {
+      GWFTranslatorStats::ScopedMeasurement const measurement(&stats);
+      GWFParser::Parse(xmlStr, elements);
+    }
+    else
+    {
+      GWFParser::Parse(xmlStr, elements);
+      Buffer scsBuffer;
+      SCgElementsSet writtenElements;
+      GWFTranslatorStats::ScopedMeasurement const measurement(&stats);
+      SCsWriter::IdentifierIndex const identifiers(elements);
+      SCsWriter::Write(elements, "bench.gwf", scsBuffer, 0, writtenElements, identifiers);
+    }
+    double const cost =
+        IsCostCounted()
+            ? stats.m_total.m_counters[static_cast<std::size_t>(GWFPerfCounters::Counter::Instructions)]
+            : stats.m_total.m_wallTime;
+    bestCost = std::min(bestCost, cost);
+  }
+  return bestCost;
+}
+
+// Slope of the least squares line through points (log x, log y)
+double FitExponent(std::vector<double> const & xs, std::vector<double> const & ys)
+{
+  double meanX = 0;
+  double meanY = 0;
+  for (std::size_t i = 0; i < xs.size(); ++i)
+  {
+    meanX += std::log(xs[i]) / xs.size();
+    meanY += std::log(ys[i]) / ys.size();
+  }
+
+  double covariance = 0;
+  double variance = 0;
+  for (std::size_t i = 0; i < xs.size(); ++i)
+  {
+    double const x = std::log(xs[i]) - meanX;
+    covariance += x * (std::log(ys[i]) - meanY);
+    variance += x * x;
+  }
+  return variance > 0 ? covariance / variance : 0;
+}
+
+bool RunShape(std::string const & shape, std::size_t minNodesCount, std::size_t sizesCount, double tolerance)
+{
+  std::vector<double> elementsCounts;
+  std::vector<double> nLogNs;
+  std::vector<std::vector<double>> costs(STAGES.size());
+  for (std::size_t i = 0, nodesCount = minNodesCount; i < sizesCount; ++i, nodesCount *= 2)
+  {
+    std::string const xmlStr = GWFGenerator::Generate(MakeParams(shape, nodesCount));
+
+    SCgElements elements;
+    GWFTranslatorStats stats;
+    GWFParser::Parse(xmlStr, elements, &stats);
+    double const elementsCount = stats.GetElementsCount();
+    elementsCounts.push_back(elementsCount);
+    nLogNs.push_back(elementsCount * std::log2(elementsCount));
+
+    for (std::size_t j = 0; j < STAGES.size(); ++j)
+      costs[j].push_back(MeasureStage(STAGES[j], xmlStr));
+  }
+
+  bool isPassed = true;
+  double const limit = FitExponent(elementsCounts, nLogNs) + tolerance;
+  for (std::size_t j = 0; j < STAGES.size(); ++j)
+  {
+    double const exponent = FitExponent(elementsCounts, costs[j]);
+    bool const isStagePassed = exponent <= limit;
+    isPassed = isPassed && isStagePassed;
+
+    char const * costName = IsCostCounted() ? "instructions" : "wall_time";
+    std::cout << "{\"shape\": \"" << shape << "\", \"stage\": \"" << STAGES[j] << "\", \"cost\": \"" << costName
+              << "\", \"points\": [";
+    for (std::size_t i = 0; i < elementsCounts.size(); ++i)
+    {
+      std::cout << (i > 0 ? ", " : "") << "{\"elements\": " << elementsCounts[i] << ", \"" << costName
+                << "\": " << costs[j][i] << ", \"" << costName << "_per_element\": " << costs[j][i] / elementsCounts[i]
+                << "}";
+    }
+    std::cout << "], \"exponent\": " << exponent << ", \"limit\": " << limit
+              << ", \"passed\": " << (isStagePassed ? "true" : "false") << "}" << std::endl;
+  }
+  return isPassed;
+}
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  std::size_t const minNodesCount = argc > 1 ? std::stoul(argv[1]) : 32000;
+  std::size_t const sizesCount = argc > 2 ? std::max<std::size_t>(std::stoul(argv[2]), 2) : 3;
+
+  // Counters are opened by the first read, those the kernel refuses are marked unavailable then
+  GWFPerfCounters::Enable();
+  GWFPerfCounters::Read();
+  if (!GWFPerfCounters::IsAvailable(GWFPerfCounters::Counter::Instructions))
+    GWFPerfCounters::Disable();
+  double const tolerance = argc > 3 ? std::stod(argv[3]) : (IsCostCounted() ? 0.15 : 0.3);
+
+  bool isPassed = true;
+  for (std::string const & shape : SHAPES)
+    isPassed = RunShape(shape, minNodesCount, sizesCount, tolerance) && isPassed;
+
+  if (!isPassed)
+    std::cerr << "Translation cost grows faster than n·log n.\n";
+  return isPassed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,263 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+/*
+ * Type conversion lookups over type frequency distributions. For every distribution a diagram is generated with it as
+ * type weights, and types of its nodes and connectors are replayed in document order through
+ * SCgToSCsTypesConverter, as the writer looks them up. A line of JSON is written per distribution:
+ *
+ *   gwf_types_bench [repetitions, 20 by default] [gwf-files to capture a distribution from]...
+ *
+ * Distributions:
+ *   typical     - mostly constant nodes and membership pairs, few variables, legacy, unsupported and unknown types;
+ *   backward    - legacy types only. Legacy node types are looked up through the backward map; every legacy connector
+ *                 type is a key of the forward map as well, so connectors never reach the backward map;
+ *   unsupported - types only the unsupported maps have, each of them misses the other maps first;
+ *   uniform     - all types known to the converter are equally frequent;
+ *   corpus      - type frequencies of the given gwf-files, collected by GWFGraphStatistics.
+ *
+ * Builds with GWF_TRANSLATOR_COUNT_HOT_PATHS defined also report probes of type maps per lookup.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sc-memory/sc_debug.hpp>
+
+#include "gwf_bench.hpp"
+#include "gwf_generator.hpp"
+#include "gwf_graph_statistics.hpp"
+#include "gwf_hot_path_counters.hpp"
+#include "sc_scg_element.hpp"
+#include "sc_scg_to_scs_types_converter.hpp"
+
+using namespace Constants;
+
+namespace
+{
+using Weights = std::vector<std::pair<std::string, std::size_t>>;
+
+struct Distribution
+{
+  std::string m_name;
+  Weights m_nodeTypeWeights;
+  Weights m_connectorTypeWeights;
+};
+
+std::size_t const NODES_COUNT = 20000;
+
+std::vector<Distribution> GetDistributions()
+{
+  return {
+      {"typical",
+       {{"node/const/general_node", 500},
+        {"node/const/group", 120},
+        {"node/const/relation", 60},
+        {"node/const/role", 60},
+        {"node/var/general_node", 60},
+        {"node/const/struct", 40},
+        {"node/const/tuple", 30},
+        {"node/const/terminal", 20},
+        {"node/const/material", 20},
+        {"node/const/predmet", 10},
+        {"node/const/nopredmet", 10},
+        {"node/const/perm/general", 5},
+        {"node/var/perm/general", 3},
+        {"node/const/unknown", 2}},
+       {{"pair/const/pos/perm/orient/membership", 600},
+        {"pair/const/-/perm/orient", 150},
+        {"pair/const/-/perm/noorien", 50},
+        {"pair/var/pos/perm/orient/membership", 60},
+        {"pair/var/-/perm/orient", 30},
+        {"arc/const/pos", 80},
+        {"pair/const/synonym", 20},
+        {"pair/var/orient", 10},
+        {"pair/meta/-/perm/orient", 3},
+        {"pair/var/-/temp/orient", 3},
+        {"pair/const/unknown", 2}}},
+      {"backward",
+       {{"node/const/material", 1},
+        {"node/const/predmet", 1},
+        {"node/const/nopredmet", 1},
+        {"node/const/asymmetry", 1},
+        {"node/var/symmetry", 1},
+        {"node/var/material", 1}},
+       {{"pair/const/synonym", 1},
+        {"pair/const/orient", 1},
+        {"pair/var/orient", 1},
+        {"arc/const/fuz", 1},
+        {"arc/var/neg", 1}}},
+      {"unsupported",
+       {{"node/const/perm/general", 1},
+        {"node/const/temp/terminal", 1},
+        {"node/var/perm/struct", 1},
+        {"node/meta/temp/group", 1}},
+       {{"pair/var/-/temp/noorien", 1},
+        {"pair/meta/-/perm/orient", 1},
+        {"pair/meta/pos/temp/orient/membership", 1}}},
+      {"uniform", {}, {}}};
+}
+
+std::string ReadFile(std::string const & filePath)
+{
+  std::ifstream file(filePath);
+  if (!file.is_open())
+    SC_THROW_EXCEPTION(utils::ExceptionItemNotFound, "gwf_types_bench: Unable to open file `" << filePath << "`.");
+
+  std::stringstream text;
+  text << file.rdbuf();
+  return text.str();
+}
+
+Distribution CaptureDistribution(std::vector<std::string> const & filePaths)
+{
+  std::map<std::string, std::size_t> nodeTypes;
+  std::map<std::string, std::size_t> connectorTypes;
+  for (std::string const & filePath : filePaths)
+  {
+    auto const & statistics = GWFGraphStatistics::Collect(ReadFile(filePath), filePath);
+    for (auto const & [kind, types] : statistics.m_types)
+    {
+      // Links, buses and contours have types of their own, the generator takes node weights for nodes only
+      if (kind != NODE && kind != PAIR && kind != ARC)
+        continue;
+
+      auto & counts = kind == NODE ? nodeTypes : connectorTypes;
+      for (auto const & [type, count] : types)
+        counts[type] += count;
+    }
+  }
+
+  return {
+      "corpus",
+      Weights(nodeTypes.cbegin(), nodeTypes.cend()),
+      Weights(connectorTypes.cbegin(), connectorTypes.cend())};
+}
+
+// Types are weighted for pairs and arcs together, the generator needs some of them for each
+bool HasTypes(Weights const & weights, std::string const & prefix)
+{
+  return weights.empty()
+         || std::any_of(
+             weights.cbegin(),
+             weights.cend(),
+             [&prefix](auto const & weight)
+             {
+               return weight.first.compare(0, prefix.size(), prefix) == 0;
+             });
+}
+
+GWFGenerator::Params MakeParams(Distribution const & distribution)
+{
+  GWFGenerator::Params params;
+  params.m_seed = 1;
+  params.m_nodesCount = NODES_COUNT;
+  params.m_pairsCount = HasTypes(distribution.m_connectorTypeWeights, PAIR) ? NODES_COUNT : 0;
+  params.m_arcsCount = HasTypes(distribution.m_connectorTypeWeights, ARC) ? NODES_COUNT / 2 : 0;
+  params.m_nodeTypeWeights = distribution.m_nodeTypeWeights;
+  params.m_connectorTypeWeights = distribution.m_connectorTypeWeights;
+  return params;
+}
+
+void RunDistribution(Distribution const & distribution, std::size_t repetitionsCount)
+{
+  SCgElements elementsWithoutParents;
+  GWFGenerator::Generate(MakeParams(distribution), elementsWithoutParents);
+
+  // Types are replayed in document order, generated ids grow with it
+  std::vector<std::pair<std::string, SCgElementPtr>> elements(
+      elementsWithoutParents.cbegin(), elementsWithoutParents.cend());
+  std::sort(
+      elements.begin(),
+      elements.end(),
+      [](auto const & first, auto const & second)
+      {
+        return std::make_pair(first.first.size(), first.first) < std::make_pair(second.first.size(), second.first);
+      });
+
+  std::vector<std::string> nodeTypes;
+  std::vector<std::string> connectorTypes;
+  for (auto const & [id, element] : elements)
+  {
+    if (element->GetTag() == PAIR || element->GetTag() == ARC)
+      connectorTypes.emplace_back(element->GetType());
+    else if (element->GetTag() == NODE)
+      nodeTypes.emplace_back(element->GetType());
+  }
+
+  GWFTranslatorStats nodeStats;
+  GWFTranslatorStats connectorStats;
+  std::size_t symbolsSize = 0;
+  std::string_view symbol;
+  uint64_t const nodeProbesStart =
+      GWFHotPathCounters::Sum()[static_cast<std::size_t>(GWFHotPathCounters::Counter::TypeTableProbes)];
+  for (std::size_t i = 0; i < repetitionsCount; ++i)
+  {
+    GWFTranslatorStats::ScopedMeasurement const measurement(&nodeStats);
+    for (std::string const & type : nodeTypes)
+    {
+      SCgToSCsTypesConverter::ConvertSCgNodeTypeToSCsNodeType(type, symbol);
+      symbolsSize += symbol.size();
+    }
+  }
+  uint64_t const connectorProbesStart =
+      GWFHotPathCounters::Sum()[static_cast<std::size_t>(GWFHotPathCounters::Counter::TypeTableProbes)];
+  for (std::size_t i = 0; i < repetitionsCount; ++i)
+  {
+    GWFTranslatorStats::ScopedMeasurement const measurement(&connectorStats);
+    for (std::string const & type : connectorTypes)
+    {
+      SCgToSCsTypesConverter::ConvertSCgConnectorTypeToSCsConnectorDesignation(type, symbol);
+      symbolsSize += symbol.size();
+    }
+  }
+  uint64_t const probesEnd =
+      GWFHotPathCounters::Sum()[static_cast<std::size_t>(GWFHotPathCounters::Counter::TypeTableProbes)];
+
+  // Symbols are summed, so that lookups aren't optimized away
+  if (symbolsSize == 0)
+    std::cerr << "No types of `" << distribution.m_name << "` have been converted.\n";
+
+  std::cout << "{\"distribution\": \"" << distribution.m_name << "\", \"node_lookups\": " << nodeTypes.size()
+            << ", \"connector_lookups\": " << connectorTypes.size() << ", \"repetitions\": " << repetitionsCount;
+  if (probesEnd > nodeProbesStart && !nodeTypes.empty() && !connectorTypes.empty())
+  {
+    std::cout << ", \"node_probes_per_lookup\": "
+              << static_cast<double>(connectorProbesStart - nodeProbesStart) / (nodeTypes.size() * repetitionsCount)
+              << ", \"connector_probes_per_lookup\": "
+              << static_cast<double>(probesEnd - connectorProbesStart) / (connectorTypes.size() * repetitionsCount);
+  }
+  std::cout << ", \"stages\": {";
+  GWFBench::WriteFigures(std::cout, "node_types", nodeStats.m_total, repetitionsCount, nodeTypes.size(), 0);
+  std::cout << ", ";
+  GWFBench::WriteFigures(
+      std::cout, "connector_types", connectorStats.m_total, repetitionsCount, connectorTypes.size(), 0);
+  std::cout << "}}" << std::endl;
+}
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  std::size_t const repetitionsCount = argc > 1 ? std::max<std::size_t>(std::stoul(argv[1]), 1) : 20;
+
+  GWFBench::EnableCounters();
+
+  std::vector<Distribution> distributions = GetDistributions();
+  if (argc > 2)
+    distributions.push_back(CaptureDistribution(std::vector<std::string>(argv + 2, argv + argc)));
+
+  for (Distribution const & distribution : distributions)
+    RunDistribution(distribution, repetitionsCount);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,193 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+/*
+ * SCs writer throughput without XML. Graphs of several shapes and sizes are built as SCg-elements in memory, and the
+ * writer is measured as a whole and by its building blocks, each called once per element. A line of JSON is written
+ * per graph:
+ *
+ *   gwf_writer_bench [largest number of nodes, 100000 by default] [repetitions, 5 by default]
+ *
+ * Shapes:
+ *   flat       - nodes, links and pairs without contours;
+ *   contoured  - most elements are in contours nested 8 levels deep;
+ *   connectors - four connectors per node, long chains of arcs to arcs included.
+ *
+ * Stages:
+ *   identifiers - SCsWriter::IdentifierIndex, which names elements and resolves collisions of names;
+ *   corrector   - SCsWriter::SCgIdentifierCorrector::GenerateSCsIdentifier into strings, which are reused;
+ *   write       - SCsWriter::Write, rates of bytes are of the SCs text;
+ *   append      - Buffer appends of an element id and a separator;
+ *   add_tabs    - Buffer::AddTabs with depths of 0 to 7;
+ *   make_alias  - SCsWriter::MakeAlias of an element id.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "gwf_bench.hpp"
+#include "gwf_generator.hpp"
+#include "sc_scg_element.hpp"
+#include "sc_scs_writer.hpp"
+
+namespace
+{
+std::vector<std::string> const SHAPES = {"flat", "contoured", "connectors"};
+
+GWFGenerator::Params MakeParams(std::string const & shape, std::size_t nodesCount)
+{
+  GWFGenerator::Params params;
+  params.m_seed = nodesCount;
+  params.m_nodesCount = nodesCount;
+  params.m_stringLinksCount = nodesCount / 10;
+  params.m_numericLinksCount = nodesCount / 20;
+  params.m_pairsCount = nodesCount;
+
+  if (shape == "contoured")
+  {
+    params.m_rootContoursCount = std::max<std::size_t>(nodesCount / 2000, 1);
+    params.m_contourDepth = 8;
+    params.m_contourFanOut = 2;
+    params.m_contouredElementsPercent = 90;
+  }
+  else if (shape == "connectors")
+  {
+    params.m_pairsCount = 2 * nodesCount;
+    params.m_arcsCount = nodesCount;
+    params.m_attributeChainsCount = nodesCount / 10;
+    params.m_attributeChainLength = 10;
+    params.m_hubsCount = std::max<std::size_t>(nodesCount / 1000, 1);
+    params.m_hubConnectorsPercent = 10;
+  }
+  return params;
+}
+
+// All elements and their ids, those in contours included
+void CollectIds(SCgElements const & elements, std::vector<std::string> & ids, std::vector<SCgElementPtr> & allElements)
+{
+  for (auto const & [id, element] : elements)
+  {
+    ids.emplace_back(id);
+    allElements.push_back(element);
+    if (auto const & contour = std::dynamic_pointer_cast<SCgContour>(element))
+      CollectIds(contour->GetElements(), ids, allElements);
+  }
+}
+
+void RunGraph(std::string const & shape, std::size_t nodesCount, std::size_t repetitionsCount)
+{
+  SCgElements elementsWithoutParents;
+  GWFGenerator::Generate(MakeParams(shape, nodesCount), elementsWithoutParents);
+
+  std::vector<std::string> ids;
+  std::vector<SCgElementPtr> allElements;
+  CollectIds(elementsWithoutParents, ids, allElements);
+
+  // Every stage is measured as a whole translation of its own stats
+  GWFTranslatorStats identifiersStats;
+  GWFTranslatorStats correctorStats;
+  GWFTranslatorStats writeStats;
+  GWFTranslatorStats appendStats;
+  GWFTranslatorStats addTabsStats;
+  GWFTranslatorStats makeAliasStats;
+  std::size_t outputBytes = 0;
+  std::size_t appendedBytes = 0;
+  for (std::size_t i = 0; i < repetitionsCount; ++i)
+  {
+    std::optional<SCsWriter::IdentifierIndex> identifiers;
+    {
+      GWFTranslatorStats::ScopedMeasurement const measurement(&identifiersStats);
+      identifiers.emplace(elementsWithoutParents);
+    }
+
+    // Sizes of identifiers are checked, so that making them isn't optimized away
+    std::pmr::string systemIdentifier;
+    std::pmr::string mainIdentifier;
+    std::size_t identifiersSize = 0;
+    {
+      GWFTranslatorStats::ScopedMeasurement const measurement(&correctorStats);
+      for (SCgElementPtr const & element : allElements)
+      {
+        SCsWriter::SCgIdentifierCorrector::GenerateSCsIdentifier(*element, systemIdentifier, mainIdentifier);
+        identifiersSize += systemIdentifier.size();
+      }
+    }
+    if (identifiersSize == 0)
+      std::cerr << "No identifiers have been made.\n";
+
+    Buffer scsBuffer;
+    SCgElementsSet writtenElements;
+    {
+      GWFTranslatorStats::ScopedMeasurement const measurement(&writeStats);
+      SCsWriter::Write(elementsWithoutParents, "bench.gwf", scsBuffer, 0, writtenElements, *identifiers);
+    }
+    outputBytes = scsBuffer.GetSize();
+
+    Buffer buffer;
+    buffer.Reserve(outputBytes);
+    {
+      GWFTranslatorStats::ScopedMeasurement const measurement(&appendStats);
+      for (std::string const & id : ids)
+        buffer << id << ";\n";
+    }
+    appendedBytes = buffer.GetSize();
+
+    buffer.Clear();
+    {
+      GWFTranslatorStats::ScopedMeasurement const measurement(&addTabsStats);
+      for (std::size_t j = 0; j < ids.size(); ++j)
+        buffer.AddTabs(j % 8);
+    }
+
+    // Sizes of aliases are checked, so that making them isn't optimized away
+    std::size_t aliasesSize = 0;
+    {
+      GWFTranslatorStats::ScopedMeasurement const measurement(&makeAliasStats);
+      for (std::string const & id : ids)
+        aliasesSize += SCsWriter::MakeAlias("element", id).size();
+    }
+    if (aliasesSize == 0)
+      std::cerr << "No aliases have been made.\n";
+  }
+
+  std::cout << "{\"shape\": \"" << shape << "\", \"nodes\": " << nodesCount << ", \"elements\": " << ids.size()
+            << ", \"scs_bytes\": " << outputBytes << ", \"repetitions\": " << repetitionsCount
+            << ", \"allocations_kind\": \"" << GWFBench::GetAllocationsKind() << "\", \"stages\": {";
+  GWFBench::WriteFigures(std::cout, "identifiers", identifiersStats.m_total, repetitionsCount, ids.size(), 0);
+  std::cout << ", ";
+  GWFBench::WriteFigures(std::cout, "corrector", correctorStats.m_total, repetitionsCount, ids.size(), 0);
+  std::cout << ", ";
+  GWFBench::WriteFigures(std::cout, "write", writeStats.m_total, repetitionsCount, ids.size(), outputBytes);
+  std::cout << ", ";
+  GWFBench::WriteFigures(std::cout, "append", appendStats.m_total, repetitionsCount, ids.size(), appendedBytes);
+  std::cout << ", ";
+  GWFBench::WriteFigures(std::cout, "add_tabs", addTabsStats.m_total, repetitionsCount, ids.size(), 0);
+  std::cout << ", ";
+  GWFBench::WriteFigures(std::cout, "make_alias", makeAliasStats.m_total, repetitionsCount, ids.size(), 0);
+  std::cout << "}}" << std::endl;
+}
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  std::size_t const maxNodesCount = argc > 1 ? std::stoul(argv[1]) : 100000;
+  std::size_t const repetitionsCount = argc > 2 ? std::max<std::size_t>(std::stoul(argv[2]), 1) : 5;
+
+  GWFBench::EnableCounters();
+
+  for (std::string const & shape : SHAPES)
+  {
+    for (std::size_t nodesCount = 1000; nodesCount <= maxNodesCount; nodesCount *= 10)
+      RunGraph(shape, nodesCount, repetitionsCount);
+  }
+
+  return EXIT_SUCCESS;
+}
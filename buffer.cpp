@@ -6,27 +6,125 @@
 
 #include "buffer.hpp"
 
+#include <algorithm>
+
+#include "gwf_hot_path_counters.hpp"
 #include "gwf_translator_constants.hpp"
 
+namespace
+{
+// Budget is reserved in steps, and a chunk smaller than a step isn't spilled even if the budget is exhausted, so that
+// a buffer doesn't write a file per append. Spill files don't take budgets smaller than a step.
+std::size_t const SPILL_STEP_SIZE = GWFSpillFile::GetMinMemoryBudget();
+}  // namespace
+
 Buffer::Buffer()
+  : Buffer(nullptr)
+{
+}
+
+Buffer::Buffer(GWFSpillFile * spillFile)
   : m_value("")
+  , m_spillFile(spillFile)
+  , m_reservedBytes(0)
+  , m_spilledBytes(0)
+{
+}
+
+Buffer & Buffer::operator<<(std::string_view string)
 {
+  GWF_COUNT_HOT_PATH(BufferAppends);
+  m_value += string;
+  SpillIfOverBudget();
+  return *this;
 }
 
-Buffer & Buffer::operator<<(std::string const & string)
+Buffer & Buffer::Append(char const * data, std::size_t size)
 {
-  m_value << string;
+  GWF_COUNT_HOT_PATH(BufferAppends);
+  m_value.append(data, size);
+  SpillIfOverBudget();
   return *this;
 }
 
 Buffer & Buffer::AddTabs(std::size_t const & count)
 {
-  std::string tabs(count * 4, Constants::SPACE[0]);
-  m_value << tabs;
+  GWF_COUNT_HOT_PATH(BufferAppends);
+  m_value.append(count * 4, Constants::SPACE[0]);
+  SpillIfOverBudget();
   return *this;
 }
 
 std::string Buffer::GetValue() const
 {
-  return m_value.str();
+  if (m_spilledChunks.empty())
+    return m_value;
+
+  std::string value;
+  value.reserve(GetSize());
+  for (auto const & chunk : m_spilledChunks)
+    m_spillFile->Read(
+        chunk,
+        [&value](char const * data, std::size_t size)
+        {
+          value.append(data, size);
+        });
+  value += m_value;
+  return value;
+}
+
+void Buffer::WriteTo(std::ostream & stream) const
+{
+  for (auto const & chunk : m_spilledChunks)
+    m_spillFile->Read(
+        chunk,
+        [&stream](char const * data, std::size_t size)
+        {
+          stream.write(data, static_cast<std::streamsize>(size));
+        });
+  stream << m_value;
+}
+
+std::size_t Buffer::GetSize() const
+{
+  return m_spilledBytes + m_value.size();
+}
+
+std::size_t Buffer::GetCapacity() const
+{
+  return m_value.capacity();
+}
+
+void Buffer::Reserve(std::size_t size)
+{
+  m_value.reserve(size);
+}
+
+// Keeps the allocated capacity, so a reused buffer doesn't allocate again for outputs of the same size
+void Buffer::Clear()
+{
+  m_value.clear();
+  m_spilledBytes = 0;
+  m_spilledChunks.clear();
+}
+
+// The reserved budget isn't released after a spill: the value keeps its capacity and fills it again
+void Buffer::SpillIfOverBudget()
+{
+  if (m_spillFile == nullptr || m_value.size() <= m_reservedBytes)
+    return;
+
+  std::size_t const step = std::max(m_value.size() - m_reservedBytes, SPILL_STEP_SIZE);
+  if (m_spillFile->TryReserve(step))
+  {
+    m_reservedBytes += step;
+    return;
+  }
+
+  if (m_value.size() < SPILL_STEP_SIZE)
+    return;
+
+  m_spilledChunks.push_back(m_spillFile->Write(m_value.data(), m_value.size()));
+  m_spilledBytes += m_value.size();
+  m_value.clear();
 }
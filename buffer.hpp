@@ -6,18 +6,40 @@
 
 #pragma once
 
-#include <sstream>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "gwf_spill_file.hpp"
 
 class Buffer
 {
 public:
   Buffer();
+  // Counts its value against the memory budget of the spill file and spills finished chunks to it once the budget is
+  // exhausted
+  explicit Buffer(GWFSpillFile * spillFile);
 
-  Buffer & operator<<(std::string const & string);
+  Buffer & operator<<(std::string_view string);
+  Buffer & Append(char const * data, std::size_t size);
   Buffer & AddTabs(std::size_t const & count);
 
   std::string GetValue() const;
+  // Writes spilled chunks and the rest of the value without loading them into memory at once
+  void WriteTo(std::ostream & stream) const;
+  std::size_t GetSize() const;
+  std::size_t GetCapacity() const;
+
+  void Reserve(std::size_t size);
+  void Clear();
 
 private:
-  std::stringstream m_value;
+  std::string m_value;
+  GWFSpillFile * m_spillFile;
+  std::size_t m_reservedBytes;
+  std::size_t m_spilledBytes;
+  std::vector<GWFSpillFile::Range> m_spilledChunks;
+
+  void SpillIfOverBudget();
 };
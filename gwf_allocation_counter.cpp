@@ -0,0 +1,301 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "gwf_allocation_counter.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+#include <malloc.h>
+
+#include <libxml/xmlmemory.h>
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#  define GWF_TRANSLATOR_HAS_MALLINFO2
+#endif
+
+namespace
+{
+// Only the owning thread writes its counters, so updates don't need atomic read-modify-write operations; counters are
+// atomic so that sums can be read from other threads
+struct alignas(64) ThreadCounters
+{
+  std::atomic<std::size_t> m_allocatedBytes{0};
+  std::atomic<std::size_t> m_allocationsCount{0};
+  // Bytes the thread allocated minus bytes it freed, negative if it frees blocks of other threads
+  std::atomic<int64_t> m_liveBytes{0};
+  std::atomic<int64_t> m_peakLiveBytes{0};
+  ThreadCounters * m_next = nullptr;
+};
+
+std::mutex threadCountersMutex;
+// Counters of finished threads are kept, so they are summed too. The registry is a list rather than a container, so
+// that registering a thread doesn't allocate through the operator new it counts.
+ThreadCounters * threadCounters = nullptr;
+
+ThreadCounters & GetThreadCounters()
+{
+  thread_local ThreadCounters * counters = nullptr;
+  if (counters == nullptr)
+  {
+    // Counters may be needed first in operator delete, which can't throw
+    void * memory = std::aligned_alloc(alignof(ThreadCounters), sizeof(ThreadCounters));
+    if (memory == nullptr)
+      std::abort();
+
+    counters = new (memory) ThreadCounters();
+    std::lock_guard<std::mutex> lock(threadCountersMutex);
+    counters->m_next = threadCounters;
+    threadCounters = counters;
+  }
+  return *counters;
+}
+
+#if defined(GWF_TRANSLATOR_COUNT_ALLOCATIONS)
+// Every counted block starts with its size, so that deallocation can account it
+struct alignas(std::max_align_t) BlockHeader
+{
+  std::size_t m_size;
+};
+
+void * CountedAllocate(std::size_t size)
+{
+  auto * header = static_cast<BlockHeader *>(std::malloc(sizeof(BlockHeader) + size));
+  if (header == nullptr)
+    return nullptr;
+
+  header->m_size = size;
+  GWFAllocationCounter::OnAllocate(size);
+  return header + 1;
+}
+
+// Over-aligned blocks are preceded by as many bytes as their alignment, or a header if it's larger, so that the header
+// stays right before the block and the start of the allocation can be found from the alignment
+std::size_t GetAlignedOffset(std::size_t alignment)
+{
+  return std::max(alignment, sizeof(BlockHeader));
+}
+
+void * CountedAlignedAllocate(std::size_t size, std::size_t alignment)
+{
+  std::size_t const offset = GetAlignedOffset(alignment);
+  // aligned_alloc takes only sizes that are multiples of the alignment
+  std::size_t const allocatedSize = (offset + size + alignment - 1) / alignment * alignment;
+  auto * start = static_cast<char *>(std::aligned_alloc(alignment, allocatedSize));
+  if (start == nullptr)
+    return nullptr;
+
+  auto * header = reinterpret_cast<BlockHeader *>(start + offset) - 1;
+  header->m_size = size;
+  GWFAllocationCounter::OnAllocate(size);
+  return start + offset;
+}
+
+void CountedAlignedFree(void * pointer, std::size_t alignment)
+{
+  if (pointer == nullptr)
+    return;
+
+  auto * header = static_cast<BlockHeader *>(pointer) - 1;
+  GWFAllocationCounter::OnDeallocate(header->m_size);
+  std::free(static_cast<char *>(pointer) - GetAlignedOffset(alignment));
+}
+
+void CountedFree(void * pointer)
+{
+  if (pointer == nullptr)
+    return;
+
+  auto * header = static_cast<BlockHeader *>(pointer) - 1;
+  GWFAllocationCounter::OnDeallocate(header->m_size);
+  std::free(header);
+}
+
+void * CountedReallocate(void * pointer, std::size_t size)
+{
+  if (pointer == nullptr)
+    return CountedAllocate(size);
+
+  auto * header = static_cast<BlockHeader *>(pointer) - 1;
+  std::size_t const oldSize = header->m_size;
+  auto * newHeader = static_cast<BlockHeader *>(std::realloc(header, sizeof(BlockHeader) + size));
+  if (newHeader == nullptr)
+    return nullptr;
+
+  newHeader->m_size = size;
+  GWFAllocationCounter::OnDeallocate(oldSize);
+  GWFAllocationCounter::OnAllocate(size);
+  return newHeader + 1;
+}
+
+char * CountedStrdup(char const * string)
+{
+  std::size_t const size = std::strlen(string) + 1;
+  auto * copy = static_cast<char *>(CountedAllocate(size));
+  if (copy != nullptr)
+    std::memcpy(copy, string, size);
+  return copy;
+}
+
+// libxml2 must allocate through the counter before it allocates anything, so it is set up during static initialization
+int const xmlMemorySetupResult = xmlMemSetup(CountedFree, CountedAllocate, CountedReallocate, CountedStrdup);
+#endif
+}  // namespace
+
+#if defined(GWF_TRANSLATOR_COUNT_ALLOCATIONS)
+void * operator new(std::size_t size)
+{
+  void * pointer = CountedAllocate(size);
+  if (pointer == nullptr)
+    throw std::bad_alloc();
+  return pointer;
+}
+
+void * operator new[](std::size_t size)
+{
+  return operator new(size);
+}
+
+void operator delete(void * pointer) noexcept
+{
+  CountedFree(pointer);
+}
+
+void operator delete[](void * pointer) noexcept
+{
+  CountedFree(pointer);
+}
+
+void operator delete(void * pointer, std::size_t) noexcept
+{
+  CountedFree(pointer);
+}
+
+void operator delete[](void * pointer, std::size_t) noexcept
+{
+  CountedFree(pointer);
+}
+
+void * operator new(std::size_t size, std::align_val_t alignment)
+{
+  void * pointer = CountedAlignedAllocate(size, static_cast<std::size_t>(alignment));
+  if (pointer == nullptr)
+    throw std::bad_alloc();
+  return pointer;
+}
+
+void * operator new[](std::size_t size, std::align_val_t alignment)
+{
+  return operator new(size, alignment);
+}
+
+void operator delete(void * pointer, std::align_val_t alignment) noexcept
+{
+  CountedAlignedFree(pointer, static_cast<std::size_t>(alignment));
+}
+
+void operator delete[](void * pointer, std::align_val_t alignment) noexcept
+{
+  CountedAlignedFree(pointer, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void * pointer, std::size_t, std::align_val_t alignment) noexcept
+{
+  CountedAlignedFree(pointer, static_cast<std::size_t>(alignment));
+}
+
+void operator delete[](void * pointer, std::size_t, std::align_val_t alignment) noexcept
+{
+  CountedAlignedFree(pointer, static_cast<std::size_t>(alignment));
+}
+#endif
+
+bool GWFAllocationCounter::IsExact()
+{
+#if defined(GWF_TRANSLATOR_COUNT_ALLOCATIONS)
+  return true;
+#else
+  return false;
+#endif
+}
+
+GWFAllocationCounter::Snapshot GWFAllocationCounter::TakeSnapshot()
+{
+  Snapshot snapshot;
+#if defined(GWF_TRANSLATOR_COUNT_ALLOCATIONS)
+  int64_t liveBytes = 0;
+  {
+    std::lock_guard<std::mutex> lock(threadCountersMutex);
+    for (ThreadCounters const * counters = threadCounters; counters != nullptr; counters = counters->m_next)
+    {
+      snapshot.m_allocatedBytes += counters->m_allocatedBytes.load(std::memory_order_relaxed);
+      snapshot.m_allocationsCount += counters->m_allocationsCount.load(std::memory_order_relaxed);
+      liveBytes += counters->m_liveBytes.load(std::memory_order_relaxed);
+    }
+  }
+  snapshot.m_liveBytes = static_cast<std::size_t>(std::max<int64_t>(liveBytes, 0));
+#elif defined(GWF_TRANSLATOR_HAS_MALLINFO2)
+  struct mallinfo2 const info = mallinfo2();
+  snapshot.m_liveBytes = info.uordblks + info.hblkhd;
+#endif
+  return snapshot;
+}
+
+// Live bytes of the process now, plus as many bytes as the calling thread has freed since its peak
+std::size_t GWFAllocationCounter::GetPeakLiveBytes()
+{
+  std::size_t const liveBytes = TakeSnapshot().m_liveBytes;
+  if (!IsExact())
+    return liveBytes;
+
+  ThreadCounters const & counters = GetThreadCounters();
+  int64_t const freedSincePeak = counters.m_peakLiveBytes.load(std::memory_order_relaxed)
+                                 - counters.m_liveBytes.load(std::memory_order_relaxed);
+  return liveBytes + static_cast<std::size_t>(std::max<int64_t>(freedSincePeak, 0));
+}
+
+// Nested measurements reset the peak at their start and restore the maximum of both peaks at their end, so the peak of
+// an enclosing measurement isn't lost
+int64_t GWFAllocationCounter::ResetPeakLiveBytes()
+{
+  ThreadCounters & counters = GetThreadCounters();
+  int64_t const peak = counters.m_peakLiveBytes.load(std::memory_order_relaxed);
+  counters.m_peakLiveBytes.store(counters.m_liveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+  return peak;
+}
+
+void GWFAllocationCounter::RestorePeakLiveBytes(int64_t peak)
+{
+  ThreadCounters & counters = GetThreadCounters();
+  if (counters.m_peakLiveBytes.load(std::memory_order_relaxed) < peak)
+    counters.m_peakLiveBytes.store(peak, std::memory_order_relaxed);
+}
+
+void GWFAllocationCounter::OnAllocate(std::size_t size)
+{
+  ThreadCounters & counters = GetThreadCounters();
+  counters.m_allocatedBytes.store(
+      counters.m_allocatedBytes.load(std::memory_order_relaxed) + size, std::memory_order_relaxed);
+  counters.m_allocationsCount.store(
+      counters.m_allocationsCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+  int64_t const liveBytes = counters.m_liveBytes.load(std::memory_order_relaxed) + static_cast<int64_t>(size);
+  counters.m_liveBytes.store(liveBytes, std::memory_order_relaxed);
+  if (counters.m_peakLiveBytes.load(std::memory_order_relaxed) < liveBytes)
+    counters.m_peakLiveBytes.store(liveBytes, std::memory_order_relaxed);
+}
+
+void GWFAllocationCounter::OnDeallocate(std::size_t size)
+{
+  ThreadCounters & counters = GetThreadCounters();
+  counters.m_liveBytes.store(
+      counters.m_liveBytes.load(std::memory_order_relaxed) - static_cast<int64_t>(size), std::memory_order_relaxed);
+}
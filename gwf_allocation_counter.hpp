@@ -0,0 +1,44 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/*!
+ * Accounts heap memory used by translations.
+ *
+ * In builds with GWF_TRANSLATOR_COUNT_ALLOCATIONS defined the global operator new/delete, aligned ones included, and
+ * the libxml2 allocator are replaced with counting ones, so figures are exact. Every thread counts into its own cache
+ * line, so allocating threads don't contend, and snapshots are sums of all threads, finished ones included. Otherwise
+ * figures are derived from mallinfo2 deltas where glibc provides it: live bytes are exact, allocated bytes are growth
+ * of live bytes and allocations count is unknown.
+ */
+class GWFAllocationCounter
+{
+public:
+  struct Snapshot
+  {
+    std::size_t m_allocatedBytes = 0;
+    std::size_t m_allocationsCount = 0;
+    std::size_t m_liveBytes = 0;
+  };
+
+  static bool IsExact();
+
+  static Snapshot TakeSnapshot();
+
+  // High-water mark of live bytes since the last reset of the calling thread, as far as its own allocations raised
+  // them. It is tracked only in exact builds, otherwise it is the current number of live bytes.
+  static std::size_t GetPeakLiveBytes();
+  // Peaks that are reset and restored are of the calling thread
+  static int64_t ResetPeakLiveBytes();
+  static void RestorePeakLiveBytes(int64_t peakLiveBytes);
+
+  static void OnAllocate(std::size_t size);
+  static void OnDeallocate(std::size_t size);
+};
@@ -0,0 +1,113 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "gwf_arena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+namespace
+{
+std::size_t const MIN_CHUNK_SIZE = 64 * 1024;
+}  // namespace
+
+GWFArena::GWFArena()
+  : m_currentChunk(0)
+  , m_offset(0)
+{
+}
+
+GWFArena::~GWFArena()
+{
+  for (auto const & chunk : m_chunks)
+    FreeChunk(chunk);
+}
+
+// If the last run has taken several chunks, they are merged into one as large as all of them, so that the next run
+// of the same size fits into a single chunk
+void GWFArena::Reset()
+{
+  if (m_currentChunk > 0)
+  {
+    std::size_t const capacity = GetCapacity();
+    for (auto const & chunk : m_chunks)
+      FreeChunk(chunk);
+    m_chunks.clear();
+    m_chunks.push_back(AllocateChunk(capacity));
+  }
+
+  m_currentChunk = 0;
+  m_offset = 0;
+}
+
+bool GWFArena::Contains(void const * pointer) const
+{
+  auto const address = reinterpret_cast<std::uintptr_t>(pointer);
+  for (std::size_t i = 0; i < m_chunks.size() && i <= m_currentChunk; ++i)
+  {
+    auto const begin = reinterpret_cast<std::uintptr_t>(m_chunks[i].m_data);
+    if (address >= begin && address < begin + m_chunks[i].m_size)
+      return true;
+  }
+
+  return false;
+}
+
+std::size_t GWFArena::GetCapacity() const
+{
+  std::size_t capacity = 0;
+  for (auto const & chunk : m_chunks)
+    capacity += chunk.m_size;
+  return capacity;
+}
+
+void * GWFArena::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+  while (m_currentChunk < m_chunks.size())
+  {
+    Chunk const & chunk = m_chunks[m_currentChunk];
+    auto const begin = reinterpret_cast<std::uintptr_t>(chunk.m_data);
+    std::size_t const offset = ((begin + m_offset + alignment - 1) & ~(alignment - 1)) - begin;
+    if (offset + bytes <= chunk.m_size)
+    {
+      m_offset = offset + bytes;
+      return chunk.m_data + offset;
+    }
+
+    if (m_currentChunk + 1 == m_chunks.size())
+      break;
+    ++m_currentChunk;
+    m_offset = 0;
+  }
+
+  // Chunks are aligned for any fundamental type, larger alignments are taken into account in their sizes
+  std::size_t const size =
+      std::max({bytes + alignment, MIN_CHUNK_SIZE, m_chunks.empty() ? 0 : m_chunks.back().m_size * 2});
+  m_chunks.push_back(AllocateChunk(size));
+  m_currentChunk = m_chunks.size() - 1;
+  m_offset = 0;
+  return do_allocate(bytes, alignment);
+}
+
+void GWFArena::do_deallocate(void *, std::size_t, std::size_t)
+{
+}
+
+GWFArena::Chunk GWFArena::AllocateChunk(std::size_t size)
+{
+  return {static_cast<char *>(::operator new(size)), size};
+}
+
+void GWFArena::FreeChunk(Chunk const & chunk)
+{
+  ::operator delete(chunk.m_data);
+}
+
+bool GWFArena::do_is_equal(std::pmr::memory_resource const & other) const noexcept
+{
+  return this == &other;
+}
@@ -0,0 +1,57 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+/*!
+ * Monotonic memory resource that keeps its chunks when it's reset.
+ *
+ * Deallocation does nothing, memory is reclaimed at once by Reset. Unlike std::pmr::monotonic_buffer_resource, Reset
+ * doesn't return chunks to the heap: after the first translations the arena has grown to the size they need, and
+ * translations of similar size don't allocate chunks anymore.
+ */
+class GWFArena : public std::pmr::memory_resource
+{
+public:
+  GWFArena();
+  ~GWFArena() override;
+
+  GWFArena(GWFArena const &) = delete;
+  GWFArena & operator=(GWFArena const &) = delete;
+
+  // Everything allocated from the arena must be destroyed before it's reset
+  void Reset();
+
+  // Whether memory belongs to a chunk in use. Takes no locks, chunks are only read by the thread that uses the arena.
+  bool Contains(void const * pointer) const;
+
+  // Bytes of all chunks
+  std::size_t GetCapacity() const;
+
+protected:
+  void * do_allocate(std::size_t bytes, std::size_t alignment) override;
+  void do_deallocate(void * pointer, std::size_t bytes, std::size_t alignment) override;
+  bool do_is_equal(std::pmr::memory_resource const & other) const noexcept override;
+
+private:
+  struct Chunk
+  {
+    char * m_data;
+    std::size_t m_size;
+  };
+
+  std::vector<Chunk> m_chunks;
+  // Chunk that allocations are taken from and offset of its free space
+  std::size_t m_currentChunk;
+  std::size_t m_offset;
+
+  static Chunk AllocateChunk(std::size_t size);
+  static void FreeChunk(Chunk const & chunk);
+};
@@ -0,0 +1,332 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "gwf_base64_decoder.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#include <sc-memory/sc_debug.hpp>
+
+#if defined(__x86_64__) || defined(__i386__)
+#  include <immintrin.h>
+#  define GWF_BASE64_X86
+#elif defined(__aarch64__)
+#  include <arm_neon.h>
+#  define GWF_BASE64_NEON
+#endif
+
+namespace
+{
+uint8_t const WHITESPACE = 0x80;
+uint8_t const PADDING = 0x81;
+uint8_t const INVALID = 0xFF;
+
+// The scalar loop gives characters back to vector loops after this many of them, even if it met no whitespace
+std::size_t const SCALAR_RUN_SIZE = 64;
+
+std::array<uint8_t, 256> MakeDecodingTable()
+{
+  std::array<uint8_t, 256> table;
+  table.fill(INVALID);
+
+  char const * alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  for (uint8_t i = 0; i < 64; ++i)
+    table[static_cast<uint8_t>(alphabet[i])] = i;
+  for (char c : {' ', '\t', '\n', '\r', '\f', '\v'})
+    table[static_cast<uint8_t>(c)] = WHITESPACE;
+  table['='] = PADDING;
+
+  return table;
+}
+
+std::array<uint8_t, 256> const DECODING_TABLE = MakeDecodingTable();
+
+/*
+ * Vector loops decode blocks of characters of the alphabet and stop at the first block with any other character,
+ * returning its beginning. Characters are translated to sextets by lookups of their nibbles: a character is valid if
+ * the classes of its low and high nibbles don't intersect, and a sextet is the character plus an offset of the range
+ * of its high nibble, `/` aside. Four sextets are then merged into three bytes by multiply-adds.
+ */
+using DecodeBlocksFunction = char const * (*)(char const * data, char const * end, char *& destination);
+
+#if defined(GWF_BASE64_X86)
+
+__attribute__((target("avx2"))) char const * DecodeBlocksAVX2(char const * data, char const * end, char *& destination)
+{
+  __m256i const lowNibbleClasses = _mm256_setr_epi8(
+      0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+      0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+  __m256i const highNibbleClasses = _mm256_setr_epi8(
+      0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+      0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+  __m256i const offsets = _mm256_setr_epi8(
+      0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+      0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+  __m256i const slashes = _mm256_set1_epi8(0x2F);
+  __m256i const sextetWeights = _mm256_set1_epi32(0x01400140);
+  __m256i const pairWeights = _mm256_set1_epi32(0x00011000);
+  __m256i const laneBytesOrder = _mm256_setr_epi8(
+      2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+      2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+  __m256i const lanesOrder = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+
+  for (; end - data >= 32; data += 32, destination += 24)
+  {
+    __m256i const characters = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(data));
+    // Masking with 0x2F keeps the nibble, the bit 5 is ignored by shuffles
+    __m256i const highNibbles = _mm256_and_si256(_mm256_srli_epi32(characters, 4), slashes);
+    __m256i const lowNibbles = _mm256_and_si256(characters, slashes);
+    if (!_mm256_testz_si256(
+            _mm256_shuffle_epi8(lowNibbleClasses, lowNibbles), _mm256_shuffle_epi8(highNibbleClasses, highNibbles)))
+      break;
+
+    __m256i const offsetIndices = _mm256_add_epi8(_mm256_cmpeq_epi8(characters, slashes), highNibbles);
+    __m256i const sextets = _mm256_add_epi8(characters, _mm256_shuffle_epi8(offsets, offsetIndices));
+    __m256i const groups = _mm256_madd_epi16(_mm256_maddubs_epi16(sextets, sextetWeights), pairWeights);
+    __m256i const bytes =
+        _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(groups, laneBytesOrder), lanesOrder);
+
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(destination), _mm256_castsi256_si128(bytes));
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(destination + 16), _mm256_extracti128_si256(bytes, 1));
+  }
+
+  return data;
+}
+
+__attribute__((target("sse4.1"))) char const * DecodeBlocksSSE41(
+    char const * data,
+    char const * end,
+    char *& destination)
+{
+  __m128i const lowNibbleClasses =
+      _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+  __m128i const highNibbleClasses =
+      _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+  __m128i const offsets = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+  __m128i const slashes = _mm_set1_epi8(0x2F);
+  __m128i const sextetWeights = _mm_set1_epi32(0x01400140);
+  __m128i const pairWeights = _mm_set1_epi32(0x00011000);
+  __m128i const bytesOrder = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+  for (; end - data >= 16; data += 16, destination += 12)
+  {
+    __m128i const characters = _mm_loadu_si128(reinterpret_cast<__m128i const *>(data));
+    __m128i const highNibbles = _mm_and_si128(_mm_srli_epi32(characters, 4), slashes);
+    __m128i const lowNibbles = _mm_and_si128(characters, slashes);
+    __m128i const lowClasses = _mm_shuffle_epi8(lowNibbleClasses, lowNibbles);
+    if (!_mm_testz_si128(lowClasses, _mm_shuffle_epi8(highNibbleClasses, highNibbles)))
+      break;
+
+    __m128i const offsetIndices = _mm_add_epi8(_mm_cmpeq_epi8(characters, slashes), highNibbles);
+    __m128i const sextets = _mm_add_epi8(characters, _mm_shuffle_epi8(offsets, offsetIndices));
+    __m128i const groups = _mm_madd_epi16(_mm_maddubs_epi16(sextets, sextetWeights), pairWeights);
+    __m128i const bytes = _mm_shuffle_epi8(groups, bytesOrder);
+
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(destination), bytes);
+    int32_t const lastBytes = _mm_extract_epi32(bytes, 2);
+    std::memcpy(destination + 8, &lastBytes, sizeof(lastBytes));
+  }
+
+  return data;
+}
+
+#elif defined(GWF_BASE64_NEON)
+
+uint8x16_t TranslateToSextets(uint8x16_t characters, uint8x16_t & invalidCharacters)
+{
+  static uint8_t const lowNibbleClasses[16] = {
+      0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A};
+  static uint8_t const highNibbleClasses[16] = {
+      0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10};
+  static uint8_t const offsets[16] = {0, 16, 19, 4, 191, 191, 185, 185, 0, 0, 0, 0, 0, 0, 0, 0};
+
+  uint8x16_t const highNibbles = vshrq_n_u8(characters, 4);
+  uint8x16_t const lowNibbles = vandq_u8(characters, vdupq_n_u8(0x0F));
+  invalidCharacters = vorrq_u8(
+      invalidCharacters,
+      vandq_u8(
+          vqtbl1q_u8(vld1q_u8(lowNibbleClasses), lowNibbles), vqtbl1q_u8(vld1q_u8(highNibbleClasses), highNibbles)));
+
+  uint8x16_t const offsetIndices = vaddq_u8(vceqq_u8(characters, vdupq_n_u8(0x2F)), highNibbles);
+  return vaddq_u8(characters, vqtbl1q_u8(vld1q_u8(offsets), offsetIndices));
+}
+
+// Characters are loaded deinterleaved by their position in a group, so sextets are merged by shifts
+char const * DecodeBlocksNEON(char const * data, char const * end, char *& destination)
+{
+  for (; end - data >= 64; data += 64, destination += 48)
+  {
+    uint8x16x4_t sextets = vld4q_u8(reinterpret_cast<uint8_t const *>(data));
+    uint8x16_t invalidCharacters = vdupq_n_u8(0);
+    for (uint8x16_t & characters : sextets.val)
+      characters = TranslateToSextets(characters, invalidCharacters);
+    if (vmaxvq_u8(invalidCharacters) != 0)
+      break;
+
+    uint8x16x3_t bytes;
+    bytes.val[0] = vorrq_u8(vshlq_n_u8(sextets.val[0], 2), vshrq_n_u8(sextets.val[1], 4));
+    bytes.val[1] = vorrq_u8(vshlq_n_u8(sextets.val[1], 4), vshrq_n_u8(sextets.val[2], 2));
+    bytes.val[2] = vorrq_u8(vshlq_n_u8(sextets.val[2], 6), sextets.val[3]);
+    vst3q_u8(reinterpret_cast<uint8_t *>(destination), bytes);
+  }
+
+  return data;
+}
+
+#endif
+
+struct Implementation
+{
+  char const * m_name;
+  DecodeBlocksFunction m_decodeBlocks;
+};
+
+Implementation SelectImplementation()
+{
+#if defined(GWF_BASE64_X86)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    return {"avx2", DecodeBlocksAVX2};
+  if (__builtin_cpu_supports("sse4.1"))
+    return {"sse4.1", DecodeBlocksSSE41};
+#elif defined(GWF_BASE64_NEON)
+  return {"neon", DecodeBlocksNEON};
+#endif
+  return {"scalar", nullptr};
+}
+
+Implementation const IMPLEMENTATION = SelectImplementation();
+}  // namespace
+
+std::size_t GWFBase64Decoder::GetMaxDecodedSize(std::size_t encodedSize)
+{
+  return (encodedSize + 3) / 4 * 3;
+}
+
+char const * GWFBase64Decoder::GetImplementationName()
+{
+  return IMPLEMENTATION.m_name;
+}
+
+std::size_t GWFBase64Decoder::GetDecodedSize(std::string_view text)
+{
+  std::size_t const sextetsCount = std::count_if(
+      text.cbegin(),
+      text.cend(),
+      [](char c)
+      {
+        return DECODING_TABLE[static_cast<uint8_t>(c)] < 64;
+      });
+  return sextetsCount * 3 / 4;
+}
+
+std::string GWFBase64Decoder::Decode(std::string_view text)
+{
+  std::string bytes(GetMaxDecodedSize(text.size()), '\0');
+
+  GWFBase64Decoder decoder;
+  std::size_t size = decoder.DecodeChunk(text.data(), text.size(), bytes.data());
+  size += decoder.Finish(bytes.data() + size);
+
+  bytes.resize(size);
+  return bytes;
+}
+
+std::size_t GWFBase64Decoder::DecodeChunk(char const * data, std::size_t size, char * destination)
+{
+  char const * end = data + size;
+  char * output = destination;
+
+  while (data != end)
+  {
+    // Vector loops start only on a group boundary
+    if (IMPLEMENTATION.m_decodeBlocks != nullptr && m_groupSize == 0 && m_paddingSize == 0)
+      data = IMPLEMENTATION.m_decodeBlocks(data, end, output);
+
+    output = DecodeScalar(data, end, output);
+  }
+
+  return output - destination;
+}
+
+// Decodes past the whitespace that stopped vector loops, or SCALAR_RUN_SIZE characters, to the next group boundary
+char * GWFBase64Decoder::DecodeScalar(char const *& data, char const * end, char * destination)
+{
+  char const * runEnd = data + std::min<std::size_t>(SCALAR_RUN_SIZE, end - data);
+  bool isWhitespaceSkipped = false;
+
+  for (; data != end; ++data)
+  {
+    uint8_t const value = DECODING_TABLE[static_cast<uint8_t>(*data)];
+    if (value < 64 && m_groupSize == 0 && m_paddingSize == 0 && (isWhitespaceSkipped || data >= runEnd))
+      break;
+
+    if (value == WHITESPACE)
+    {
+      isWhitespaceSkipped = true;
+      continue;
+    }
+
+    if (value == PADDING)
+    {
+      // Padding completes a group of 2 or 3 characters, bytes of the group are written by the first `=`
+      if (m_groupSize < 2 || m_groupSize + m_paddingSize == 4)
+        SC_THROW_EXCEPTION(utils::ExceptionParseError, "GWFBase64Decoder: Unexpected padding in base64 content.");
+      if (m_paddingSize++ == 0)
+      {
+        *destination++ = static_cast<char>(m_group >> (m_groupSize == 2 ? 4 : 10));
+        if (m_groupSize == 3)
+          *destination++ = static_cast<char>(m_group >> 2);
+      }
+      continue;
+    }
+
+    if (value == INVALID)
+      SC_THROW_EXCEPTION(
+          utils::ExceptionParseError,
+          "GWFBase64Decoder: Invalid character with code " << static_cast<int>(static_cast<uint8_t>(*data))
+                                                           << " in base64 content.");
+    if (m_paddingSize != 0)
+      SC_THROW_EXCEPTION(utils::ExceptionParseError, "GWFBase64Decoder: Base64 content continues after padding.");
+
+    m_group = (m_group << 6) | value;
+    if (++m_groupSize == 4)
+    {
+      *destination++ = static_cast<char>(m_group >> 16);
+      *destination++ = static_cast<char>(m_group >> 8);
+      *destination++ = static_cast<char>(m_group);
+      m_group = 0;
+      m_groupSize = 0;
+    }
+  }
+
+  return destination;
+}
+
+std::size_t GWFBase64Decoder::Finish(char * destination)
+{
+  std::size_t size = 0;
+  if (m_paddingSize != 0)
+  {
+    if (m_groupSize + m_paddingSize != 4)
+      SC_THROW_EXCEPTION(utils::ExceptionParseError, "GWFBase64Decoder: Base64 content ends with incomplete padding.");
+  }
+  else if (m_groupSize == 1)
+    SC_THROW_EXCEPTION(utils::ExceptionParseError, "GWFBase64Decoder: Base64 content ends with a truncated group.");
+  else if (m_groupSize != 0)
+  {
+    destination[size++] = static_cast<char>(m_group >> (m_groupSize == 2 ? 4 : 10));
+    if (m_groupSize == 3)
+      destination[size++] = static_cast<char>(m_group >> 2);
+  }
+
+  m_group = 0;
+  m_groupSize = 0;
+  m_paddingSize = 0;
+  return size;
+}
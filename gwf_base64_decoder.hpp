@@ -0,0 +1,48 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/*!
+ * Decoder of base64 contents of links.
+ *
+ * Encoded text may come in chunks of any size: characters of an incomplete group are kept until the next chunk.
+ * Whitespace is skipped, any other character outside of the alphabet, misplaced padding or a truncated group throws
+ * utils::ExceptionParseError. Runs of valid characters are decoded with AVX2 or SSE4.1 on x86, chosen by the running
+ * CPU, and with NEON on AArch64; the rest of the text is decoded by a scalar loop.
+ */
+class GWFBase64Decoder
+{
+public:
+  // Maximum number of bytes that decoding of encoded text of this size writes, kept characters included
+  static std::size_t GetMaxDecodedSize(std::size_t encodedSize);
+
+  // Name of the vector instruction set used on this CPU, "scalar" if there is none
+  static char const * GetImplementationName();
+
+  // Size of decoded valid text, which is counted without decoding it
+  static std::size_t GetDecodedSize(std::string_view text);
+
+  static std::string Decode(std::string_view text);
+
+  // Returns the number of bytes written to destination, which must hold GetMaxDecodedSize(size) bytes
+  std::size_t DecodeChunk(char const * data, std::size_t size, char * destination);
+  // Checks that the text ended on a complete group and writes bytes of an unpadded last group, 2 at most
+  std::size_t Finish(char * destination);
+
+private:
+  uint32_t m_group = 0;
+  std::size_t m_groupSize = 0;
+  // Number of `=` read, no characters of the alphabet can follow them
+  std::size_t m_paddingSize = 0;
+
+  char * DecodeScalar(char const *& data, char const * end, char * destination);
+};
@@ -0,0 +1,169 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "gwf_batch_translator.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <numeric>
+#include <sstream>
+#include <thread>
+
+#include <libxml/parser.h>
+
+#include "gwf_lock_wait_timer.hpp"
+#include "gwf_tracer.hpp"
+#include "gwf_translation_session.hpp"
+#include "gwf_translator_stats.hpp"
+
+double GWFBatchTranslator::Stats::GetUtilization() const
+{
+  if (m_wallTime <= 0)
+    return 0;
+
+  double cpuTime = 0;
+  for (auto const & worker : m_workers)
+    cpuTime += worker.m_cpuTime;
+  return cpuTime / m_wallTime;
+}
+
+double GWFBatchTranslator::Stats::GetSpeedup(Stats const & baseline) const
+{
+  return m_wallTime <= 0 ? 0 : baseline.m_wallTime / m_wallTime;
+}
+
+double GWFBatchTranslator::Stats::GetEfficiency(Stats const & baseline) const
+{
+  return m_workers.empty() ? 0 : GetSpeedup(baseline) / m_workers.size();
+}
+
+std::string GWFBatchTranslator::Stats::ToJSON(Stats const * baseline) const
+{
+  std::stringstream json;
+  json << "{\"threads\": " << m_workers.size() << ", \"wall_time\": " << m_wallTime
+       << ", \"utilization\": " << GetUtilization();
+  if (baseline != nullptr)
+    json << ", \"speedup\": " << GetSpeedup(*baseline) << ", \"efficiency\": " << GetEfficiency(*baseline);
+  json << ", \"workers\": {";
+
+  for (std::size_t i = 0; i < m_workers.size(); ++i)
+  {
+    auto const & worker = m_workers[i];
+    if (i > 0)
+      json << ", ";
+    // Idle time covers waiting for other workers at the end of the batch
+    json << "\"" << i << "\": {\"busy_time\": " << worker.m_busyTime << ", \"cpu_time\": " << worker.m_cpuTime
+         << ", \"queue_time\": " << worker.m_queueTime << ", \"lock_wait_time\": " << worker.m_lockWaitTime
+         << ", \"idle_time\": " << std::max(m_wallTime - worker.m_busyTime - worker.m_queueTime, 0.0)
+         << ", \"files\": " << worker.m_filesCount << ", \"input_bytes\": " << worker.m_inputBytes << "}";
+  }
+
+  json << "}, \"blobs\": " << m_blobs.ToJSON() << "}";
+  return json.str();
+}
+
+std::vector<GWFBatchTranslator::Result> GWFBatchTranslator::Translate(
+    std::vector<std::string> const & filePaths,
+    std::size_t threadsCount,
+    Stats * stats,
+    GWFBlobStore * blobStore)
+{
+  using Clock = std::chrono::steady_clock;
+
+  if (threadsCount == 0)
+    threadsCount = std::max(std::thread::hardware_concurrency(), 1u);
+  threadsCount = std::min(threadsCount, std::max<std::size_t>(filePaths.size(), 1));
+
+  std::vector<std::size_t> fileSizes(filePaths.size());
+  for (std::size_t i = 0; i < filePaths.size(); ++i)
+  {
+    std::error_code errorCode;
+    std::uintmax_t const size = std::filesystem::file_size(filePaths[i], errorCode);
+    fileSizes[i] = errorCode ? 0 : static_cast<std::size_t>(size);
+  }
+
+  std::vector<std::size_t> queue(filePaths.size());
+  std::iota(queue.begin(), queue.end(), 0);
+  std::stable_sort(
+      queue.begin(),
+      queue.end(),
+      [&](std::size_t left, std::size_t right)
+      {
+        return fileSizes[left] > fileSizes[right];
+      });
+
+  // libxml2 must be initialized before it is used from several threads
+  xmlInitParser();
+
+  std::vector<Result> results(filePaths.size());
+  std::vector<WorkerStats> workers(threadsCount);
+  std::atomic<std::size_t> nextFile{0};
+
+  auto const & work = [&](std::size_t workerId)
+  {
+    GWFTracer::SetThreadName("gwf batch worker " + std::to_string(workerId));
+    WorkerStats & worker = workers[workerId];
+    // Scratch state of translations is kept for the next files of the worker
+    GWFTranslationSession session;
+    session.SetBlobStore(blobStore);
+
+    while (true)
+    {
+      auto const queueStart = Clock::now();
+      std::size_t const position = nextFile.fetch_add(1, std::memory_order_relaxed);
+      auto const translationStart = Clock::now();
+      double const cpuStart = GWFTranslatorStats::GetThreadCPUTime();
+      double const lockWaitStart = GWFLockWaitTimer::GetThreadWaitTime();
+      worker.m_queueTime += std::chrono::duration<double>(translationStart - queueStart).count();
+      if (position >= queue.size())
+        break;
+
+      std::size_t const fileIndex = queue[position];
+      Result & result = results[fileIndex];
+      result.m_filePath = filePaths[fileIndex];
+      try
+      {
+        result.m_scsText = session.Translate(result.m_filePath).GetValue();
+      }
+      catch (std::exception const & exception)
+      {
+        result.m_errorMessage = exception.what();
+      }
+
+      worker.m_cpuTime += GWFTranslatorStats::GetThreadCPUTime() - cpuStart;
+      worker.m_lockWaitTime += GWFLockWaitTimer::GetThreadWaitTime() - lockWaitStart;
+      worker.m_busyTime += std::chrono::duration<double>(Clock::now() - translationStart).count();
+      ++worker.m_filesCount;
+      worker.m_inputBytes += fileSizes[fileIndex];
+    }
+  };
+
+  GWFBlobStore::Stats const blobsStart = blobStore != nullptr ? blobStore->GetStats() : GWFBlobStore::Stats();
+  auto const start = Clock::now();
+  std::vector<std::thread> threads;
+  for (std::size_t i = 0; i < threadsCount; ++i)
+    threads.emplace_back(work, i);
+  for (auto & thread : threads)
+    thread.join();
+
+  if (stats != nullptr)
+  {
+    stats->m_wallTime = std::chrono::duration<double>(Clock::now() - start).count();
+    stats->m_workers = std::move(workers);
+    if (blobStore != nullptr)
+    {
+      GWFBlobStore::Stats const blobs = blobStore->GetStats();
+      stats->m_blobs.m_storedBlobs = blobs.m_storedBlobs - blobsStart.m_storedBlobs;
+      stats->m_blobs.m_storedBytes = blobs.m_storedBytes - blobsStart.m_storedBytes;
+      stats->m_blobs.m_deduplicatedContents = blobs.m_deduplicatedContents - blobsStart.m_deduplicatedContents;
+      stats->m_blobs.m_deduplicatedBytes = blobs.m_deduplicatedBytes - blobsStart.m_deduplicatedBytes;
+    }
+  }
+
+  return results;
+}
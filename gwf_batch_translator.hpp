@@ -0,0 +1,78 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "gwf_blob_store.hpp"
+
+/*!
+ * Translates many gwf-files to SCs texts with a pool of worker threads.
+ *
+ * Workers take files from a shared lock-free queue, largest files first, so that a giant diagram doesn't start last and
+ * leave the other workers idle at the end of a skewed batch. A file that fails to translate doesn't stop the batch, its
+ * error is returned instead of its text.
+ *
+ * Files are the unit of parallelism: a single file is translated by one worker, there is no intra-file parallel mode.
+ */
+class GWFBatchTranslator
+{
+public:
+  struct Result
+  {
+    std::string m_filePath;
+    std::string m_scsText;
+    // Empty if the file has been translated
+    std::string m_errorMessage;
+  };
+
+  // Each worker updates its figures in its own cache line
+  struct alignas(64) WorkerStats
+  {
+    // Seconds spent translating files
+    double m_busyTime = 0;
+    // Seconds of CPU time spent translating files, less than busy time if the worker has been preempted
+    double m_cpuTime = 0;
+    // Seconds spent taking files from the queue. It's an atomic counter, so this stays near zero unless workers
+    // contend for its cache line.
+    double m_queueTime = 0;
+    // Seconds of busy time spent waiting for locks shared with other workers, see GWFLockWaitTimer
+    double m_lockWaitTime = 0;
+    std::size_t m_filesCount = 0;
+    std::size_t m_inputBytes = 0;
+  };
+
+  struct Stats
+  {
+    // Seconds from the start of the first worker to the end of the last one
+    double m_wallTime = 0;
+    std::vector<WorkerStats> m_workers;
+    // Figures of the blob store during the batch, if it's used
+    GWFBlobStore::Stats m_blobs;
+
+    // CPU time of all workers divided by wall time, i.e. the number of cores kept busy on average. It isn't a speedup:
+    // workers that slow each other down keep cores busy as well.
+    double GetUtilization() const;
+    // Wall time of the baseline, a run of the same files in one thread, divided by wall time of this run
+    double GetSpeedup(Stats const & baseline) const;
+    // Speedup per worker
+    double GetEfficiency(Stats const & baseline) const;
+
+    // Speedup and efficiency are written only if the baseline is passed
+    std::string ToJSON(Stats const * baseline = nullptr) const;
+  };
+
+  // Results are in the order of filePaths. If threadsCount is 0, a worker per hardware thread is started. If a blob
+  // store is passed, image contents of all files are stored in it, see GWFTranslationSession::SetBlobStore.
+  static std::vector<Result> Translate(
+      std::vector<std::string> const & filePaths,
+      std::size_t threadsCount,
+      Stats * stats = nullptr,
+      GWFBlobStore * blobStore = nullptr);
+};
@@ -0,0 +1,338 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "gwf_blob_store.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include <unistd.h>
+
+#include <sc-memory/sc_debug.hpp>
+
+#include "gwf_lock_wait_timer.hpp"
+
+namespace
+{
+std::array<uint32_t, 64> const SHA256_ROUND_CONSTANTS = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+uint32_t RotateRight(uint32_t value, uint32_t count)
+{
+  return (value >> count) | (value << (32 - count));
+}
+
+void ProcessSHA256Block(std::array<uint32_t, 8> & state, unsigned char const * block)
+{
+  std::array<uint32_t, 64> words;
+  for (std::size_t i = 0; i < 16; ++i)
+    words[i] = (uint32_t(block[i * 4]) << 24) | (uint32_t(block[i * 4 + 1]) << 16) | (uint32_t(block[i * 4 + 2]) << 8)
+               | uint32_t(block[i * 4 + 3]);
+  for (std::size_t i = 16; i < 64; ++i)
+  {
+    uint32_t const s0 = RotateRight(words[i - 15], 7) ^ RotateRight(words[i - 15], 18) ^ (words[i - 15] >> 3);
+    uint32_t const s1 = RotateRight(words[i - 2], 17) ^ RotateRight(words[i - 2], 19) ^ (words[i - 2] >> 10);
+    words[i] = words[i - 16] + s0 + words[i - 7] + s1;
+  }
+
+  std::array<uint32_t, 8> v = state;
+  for (std::size_t i = 0; i < 64; ++i)
+  {
+    uint32_t const s1 = RotateRight(v[4], 6) ^ RotateRight(v[4], 11) ^ RotateRight(v[4], 25);
+    uint32_t const choice = (v[4] & v[5]) ^ (~v[4] & v[6]);
+    uint32_t const temp1 = v[7] + s1 + choice + SHA256_ROUND_CONSTANTS[i] + words[i];
+    uint32_t const s0 = RotateRight(v[0], 2) ^ RotateRight(v[0], 13) ^ RotateRight(v[0], 22);
+    uint32_t const majority = (v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]);
+    uint32_t const temp2 = s0 + majority;
+
+    v = {temp1 + temp2, v[0], v[1], v[2], v[3] + temp1, v[4], v[5], v[6]};
+  }
+
+  for (std::size_t i = 0; i < 8; ++i)
+    state[i] += v[i];
+}
+}  // namespace
+
+class GWFBlobStore::Hasher
+{
+public:
+  Hasher()
+    : m_state{0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19}
+    , m_block()
+    , m_blockSize(0)
+    , m_size(0)
+  {
+  }
+
+  void Update(char const * data, std::size_t size)
+  {
+    auto const * bytes = reinterpret_cast<unsigned char const *>(data);
+    m_size += size;
+
+    if (m_blockSize != 0)
+    {
+      std::size_t const copiedSize = std::min(size, m_block.size() - m_blockSize);
+      std::copy(bytes, bytes + copiedSize, m_block.begin() + m_blockSize);
+      m_blockSize += copiedSize;
+      bytes += copiedSize;
+      size -= copiedSize;
+      if (m_blockSize < m_block.size())
+        return;
+
+      ProcessSHA256Block(m_state, m_block.data());
+      m_blockSize = 0;
+    }
+
+    for (; size >= m_block.size(); bytes += m_block.size(), size -= m_block.size())
+      ProcessSHA256Block(m_state, bytes);
+
+    std::copy(bytes, bytes + size, m_block.begin());
+    m_blockSize = size;
+  }
+
+  // The last block is padded with a one bit, zeros and the length of the content in bits
+  std::string Finish()
+  {
+    std::array<unsigned char, 128> tail{};
+    std::copy(m_block.begin(), m_block.begin() + m_blockSize, tail.begin());
+    tail[m_blockSize] = 0x80;
+    std::size_t const paddedSize = m_blockSize < 56 ? 64 : 128;
+    uint64_t const bitsCount = static_cast<uint64_t>(m_size) * 8;
+    for (std::size_t i = 0; i < 8; ++i)
+      tail[paddedSize - 1 - i] = static_cast<unsigned char>(bitsCount >> (i * 8));
+    for (std::size_t offset = 0; offset < paddedSize; offset += 64)
+      ProcessSHA256Block(m_state, tail.data() + offset);
+
+    static char const * const HEX_DIGITS = "0123456789abcdef";
+    std::string hash;
+    hash.reserve(64);
+    for (uint32_t const word : m_state)
+    {
+      for (int shift = 28; shift >= 0; shift -= 4)
+        hash += HEX_DIGITS[(word >> shift) & 0xf];
+    }
+    return hash;
+  }
+
+private:
+  std::array<uint32_t, 8> m_state;
+  std::array<unsigned char, 64> m_block;
+  std::size_t m_blockSize;
+  std::size_t m_size;
+};
+
+std::string GWFBlobStore::Stats::ToJSON() const
+{
+  std::stringstream json;
+  json << "{\"stored_blobs\": " << m_storedBlobs << ", \"stored_bytes\": " << m_storedBytes
+       << ", \"deduplicated_contents\": " << m_deduplicatedContents
+       << ", \"deduplicated_bytes\": " << m_deduplicatedBytes << "}";
+  return json.str();
+}
+
+GWFBlobStore::GWFBlobStore(std::string const & directoryPath)
+  : m_storedBlobs(0)
+  , m_storedBytes(0)
+  , m_deduplicatedContents(0)
+  , m_deduplicatedBytes(0)
+{
+  std::error_code errorCode;
+  std::filesystem::create_directories(directoryPath, errorCode);
+  if (errorCode)
+    SC_THROW_EXCEPTION(
+        utils::ExceptionCritical,
+        "GWFBlobStore: Unable to create directory `" << directoryPath << "`: " << errorCode.message() << ".");
+
+  m_directoryPath = std::filesystem::absolute(directoryPath).lexically_normal().string();
+}
+
+// A blob is written to a temporary file first and renamed, so that concurrent translations and interrupted runs never
+// leave a partially written blob under its final name
+std::string GWFBlobStore::Store(std::string_view content)
+{
+  std::string const & path = (std::filesystem::path(m_directoryPath) / ComputeHash(content)).string();
+  if (ClaimPath(path))
+  {
+    ++m_deduplicatedContents;
+    m_deduplicatedBytes += content.size();
+    return path;
+  }
+
+  std::stringstream temporaryPath;
+  temporaryPath << path << ".tmp." << getpid() << "." << std::this_thread::get_id();
+  std::error_code errorCode;
+  try
+  {
+    std::ofstream file(temporaryPath.str(), std::ios::binary);
+    file.write(content.data(), static_cast<std::streamsize>(content.size()));
+    file.close();
+    if (file.fail())
+      SC_THROW_EXCEPTION(
+          utils::ExceptionCritical, "GWFBlobStore::Store: Unable to write blob `" << temporaryPath.str() << "`.");
+
+    std::filesystem::rename(temporaryPath.str(), path, errorCode);
+    if (errorCode)
+      SC_THROW_EXCEPTION(
+          utils::ExceptionCritical,
+          "GWFBlobStore::Store: Unable to store blob `" << path << "`: " << errorCode.message() << ".");
+  }
+  catch (...)
+  {
+    std::filesystem::remove(temporaryPath.str(), errorCode);
+    ReleasePath(path, false);
+    throw;
+  }
+  ReleasePath(path, true);
+
+  ++m_storedBlobs;
+  m_storedBytes += content.size();
+  return path;
+}
+
+GWFBlobStore::Stats GWFBlobStore::GetStats() const
+{
+  Stats stats;
+  stats.m_storedBlobs = m_storedBlobs;
+  stats.m_storedBytes = m_storedBytes;
+  stats.m_deduplicatedContents = m_deduplicatedContents;
+  stats.m_deduplicatedBytes = m_deduplicatedBytes;
+  return stats;
+}
+
+// Paths stored during this run are remembered, so that repeated contents don't cost a file system lookup. Blobs of
+// previous runs are found on disk. A path is claimed by the translation that stores its blob; any other one that needs
+// the path waits until the blob is stored, so that no translation refers to a blob that isn't there yet. If storing
+// fails, one of the waiting translations claims the path in turn.
+bool GWFBlobStore::ClaimPath(std::string const & path)
+{
+  std::unique_lock<std::mutex> lock(m_storedPathsMutex, std::defer_lock);
+  GWFLockWaitTimer::Acquire(lock);
+  while (true)
+  {
+    auto const it = m_storedPaths.find(path);
+    if (it == m_storedPaths.cend())
+      break;
+    if (it->second)
+      return true;
+
+    auto const waitStart = GWFLockWaitTimer::Clock::now();
+    m_storedPathsCondition.wait(lock);
+    GWFLockWaitTimer::AddThreadWaitTime(GWFLockWaitTimer::Clock::now() - waitStart);
+  }
+
+  std::error_code errorCode;
+  bool const isStored = std::filesystem::exists(path, errorCode);
+  m_storedPaths.emplace(path, isStored);
+  return isStored;
+}
+
+void GWFBlobStore::ReleasePath(std::string const & path, bool isStored)
+{
+  {
+    std::unique_lock<std::mutex> lock(m_storedPathsMutex, std::defer_lock);
+    GWFLockWaitTimer::Acquire(lock);
+    if (isStored)
+      m_storedPaths[path] = true;
+    else
+      m_storedPaths.erase(path);
+  }
+  m_storedPathsCondition.notify_all();
+}
+
+std::string GWFBlobStore::ComputeHash(std::string_view content)
+{
+  Hasher hasher;
+  hasher.Update(content.data(), content.size());
+  return hasher.Finish();
+}
+
+// The hash of a streamed content is known only once it's written, so it's written to a temporary file named by the
+// writer and renamed to the blob when it's finished
+GWFBlobStore::Writer::Writer(GWFBlobStore & store)
+  : m_store(store)
+  , m_hasher(std::make_unique<Hasher>())
+  , m_size(0)
+{
+  static std::atomic<std::size_t> writersCount(0);
+
+  std::stringstream temporaryPath;
+  temporaryPath << (std::filesystem::path(m_store.m_directoryPath) / ".tmp.").string() << getpid() << "."
+                << std::this_thread::get_id() << "." << writersCount++;
+  m_temporaryPath = temporaryPath.str();
+
+  m_file.open(m_temporaryPath, std::ios::binary);
+  if (!m_file.is_open())
+    SC_THROW_EXCEPTION(
+        utils::ExceptionCritical, "GWFBlobStore::Writer: Unable to create blob `" << m_temporaryPath << "`.");
+}
+
+GWFBlobStore::Writer::~Writer()
+{
+  if (m_file.is_open())
+  {
+    m_file.close();
+    std::error_code errorCode;
+    std::filesystem::remove(m_temporaryPath, errorCode);
+  }
+}
+
+void GWFBlobStore::Writer::Write(char const * data, std::size_t size)
+{
+  m_hasher->Update(data, size);
+  m_size += size;
+  if (!m_file.write(data, static_cast<std::streamsize>(size)))
+    SC_THROW_EXCEPTION(
+        utils::ExceptionCritical, "GWFBlobStore::Writer::Write: Unable to write blob `" << m_temporaryPath << "`.");
+}
+
+std::string GWFBlobStore::Writer::Finish()
+{
+  m_file.close();
+  std::error_code errorCode;
+  if (m_file.fail())
+  {
+    std::filesystem::remove(m_temporaryPath, errorCode);
+    SC_THROW_EXCEPTION(
+        utils::ExceptionCritical, "GWFBlobStore::Writer::Finish: Unable to write blob `" << m_temporaryPath << "`.");
+  }
+
+  std::string const & path = (std::filesystem::path(m_store.m_directoryPath) / m_hasher->Finish()).string();
+  if (m_store.ClaimPath(path))
+  {
+    std::filesystem::remove(m_temporaryPath, errorCode);
+    ++m_store.m_deduplicatedContents;
+    m_store.m_deduplicatedBytes += m_size;
+    return path;
+  }
+
+  std::filesystem::rename(m_temporaryPath, path, errorCode);
+  if (errorCode)
+  {
+    std::error_code removalErrorCode;
+    std::filesystem::remove(m_temporaryPath, removalErrorCode);
+    m_store.ReleasePath(path, false);
+    SC_THROW_EXCEPTION(
+        utils::ExceptionCritical,
+        "GWFBlobStore::Writer::Finish: Unable to store blob `" << path << "`: " << errorCode.message() << ".");
+  }
+  m_store.ReleasePath(path, true);
+
+  ++m_store.m_storedBlobs;
+  m_store.m_storedBytes += m_size;
+  return path;
+}
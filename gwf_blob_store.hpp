@@ -0,0 +1,96 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/*!
+ * Content-addressed store of link contents on local disk.
+ *
+ * Every content is stored once in a file named by the SHA-256 hash of its bytes alone, so the same image embedded in
+ * many gwf-files is written and loaded into sc-memory once, whatever the names of the files it's embedded as. The
+ * format of a content, told by the extension of such file name, is metadata of its link, see SCsWriter. The store can
+ * be shared by translations of a whole run, from several threads; its stats cover all of them.
+ */
+class GWFBlobStore
+{
+  // Incremental SHA-256
+  class Hasher;
+
+public:
+  struct Stats
+  {
+    std::size_t m_storedBlobs = 0;
+    std::size_t m_storedBytes = 0;
+    // Contents that had already been stored, by this run or a previous one
+    std::size_t m_deduplicatedContents = 0;
+    std::size_t m_deduplicatedBytes = 0;
+
+    std::string ToJSON() const;
+  };
+
+  explicit GWFBlobStore(std::string const & directoryPath);
+
+  GWFBlobStore(GWFBlobStore const &) = delete;
+  GWFBlobStore & operator=(GWFBlobStore const &) = delete;
+
+  // Returns the absolute path of the stored content
+  std::string Store(std::string_view content);
+
+  // Stores a content chunk by chunk, for contents too large to be held in memory. A content that isn't finished, e.g.
+  // because of an error, leaves nothing in the store.
+  class Writer
+  {
+  public:
+    explicit Writer(GWFBlobStore & store);
+    ~Writer();
+
+    Writer(Writer const &) = delete;
+    Writer & operator=(Writer const &) = delete;
+
+    void Write(char const * data, std::size_t size);
+    // Returns the absolute path of the stored content, see Store
+    std::string Finish();
+
+  private:
+    GWFBlobStore & m_store;
+    std::unique_ptr<Hasher> m_hasher;
+    std::string m_temporaryPath;
+    std::ofstream m_file;
+    std::size_t m_size;
+  };
+
+  Stats GetStats() const;
+
+  static std::string ComputeHash(std::string_view content);
+
+private:
+  std::string m_directoryPath;
+
+  std::mutex m_storedPathsMutex;
+  std::condition_variable m_storedPathsCondition;
+  // Paths claimed during this run -> whether their blobs are stored. Blobs of the other ones are being stored.
+  std::unordered_map<std::string, bool> m_storedPaths;
+
+  std::atomic<std::size_t> m_storedBlobs;
+  std::atomic<std::size_t> m_storedBytes;
+  std::atomic<std::size_t> m_deduplicatedContents;
+  std::atomic<std::size_t> m_deduplicatedBytes;
+
+  // Returns true if the blob of path is stored. Otherwise the caller has claimed the path and must store the blob and
+  // release the path, whether storing succeeds or fails.
+  bool ClaimPath(std::string const & path);
+  void ReleasePath(std::string const & path, bool isStored);
+};
@@ -0,0 +1,577 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "gwf_generator.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <utility>
+
+#include <sc-memory/sc_debug.hpp>
+
+#include "gwf_translator_constants.hpp"
+#include "sc_scg_element.hpp"
+#include "sc_scg_to_scs_types_converter.hpp"
+
+using namespace Constants;
+
+namespace
+{
+size_t const FLUSH_SIZE = 1 << 20;
+
+char const * const BASE64_ALPHABET = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+char const * const GWF_BEGIN =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<GWF version=\"2.0\">\n    <staticSector>\n";
+char const * const GWF_END = "    </staticSector>\n</GWF>\n";
+
+char const * const SHAPE = "\" shapeColor=\"0\" id=\"";
+char const * const NODE_GEOMETRY =
+    "\" left=\"0\" top=\"0\" height=\"0\" width=\"0\" text_length=\"0\" line_width=\"0\">\n";
+char const * const LINE_GEOMETRY = "\" b_x=\"0\" b_y=\"0\" e_x=\"0\" e_y=\"0\" dotBBalance=\"0\" dotEBalance=\"0\">\n";
+char const * const NO_POINTS = "            <points/>\n";
+}  // namespace
+
+// Random
+GWFGenerator::Random::Random(uint64_t seed)
+  : m_state(seed)
+{
+}
+
+uint64_t GWFGenerator::Random::Next()
+{
+  // splitmix64
+  uint64_t value = (m_state += 0x9E3779B97F4A7C15ull);
+  value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+  value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+  return value ^ (value >> 31);
+}
+
+size_t GWFGenerator::Random::NextIndex(size_t count)
+{
+  return static_cast<size_t>(Next() % count);
+}
+
+// TypeDistribution
+GWFGenerator::TypeDistribution::TypeDistribution(
+    std::vector<std::pair<std::string, size_t>> const & weights,
+    std::vector<std::string> const & knownTypes,
+    std::string const & prefix)
+{
+  uint64_t totalWeight = 0;
+  auto const & addType = [&](std::string const & type, size_t weight)
+  {
+    if (weight == 0 || type.compare(0, prefix.size(), prefix) != 0)
+      return;
+
+    totalWeight += weight;
+    m_types.push_back(type);
+    m_cumulativeWeights.push_back(totalWeight);
+  };
+
+  if (weights.empty())
+  {
+    for (auto const & type : knownTypes)
+      addType(type, 1);
+  }
+  else
+  {
+    for (auto const & [type, weight] : weights)
+      addType(type, weight);
+  }
+}
+
+bool GWFGenerator::TypeDistribution::IsEmpty() const
+{
+  return m_types.empty();
+}
+
+std::string const & GWFGenerator::TypeDistribution::Select(Random & random) const
+{
+  uint64_t const point = random.Next() % m_cumulativeWeights.back();
+  auto const it = std::upper_bound(m_cumulativeWeights.cbegin(), m_cumulativeWeights.cend(), point);
+  return m_types[it - m_cumulativeWeights.cbegin()];
+}
+
+// XmlSink
+GWFGenerator::XmlSink::XmlSink(std::ostream * stream)
+  : m_stream(stream)
+{
+  m_value.reserve(m_stream != nullptr ? FLUSH_SIZE * 2 : FLUSH_SIZE);
+}
+
+void GWFGenerator::XmlSink::Begin()
+{
+  *this << GWF_BEGIN;
+}
+
+void GWFGenerator::XmlSink::End()
+{
+  *this << GWF_END;
+  Flush();
+}
+
+void GWFGenerator::XmlSink::AddContour(size_t id, size_t parent, std::string const & identifier)
+{
+  BeginElement(CONTOUR, "", identifier, id, parent) << NODE_GEOMETRY << NO_POINTS;
+  EndElement(CONTOUR);
+}
+
+void GWFGenerator::XmlSink::AddNode(size_t id, size_t parent, std::string const & identifier, std::string const & type)
+{
+  BeginElement(NODE, type, identifier, id, parent)
+      << NODE_GEOMETRY << "            <content type=\"0\" mime_type=\"\" file_name=\"\"/>\n";
+  EndElement(NODE);
+}
+
+void GWFGenerator::XmlSink::AddLink(
+    size_t id,
+    size_t parent,
+    std::string const & identifier,
+    std::string const & type,
+    std::string const & contentType,
+    std::string const & content)
+{
+  BeginElement(NODE, type, identifier, id, parent)
+      << NODE_GEOMETRY << "            <content type=\"" << contentType
+      << "\" mime_type=\"content/term\" file_name=\"\"><![CDATA[" << content << "]]></content>\n";
+  EndElement(NODE);
+}
+
+void GWFGenerator::XmlSink::AddImageLink(
+    size_t id,
+    size_t parent,
+    std::string const & identifier,
+    std::string const & type,
+    size_t size,
+    Random & random)
+{
+  BeginElement(NODE, type, identifier, id, parent)
+      << NODE_GEOMETRY << "            <content type=\"4\" mime_type=\"image/png\" file_name=\"image_" << id
+      << ".png\">";
+  AppendBase64(random, size);
+  *this << "</content>\n";
+  EndElement(NODE);
+}
+
+void GWFGenerator::XmlSink::AddBus(size_t id, size_t parent, std::string const & identifier, size_t owner)
+{
+  BeginElement(BUS, "", identifier, id, parent) << "\" owner=\"" << owner << LINE_GEOMETRY << NO_POINTS;
+  EndElement(BUS);
+}
+
+void GWFGenerator::XmlSink::AddConnector(
+    size_t id,
+    size_t parent,
+    std::string const & identifier,
+    std::string const & tag,
+    std::string const & type,
+    size_t source,
+    size_t target)
+{
+  BeginElement(tag, type, identifier, id, parent)
+      << "\" id_b=\"" << source << "\" id_e=\"" << target << LINE_GEOMETRY << NO_POINTS;
+  EndElement(tag);
+}
+
+GWFGenerator::XmlSink & GWFGenerator::XmlSink::operator<<(std::string const & string)
+{
+  m_value += string;
+  return *this;
+}
+
+GWFGenerator::XmlSink & GWFGenerator::XmlSink::operator<<(char const * string)
+{
+  m_value += string;
+  return *this;
+}
+
+GWFGenerator::XmlSink & GWFGenerator::XmlSink::operator<<(size_t number)
+{
+  char digits[20];
+  auto const result = std::to_chars(digits, digits + sizeof(digits), number);
+  m_value.append(digits, result.ptr);
+  return *this;
+}
+
+GWFGenerator::XmlSink & GWFGenerator::XmlSink::BeginElement(
+    std::string const & tag,
+    std::string const & type,
+    std::string const & identifier,
+    size_t id,
+    size_t parent)
+{
+  return *this << "        <" << tag << " type=\"" << type << "\" idtf=\"" << identifier << SHAPE << id
+               << "\" parent=\"" << parent;
+}
+
+void GWFGenerator::XmlSink::EndElement(std::string const & tag)
+{
+  *this << "        </" << tag << ">\n";
+
+  if (m_stream != nullptr && m_value.size() >= FLUSH_SIZE)
+    Flush();
+}
+
+void GWFGenerator::XmlSink::AppendBase64(Random & random, size_t size)
+{
+  uint64_t bits = 0;
+  for (size_t i = 0; i < size; i += 3)
+  {
+    // Every random value provides 2 groups of 3 bytes
+    if (i % 6 == 0)
+      bits = random.Next();
+
+    uint32_t const group = static_cast<uint32_t>(bits & 0xFFFFFF);
+    bits >>= 24;
+
+    size_t const groupSize = std::min<size_t>(3, size - i);
+    char encoded[4] = {
+        BASE64_ALPHABET[(group >> 18) & 0x3F],
+        BASE64_ALPHABET[(group >> 12) & 0x3F],
+        groupSize > 1 ? BASE64_ALPHABET[(group >> 6) & 0x3F] : '=',
+        groupSize > 2 ? BASE64_ALPHABET[group & 0x3F] : '='};
+    if (groupSize == 1)
+      encoded[1] = BASE64_ALPHABET[(group >> 12) & 0x30];
+    else if (groupSize == 2)
+      encoded[2] = BASE64_ALPHABET[(group >> 6) & 0x3C];
+    m_value.append(encoded, 4);
+
+    if (m_stream != nullptr && m_value.size() >= FLUSH_SIZE)
+      Flush();
+  }
+}
+
+void GWFGenerator::XmlSink::Flush()
+{
+  if (m_stream == nullptr)
+    return;
+
+  m_stream->write(m_value.data(), m_value.size());
+  m_value.clear();
+}
+
+std::string & GWFGenerator::XmlSink::GetValue()
+{
+  return m_value;
+}
+
+// SCgSink
+GWFGenerator::SCgSink::SCgSink(SCgElements & elementsWithoutParents)
+  : m_elementsWithoutParents(elementsWithoutParents)
+  , m_elements(1)
+{
+}
+
+void GWFGenerator::SCgSink::End()
+{
+  for (auto const & [contourId, elements] : m_contours)
+    std::dynamic_pointer_cast<SCgContour>(m_elements[std::stoul(std::string(contourId))])->SetElements(elements);
+}
+
+void GWFGenerator::SCgSink::AddContour(size_t id, size_t parent, std::string const & identifier)
+{
+  AddElement(
+      id, parent, std::make_shared<SCgContour>(std::to_string(id), std::to_string(parent), identifier, "", CONTOUR));
+}
+
+void GWFGenerator::SCgSink::AddNode(size_t id, size_t parent, std::string const & identifier, std::string const & type)
+{
+  AddElement(id, parent, std::make_shared<SCgNode>(std::to_string(id), std::to_string(parent), identifier, type, NODE));
+}
+
+void GWFGenerator::SCgSink::AddLink(
+    size_t id,
+    size_t parent,
+    std::string const & identifier,
+    std::string const & type,
+    std::string const & contentType,
+    std::string const & content)
+{
+  AddElement(
+      id,
+      parent,
+      std::make_shared<SCgLink>(
+          std::to_string(id),
+          std::to_string(parent),
+          identifier,
+          type,
+          NODE,
+          contentType,
+          "content/term",
+          "",
+          std::pmr::string(content)));
+}
+
+void GWFGenerator::SCgSink::AddImageLink(
+    size_t id,
+    size_t parent,
+    std::string const & identifier,
+    std::string const & type,
+    size_t size,
+    Random & random)
+{
+  // Produces exactly the bytes the xml sink encodes, so both sinks build the same diagram
+  std::pmr::string content(size, '\0');
+  uint64_t bits = 0;
+  for (size_t i = 0; i < size; ++i)
+  {
+    if (i % 6 == 0)
+      bits = random.Next();
+    content[i] = static_cast<char>(bits >> (16 - (i % 3) * 8));
+    if (i % 3 == 2)
+      bits >>= 24;
+  }
+
+  AddElement(
+      id,
+      parent,
+      std::make_shared<SCgLink>(
+          std::to_string(id),
+          std::to_string(parent),
+          identifier,
+          type,
+          NODE,
+          "4",
+          "image/png",
+          "image_" + std::to_string(id) + ".png",
+          std::move(content)));
+}
+
+void GWFGenerator::SCgSink::AddBus(size_t id, size_t parent, std::string const & identifier, size_t owner)
+{
+  AddElement(
+      id,
+      parent,
+      std::make_shared<SCgBus>(std::to_string(id), std::to_string(parent), identifier, "", BUS, std::to_string(owner)));
+}
+
+void GWFGenerator::SCgSink::AddConnector(
+    size_t id,
+    size_t parent,
+    std::string const & identifier,
+    std::string const & tag,
+    std::string const & type,
+    size_t source,
+    size_t target)
+{
+  AddElement(
+      id,
+      parent,
+      std::make_shared<SCgConnector>(
+          std::to_string(id), std::to_string(parent), identifier, type, tag, GetEndpoint(source), GetEndpoint(target)));
+}
+
+void GWFGenerator::SCgSink::AddElement(size_t id, size_t parent, SCgElementPtr const & element)
+{
+  if (parent == 0)
+    m_elementsWithoutParents[element->GetId()] = element;
+  else
+    m_contours[std::pmr::string(element->GetParent())].insert({element->GetId(), element});
+
+  m_elements.resize(std::max(m_elements.size(), id + 1));
+  m_elements[id] = element;
+}
+
+SCgElementPtr const & GWFGenerator::SCgSink::GetEndpoint(size_t id) const
+{
+  // Connectors are incident to the bus owners, as the parser resolves them
+  SCgElementPtr const & element = m_elements[id];
+  if (auto const & bus = std::dynamic_pointer_cast<SCgBus>(element))
+    return m_elements[std::stoul(std::string(bus->GetNodeId()))];
+  return element;
+}
+
+// GWFGenerator
+std::string GWFGenerator::Generate(Params const & params)
+{
+  XmlSink sink(nullptr);
+  sink.Begin();
+  Generate(params, sink);
+  sink.End();
+  return std::move(sink.GetValue());
+}
+
+void GWFGenerator::Generate(Params const & params, std::ostream & stream)
+{
+  XmlSink sink(&stream);
+  sink.Begin();
+  Generate(params, sink);
+  sink.End();
+}
+
+void GWFGenerator::Generate(Params const & params, SCgElements & elementsWithoutParents)
+{
+  SCgSink sink(elementsWithoutParents);
+  Generate(params, sink);
+  sink.End();
+}
+
+void GWFGenerator::Generate(Params const & params, Sink & sink)
+{
+  Random random(params.m_seed);
+
+  auto const & knownNodeTypes = SCgToSCsTypesConverter::GetKnownSCgNodeTypes();
+  auto const & knownConnectorTypes = SCgToSCsTypesConverter::GetKnownSCgConnectorTypes();
+  TypeDistribution const nodeTypes(params.m_nodeTypeWeights, knownNodeTypes, NODE);
+  TypeDistribution const pairTypes(params.m_connectorTypeWeights, knownConnectorTypes, PAIR);
+  TypeDistribution const arcTypes(params.m_connectorTypeWeights, knownConnectorTypes, ARC);
+
+  size_t const nodesCount =
+      params.m_nodesCount + params.m_stringLinksCount + params.m_numericLinksCount + params.m_imageLinksCount;
+  if ((nodesCount > 0 && nodeTypes.IsEmpty()) || (params.m_pairsCount > 0 && pairTypes.IsEmpty())
+      || ((params.m_arcsCount > 0 || params.m_attributeChainsCount > 0) && arcTypes.IsEmpty()))
+    SC_THROW_EXCEPTION(
+        utils::ExceptionInvalidParams,
+        "GWFGenerator::Generate: There are no types with weights for generated elements.");
+
+  size_t nextId = 1;
+  std::vector<size_t> contours;
+  std::vector<size_t> endpoints;
+
+  auto const & selectParent = [&]() -> size_t
+  {
+    if (contours.empty() || random.NextIndex(100) >= params.m_contouredElementsPercent)
+      return 0;
+    return contours[random.NextIndex(contours.size())];
+  };
+
+  std::vector<std::pair<size_t, size_t>> contoursToGenerate;  // (parent, level)
+  for (size_t i = 0; i < params.m_rootContoursCount; ++i)
+    contoursToGenerate.emplace_back(0, 1);
+  while (!contoursToGenerate.empty())
+  {
+    auto const [parent, level] = contoursToGenerate.back();
+    contoursToGenerate.pop_back();
+
+    size_t const id = nextId++;
+    sink.AddContour(id, parent, GenerateIdentifier(random, id));
+    contours.push_back(id);
+
+    if (level < params.m_contourDepth)
+    {
+      for (size_t i = 0; i < params.m_contourFanOut; ++i)
+        contoursToGenerate.emplace_back(id, level + 1);
+    }
+  }
+
+  for (size_t i = 0; i < params.m_nodesCount; ++i)
+  {
+    size_t const id = nextId++;
+    size_t const parent = selectParent();
+    std::string const identifier = GenerateIdentifier(random, id);
+    sink.AddNode(id, parent, identifier, nodeTypes.Select(random));
+    endpoints.push_back(id);
+  }
+
+  for (size_t i = 0; i < params.m_stringLinksCount; ++i)
+  {
+    size_t const id = nextId++;
+    size_t const parent = selectParent();
+    std::string const content = "text " + std::to_string(random.Next()) + " of link " + std::to_string(id);
+    std::string const identifier = GenerateIdentifier(random, id);
+    sink.AddLink(id, parent, identifier, nodeTypes.Select(random), "1", content);
+    endpoints.push_back(id);
+  }
+
+  for (size_t i = 0; i < params.m_numericLinksCount; ++i)
+  {
+    size_t const id = nextId++;
+    size_t const parent = selectParent();
+    bool const isInteger = random.NextIndex(2) == 0;
+    std::string content = std::to_string(random.NextIndex(1000000));
+    if (!isInteger)
+      content += "." + std::to_string(random.NextIndex(1000));
+    std::string const identifier = GenerateIdentifier(random, id);
+    sink.AddLink(id, parent, identifier, nodeTypes.Select(random), isInteger ? "2" : "3", content);
+    endpoints.push_back(id);
+  }
+
+  for (size_t i = 0; i < params.m_imageLinksCount; ++i)
+  {
+    size_t const id = nextId++;
+    size_t const parent = selectParent();
+    std::string const identifier = GenerateIdentifier(random, id);
+    std::string const & type = nodeTypes.Select(random);
+    sink.AddImageLink(id, parent, identifier, type, params.m_imageSize, random);
+    endpoints.push_back(id);
+  }
+
+  if (params.m_busesCount > 0 && endpoints.empty())
+    SC_THROW_EXCEPTION(
+        utils::ExceptionInvalidParams, "GWFGenerator::Generate: Buses can't be generated without nodes.");
+
+  size_t const ownersCount = endpoints.size();
+  for (size_t i = 0; i < params.m_busesCount; ++i)
+  {
+    size_t const id = nextId++;
+    size_t const parent = selectParent();
+    std::string const identifier = GenerateIdentifier(random, id);
+    sink.AddBus(id, parent, identifier, endpoints[random.NextIndex(ownersCount)]);
+    endpoints.push_back(id);
+  }
+
+  if ((params.m_pairsCount > 0 || params.m_arcsCount > 0 || params.m_attributeChainsCount > 0) && endpoints.empty())
+    SC_THROW_EXCEPTION(
+        utils::ExceptionInvalidParams, "GWFGenerator::Generate: Connectors can't be generated without nodes.");
+
+  auto const & generateConnector =
+      [&](std::string const & tag, TypeDistribution const & types, size_t source, size_t target) -> size_t
+  {
+    size_t const id = nextId++;
+    size_t const parent = selectParent();
+    std::string const identifier = GenerateIdentifier(random, id);
+    sink.AddConnector(id, parent, identifier, tag, types.Select(random), source, target);
+    return id;
+  };
+
+  auto const & selectEndpoint = [&]() -> size_t
+  {
+    return endpoints[random.NextIndex(endpoints.size())];
+  };
+
+  size_t const hubsCount = std::min(params.m_hubsCount, endpoints.size());
+  auto const & selectSource = [&]() -> size_t
+  {
+    if (hubsCount > 0 && random.NextIndex(100) < params.m_hubConnectorsPercent)
+      return endpoints[random.NextIndex(hubsCount)];
+    return selectEndpoint();
+  };
+
+  for (size_t i = 0; i < params.m_pairsCount; ++i)
+  {
+    size_t const source = selectSource();
+    generateConnector(PAIR, pairTypes, source, selectEndpoint());
+  }
+
+  for (size_t i = 0; i < params.m_arcsCount; ++i)
+  {
+    size_t const source = selectSource();
+    generateConnector(ARC, arcTypes, source, selectEndpoint());
+  }
+
+  for (size_t i = 0; i < params.m_attributeChainsCount; ++i)
+  {
+    size_t const source = selectEndpoint();
+    size_t connector = generateConnector(ARC, arcTypes, source, selectEndpoint());
+    for (size_t j = 1; j < params.m_attributeChainLength; ++j)
+      connector = generateConnector(ARC, arcTypes, selectEndpoint(), connector);
+  }
+}
+
+std::string GWFGenerator::GenerateIdentifier(Random & random, size_t id)
+{
+  // Mix all identifier kinds the identifier corrector distinguishes: empty, english and russian ones
+  switch (random.NextIndex(8))
+  {
+  case 0:
+    return "";
+  case 1:
+    return "\xD1\x83\xD0\xB7\xD0\xB5\xD0\xBB_" + std::to_string(id);
+  default:
+    return "element_" + std::to_string(id);
+  }
+}
@@ -0,0 +1,229 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gwf_translator_constants.hpp"
+
+/*!
+ * Generates synthetic, but valid gwf-files for benchmarks and scaling tests.
+ *
+ * The output depends only on the parameters: the same seed always produces the same file on every platform, because
+ * the generator uses its own pseudo-random sequence instead of standard library distributions. The same diagram can be
+ * built directly as SCg-elements, so that the writer can be measured without XML.
+ */
+class GWFGenerator
+{
+public:
+  struct Params
+  {
+    uint64_t m_seed = 0;
+
+    size_t m_nodesCount = 0;
+    size_t m_stringLinksCount = 0;
+    size_t m_numericLinksCount = 0;
+    size_t m_imageLinksCount = 0;
+    // Size of decoded image content in bytes
+    size_t m_imageSize = 1024;
+    size_t m_busesCount = 0;
+
+    // Every root contour is a tree of nested contours with given depth and fan-out
+    size_t m_rootContoursCount = 0;
+    size_t m_contourDepth = 1;
+    size_t m_contourFanOut = 1;
+    // Percent of nodes, links and connectors that are placed into contours
+    size_t m_contouredElementsPercent = 50;
+
+    size_t m_pairsCount = 0;
+    size_t m_arcsCount = 0;
+    // Every chain starts with an arc between nodes, each next arc goes from an attribute node to the previous arc
+    size_t m_attributeChainsCount = 0;
+    size_t m_attributeChainLength = 1;
+    // Hubs are the first nodes, percent of pairs and arcs start from one of them, so that their fan-out grows with
+    // the diagram
+    size_t m_hubsCount = 0;
+    size_t m_hubConnectorsPercent = 0;
+
+    // Relative frequencies of type strings, e.g. captured from a real corpus. Types unknown to the converter are
+    // allowed, so backward-mapped and unsupported lookup paths can be replayed too. If a list is empty, all types known
+    // to the converter are equally frequent.
+    std::vector<std::pair<std::string, size_t>> m_nodeTypeWeights;
+    std::vector<std::pair<std::string, size_t>> m_connectorTypeWeights;
+  };
+
+  static std::string Generate(Params const & params);
+  static void Generate(Params const & params, std::ostream & stream);
+  static void Generate(Params const & params, SCgElements & elementsWithoutParents);
+
+private:
+  class Random
+  {
+  public:
+    explicit Random(uint64_t seed);
+
+    uint64_t Next();
+    size_t NextIndex(size_t count);
+
+  private:
+    uint64_t m_state;
+  };
+
+  class TypeDistribution
+  {
+  public:
+    TypeDistribution(
+        std::vector<std::pair<std::string, size_t>> const & weights,
+        std::vector<std::string> const & knownTypes,
+        std::string const & prefix);
+
+    bool IsEmpty() const;
+    std::string const & Select(Random & random) const;
+
+  private:
+    std::vector<std::string> m_types;
+    std::vector<uint64_t> m_cumulativeWeights;
+  };
+
+  class Sink
+  {
+  public:
+    virtual ~Sink() = default;
+
+    virtual void AddContour(size_t id, size_t parent, std::string const & identifier) = 0;
+    virtual void AddNode(size_t id, size_t parent, std::string const & identifier, std::string const & type) = 0;
+    virtual void AddLink(
+        size_t id,
+        size_t parent,
+        std::string const & identifier,
+        std::string const & type,
+        std::string const & contentType,
+        std::string const & content) = 0;
+    virtual void AddImageLink(
+        size_t id,
+        size_t parent,
+        std::string const & identifier,
+        std::string const & type,
+        size_t size,
+        Random & random) = 0;
+    virtual void AddBus(size_t id, size_t parent, std::string const & identifier, size_t owner) = 0;
+    virtual void AddConnector(
+        size_t id,
+        size_t parent,
+        std::string const & identifier,
+        std::string const & tag,
+        std::string const & type,
+        size_t source,
+        size_t target) = 0;
+  };
+
+  class XmlSink : public Sink
+  {
+  public:
+    explicit XmlSink(std::ostream * stream);
+
+    void Begin();
+    void End();
+
+    void AddContour(size_t id, size_t parent, std::string const & identifier) override;
+    void AddNode(size_t id, size_t parent, std::string const & identifier, std::string const & type) override;
+    void AddLink(
+        size_t id,
+        size_t parent,
+        std::string const & identifier,
+        std::string const & type,
+        std::string const & contentType,
+        std::string const & content) override;
+    void AddImageLink(
+        size_t id,
+        size_t parent,
+        std::string const & identifier,
+        std::string const & type,
+        size_t size,
+        Random & random) override;
+    void AddBus(size_t id, size_t parent, std::string const & identifier, size_t owner) override;
+    void AddConnector(
+        size_t id,
+        size_t parent,
+        std::string const & identifier,
+        std::string const & tag,
+        std::string const & type,
+        size_t source,
+        size_t target) override;
+
+    void Flush();
+
+    std::string & GetValue();
+
+  private:
+    std::ostream * m_stream;
+    std::string m_value;
+
+    XmlSink & operator<<(std::string const & string);
+    XmlSink & operator<<(char const * string);
+    XmlSink & operator<<(size_t number);
+
+    XmlSink & BeginElement(
+        std::string const & tag,
+        std::string const & type,
+        std::string const & identifier,
+        size_t id,
+        size_t parent);
+    void EndElement(std::string const & tag);
+    void AppendBase64(Random & random, size_t size);
+  };
+
+  class SCgSink : public Sink
+  {
+  public:
+    explicit SCgSink(SCgElements & elementsWithoutParents);
+
+    void End();
+
+    void AddContour(size_t id, size_t parent, std::string const & identifier) override;
+    void AddNode(size_t id, size_t parent, std::string const & identifier, std::string const & type) override;
+    void AddLink(
+        size_t id,
+        size_t parent,
+        std::string const & identifier,
+        std::string const & type,
+        std::string const & contentType,
+        std::string const & content) override;
+    void AddImageLink(
+        size_t id,
+        size_t parent,
+        std::string const & identifier,
+        std::string const & type,
+        size_t size,
+        Random & random) override;
+    void AddBus(size_t id, size_t parent, std::string const & identifier, size_t owner) override;
+    void AddConnector(
+        size_t id,
+        size_t parent,
+        std::string const & identifier,
+        std::string const & tag,
+        std::string const & type,
+        size_t source,
+        size_t target) override;
+
+  private:
+    SCgElements & m_elementsWithoutParents;
+    std::vector<SCgElementPtr> m_elements;
+    SCgContours m_contours;
+
+    void AddElement(size_t id, size_t parent, SCgElementPtr const & element);
+    SCgElementPtr const & GetEndpoint(size_t id) const;
+  };
+
+  static void Generate(Params const & params, Sink & sink);
+
+  static std::string GenerateIdentifier(Random & random, size_t id);
+};
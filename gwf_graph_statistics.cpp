@@ -0,0 +1,268 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "gwf_graph_statistics.hpp"
+
+#include <algorithm>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+#include "gwf_json.hpp"
+#include "gwf_parser.hpp"
+#include "gwf_validator.hpp"
+#include "sc_scg_element.hpp"
+
+using namespace Constants;
+
+namespace
+{
+std::string const LINK = "link";
+
+bool IsConnector(SCgElementPtr const & element)
+{
+  return element->GetTag() == ARC || element->GetTag() == PAIR;
+}
+
+std::string GetContentTypeName(std::string_view contentType)
+{
+  if (contentType == "1")
+    return "string";
+  if (contentType == "2")
+    return "int";
+  if (contentType == "3")
+    return "float";
+  if (contentType == "4")
+    return "image";
+  return std::string(contentType);
+}
+
+// Keys of JSON objects are strings, so histogram values are written as keys: {"value": occurrences}
+void WriteHistogram(std::stringstream & json, GWFGraphStatistics::Histogram const & histogram)
+{
+  json << "{";
+  for (auto it = histogram.cbegin(); it != histogram.cend(); ++it)
+  {
+    if (it != histogram.cbegin())
+      json << ", ";
+    json << "\"" << it->first << "\": " << it->second;
+  }
+  json << "}";
+}
+
+void WriteCounts(std::stringstream & json, std::map<std::string, std::size_t> const & counts)
+{
+  json << "{";
+  for (auto it = counts.cbegin(); it != counts.cend(); ++it)
+  {
+    if (it != counts.cbegin())
+      json << ", ";
+    GWFJSON::WriteString(json, it->first);
+    json << ": " << it->second;
+  }
+  json << "}";
+}
+}  // namespace
+
+GWFGraphStatistics GWFGraphStatistics::Collect(std::string const & xmlStr, std::string const & filePath)
+{
+  xmlInitParser();
+
+  // Only sizes of image contents are collected, so they are never decoded
+  GWFDetachedContents detachedContents;
+  GWFContentStorage const storage = {nullptr, nullptr, true, &detachedContents};
+  auto const & document = GWFParser::ReadDocument(xmlStr, storage, filePath);
+  xmlNodePtr const staticSector = GWFParser::FindStaticSector(document.get());
+  GWFValidator::Check(staticSector);
+
+  SCgElements elementsWithoutParents;
+  SCgElements allElements;
+  SCgConnectors connectors;
+  SCgContours contours;
+  GWFParser::ProcessStaticSector(
+      staticSector, elementsWithoutParents, allElements, connectors, contours, storage);
+  GWFParser::FillConnectors(connectors, allElements);
+  GWFParser::FillContours(contours, allElements);
+
+  GWFGraphStatistics statistics;
+  statistics.CollectKinds(allElements);
+  statistics.CollectContours(elementsWithoutParents, 1);
+  statistics.CollectConnectors(allElements);
+  // Connectors are resolved to bus owners already, so buses are found by connector ends read from the document
+  statistics.CollectBuses(allElements, connectors);
+  return statistics;
+}
+
+std::string GWFGraphStatistics::GetKind(SCgElementPtr const & element)
+{
+  std::string_view const tag = element->GetTag();
+  if (tag == NODE && std::dynamic_pointer_cast<SCgLink>(element))
+    return LINK;
+
+  return std::string(tag);
+}
+
+void GWFGraphStatistics::CollectKinds(SCgElements const & elements)
+{
+  for (auto const & [id, element] : elements)
+  {
+    std::string const & kind = GetKind(element);
+    ++m_kinds[kind];
+    ++m_types[kind][std::string(element->GetType())];
+
+    if (auto const & link = std::dynamic_pointer_cast<SCgLink>(element))
+    {
+      ContentSizes & sizes = m_linkContentSizes[GetContentTypeName(link->GetContentType())];
+      std::size_t const size = link->GetContentSize();
+      ++sizes.m_count;
+      sizes.m_totalBytes += size;
+      sizes.m_maxBytes = std::max(sizes.m_maxBytes, size);
+    }
+  }
+}
+
+// Every element belongs to one parent, so contours reachable from the diagram root form a tree
+void GWFGraphStatistics::CollectContours(SCgElements const & elements, std::size_t depth)
+{
+  for (auto const & [id, element] : elements)
+  {
+    if (element->GetTag() != CONTOUR)
+      continue;
+
+    auto const & contour = std::dynamic_pointer_cast<SCgContour>(element);
+    ++m_contourDepths[depth];
+    ++m_contourSizes[contour->GetElements().size()];
+    CollectContours(contour->GetElements(), depth + 1);
+  }
+}
+
+void GWFGraphStatistics::CollectConnectors(SCgElements const & elements)
+{
+  std::unordered_map<SCgElement const *, std::size_t> fanOut;
+  std::unordered_map<SCgElement const *, std::size_t> fanIn;
+  for (auto const & [id, element] : elements)
+  {
+    if (element->GetTag() == BUS)
+      continue;
+
+    fanOut[element.get()];
+    fanIn[element.get()];
+    if (!IsConnector(element))
+      continue;
+
+    auto const & connector = std::dynamic_pointer_cast<SCgConnector>(element);
+    ++fanOut[connector->GetSource().get()];
+    ++fanIn[connector->GetTarget().get()];
+  }
+
+  for (auto const & [element, count] : fanOut)
+    ++m_fanOut[count];
+  for (auto const & [element, count] : fanIn)
+    ++m_fanIn[count];
+
+  // Lengths of chains are remembered for every connector, so chains sharing their tails are walked once. A connector
+  // is marked with zero length while its chain is walked, so cyclic chains end.
+  std::unordered_map<SCgElement const *, std::size_t> chainLengths;
+  auto const & getChainLength = [&](SCgElementPtr const & head) -> std::size_t
+  {
+    std::vector<SCgElement const *> chain;
+    std::size_t length = 0;
+    for (SCgElementPtr element = head; IsConnector(element);
+         element = std::static_pointer_cast<SCgConnector>(element)->GetTarget())
+    {
+      auto const it = chainLengths.find(element.get());
+      if (it != chainLengths.cend())
+      {
+        length = it->second;
+        break;
+      }
+
+      chainLengths[element.get()] = 0;
+      chain.push_back(element.get());
+    }
+
+    for (auto it = chain.crbegin(); it != chain.crend(); ++it)
+      chainLengths[*it] = ++length;
+    return length;
+  };
+
+  for (auto const & [id, element] : elements)
+  {
+    if (!IsConnector(element) || fanIn[element.get()] > 0)
+      continue;
+
+    auto const & connector = std::dynamic_pointer_cast<SCgConnector>(element);
+    if (IsConnector(connector->GetTarget()))
+      ++m_connectorChainLengths[getChainLength(element)];
+  }
+}
+
+void GWFGraphStatistics::CollectBuses(SCgElements const & elements, SCgConnectors const & connectors)
+{
+  std::unordered_map<std::string_view, std::size_t> busConnectors;
+  for (auto const & [id, element] : elements)
+  {
+    if (element->GetTag() == BUS)
+      busConnectors[id];
+  }
+
+  for (auto const & [connector, incidentElements] : connectors)
+  {
+    for (std::string_view const elementId :
+         {std::string_view(incidentElements.first), std::string_view(incidentElements.second)})
+    {
+      auto const it = busConnectors.find(elementId);
+      if (it != busConnectors.cend())
+        ++it->second;
+    }
+  }
+
+  for (auto const & [id, count] : busConnectors)
+    ++m_busConnectors[count];
+}
+
+std::string GWFGraphStatistics::ToJSON() const
+{
+  std::stringstream json;
+  json << "{\"kinds\": ";
+  WriteCounts(json, m_kinds);
+
+  json << ", \"types\": {";
+  for (auto it = m_types.cbegin(); it != m_types.cend(); ++it)
+  {
+    if (it != m_types.cbegin())
+      json << ", ";
+    GWFJSON::WriteString(json, it->first);
+    json << ": ";
+    WriteCounts(json, it->second);
+  }
+
+  json << "}, \"contour_depths\": ";
+  WriteHistogram(json, m_contourDepths);
+  json << ", \"contour_sizes\": ";
+  WriteHistogram(json, m_contourSizes);
+  json << ", \"fan_out\": ";
+  WriteHistogram(json, m_fanOut);
+  json << ", \"fan_in\": ";
+  WriteHistogram(json, m_fanIn);
+  json << ", \"connector_chain_lengths\": ";
+  WriteHistogram(json, m_connectorChainLengths);
+
+  json << ", \"link_content_sizes\": {";
+  for (auto it = m_linkContentSizes.cbegin(); it != m_linkContentSizes.cend(); ++it)
+  {
+    if (it != m_linkContentSizes.cbegin())
+      json << ", ";
+    GWFJSON::WriteString(json, it->first);
+    json << ": {\"count\": " << it->second.m_count << ", \"total_bytes\": " << it->second.m_totalBytes
+         << ", \"max_bytes\": " << it->second.m_maxBytes << "}";
+  }
+
+  json << "}, \"bus_connectors\": ";
+  WriteHistogram(json, m_busConnectors);
+  json << "}";
+  return json.str();
+}
@@ -0,0 +1,65 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <string>
+
+#include "gwf_translator_constants.hpp"
+
+/*!
+ * Shape of a diagram as GWFParser sees it. Statistics are collected by parsing only, without rendering SCs, so they can
+ * be gathered cheaply over a whole corpus and aggregated from their JSON form.
+ */
+struct GWFGraphStatistics
+{
+  // Value -> number of its occurrences
+  using Histogram = std::map<std::size_t, std::size_t>;
+
+  struct ContentSizes
+  {
+    std::size_t m_count = 0;
+    std::size_t m_totalBytes = 0;
+    std::size_t m_maxBytes = 0;
+  };
+
+  // Kind -> number of elements, links are counted apart from nodes
+  std::map<std::string, std::size_t> m_kinds;
+  // Kind -> type string -> number of elements
+  std::map<std::string, std::map<std::string, std::size_t>> m_types;
+
+  // Contours without parent contour have depth 1
+  Histogram m_contourDepths;
+  // Numbers of elements placed directly into contours
+  Histogram m_contourSizes;
+
+  // Numbers of connectors going from and to every node, link, contour and connector; connectors of buses are
+  // accounted to bus owners
+  Histogram m_fanOut;
+  Histogram m_fanIn;
+  // Numbers of connectors in maximal chains of connectors, where every connector goes to the next one
+  Histogram m_connectorChainLengths;
+
+  // Content type -> sizes of link contents, images are decoded
+  std::map<std::string, ContentSizes> m_linkContentSizes;
+
+  // Numbers of connectors attached to every bus
+  Histogram m_busConnectors;
+
+  static GWFGraphStatistics Collect(std::string const & xmlStr, std::string const & filePath = "");
+
+  std::string ToJSON() const;
+
+private:
+  static std::string GetKind(SCgElementPtr const & element);
+
+  void CollectKinds(SCgElements const & elements);
+  void CollectContours(SCgElements const & elements, std::size_t depth);
+  void CollectConnectors(SCgElements const & elements);
+  void CollectBuses(SCgElements const & elements, SCgConnectors const & connectors);
+};
@@ -0,0 +1,112 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "gwf_hot_path_counters.hpp"
+
+#if defined(GWF_TRANSLATOR_COUNT_HOT_PATHS)
+#  include <atomic>
+#  include <iostream>
+#  include <memory>
+#  include <mutex>
+#  include <vector>
+
+namespace
+{
+// Only the owning thread writes its counters, so increments don't need atomic read-modify-write operations; counters
+// are atomic so that sums can be read from other threads
+struct alignas(64) ThreadCounters
+{
+  std::array<std::atomic<uint64_t>, static_cast<std::size_t>(GWFHotPathCounters::Counter::Count)> m_values;
+};
+
+std::mutex threadCountersMutex;
+// Counters of finished threads are kept, so they are summed too
+std::vector<std::unique_ptr<ThreadCounters>> threadCounters;
+
+ThreadCounters & GetThreadCounters()
+{
+  thread_local ThreadCounters * counters = nullptr;
+  if (counters == nullptr)
+  {
+    auto newCounters = std::make_unique<ThreadCounters>();
+    counters = newCounters.get();
+    std::lock_guard<std::mutex> lock(threadCountersMutex);
+    threadCounters.push_back(std::move(newCounters));
+  }
+  return *counters;
+}
+
+// Defined after the registry, so it is destroyed before it
+struct ExitWriter
+{
+  ~ExitWriter()
+  {
+    GWFHotPathCounters::Write(std::cerr);
+  }
+} const exitWriter;
+}  // namespace
+
+void GWFHotPathCounters::Add(Counter counter, uint64_t count)
+{
+  auto & value = GetThreadCounters().m_values[static_cast<std::size_t>(counter)];
+  value.store(value.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+}
+
+GWFHotPathCounters::Values GWFHotPathCounters::Sum()
+{
+  Values values{};
+  std::lock_guard<std::mutex> lock(threadCountersMutex);
+  for (auto const & counters : threadCounters)
+  {
+    for (std::size_t i = 0; i < values.size(); ++i)
+      values[i] += counters->m_values[i].load(std::memory_order_relaxed);
+  }
+  return values;
+}
+#else
+void GWFHotPathCounters::Add(Counter, uint64_t) {}
+
+GWFHotPathCounters::Values GWFHotPathCounters::Sum()
+{
+  return {};
+}
+#endif
+
+char const * GWFHotPathCounters::GetCounterName(Counter counter)
+{
+  switch (counter)
+  {
+  case Counter::XmlPropReads:
+    return "xml_prop_reads";
+  case Counter::ElementStringAllocations:
+    return "element_string_allocations";
+  case Counter::TypeTableProbes:
+    return "type_table_probes";
+  case Counter::TypeTableMisses:
+    return "type_table_misses";
+  case Counter::RegexEvaluations:
+    return "regex_evaluations";
+  case Counter::WrittenElementsLookups:
+    return "written_elements_lookups";
+  case Counter::BufferAppends:
+    return "buffer_appends";
+  default:
+    return "unknown";
+  }
+}
+
+void GWFHotPathCounters::Write(std::ostream & stream)
+{
+  auto const & values = Sum();
+  stream << "{\"hot_path_counters\": {";
+  for (std::size_t i = 0; i < values.size(); ++i)
+  {
+    if (i > 0)
+      stream << ", ";
+    stream << "\"" << GetCounterName(static_cast<Counter>(i)) << "\": " << values[i];
+  }
+  stream << "}}\n";
+}
@@ -0,0 +1,52 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+/*!
+ * Counts the hottest operations of translations.
+ *
+ * Counting is compiled only into builds with GWF_TRANSLATOR_COUNT_HOT_PATHS defined, otherwise GWF_COUNT_HOT_PATH
+ * expands to nothing and its arguments aren't evaluated. Every thread counts into its own cache line, so counting
+ * threads don't contend, and sums of all threads are written to stderr at exit.
+ */
+class GWFHotPathCounters
+{
+public:
+  enum class Counter : std::size_t
+  {
+    XmlPropReads,
+    ElementStringAllocations,
+    TypeTableProbes,
+    TypeTableMisses,
+    RegexEvaluations,
+    WrittenElementsLookups,
+    BufferAppends,
+    Count
+  };
+
+  using Values = std::array<uint64_t, static_cast<std::size_t>(Counter::Count)>;
+
+  static void Add(Counter counter, uint64_t count);
+
+  // Sums of all threads, counters of finished threads included
+  static Values Sum();
+  static char const * GetCounterName(Counter counter);
+  static void Write(std::ostream & stream);
+};
+
+#if defined(GWF_TRANSLATOR_COUNT_HOT_PATHS)
+#  define GWF_COUNT_HOT_PATH_N(counter, count) GWFHotPathCounters::Add(GWFHotPathCounters::Counter::counter, (count))
+#else
+#  define GWF_COUNT_HOT_PATH_N(counter, count) ((void)0)
+#endif
+
+#define GWF_COUNT_HOT_PATH(counter) GWF_COUNT_HOT_PATH_N(counter, 1)
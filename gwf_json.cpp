@@ -0,0 +1,28 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "gwf_json.hpp"
+
+#include <cstdio>
+
+void GWFJSON::WriteString(std::ostream & stream, std::string_view string)
+{
+  stream << '"';
+  for (char const symbol : string)
+  {
+    if (symbol == '"' || symbol == '\\')
+      stream << '\\' << symbol;
+    else if (static_cast<unsigned char>(symbol) < 0x20)
+    {
+      char escaped[7];
+      std::snprintf(escaped, sizeof(escaped), "\\u%04x", symbol);
+      stream << escaped;
+    }
+    else
+      stream << symbol;
+  }
+  stream << '"';
+}
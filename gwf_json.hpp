@@ -0,0 +1,20 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#pragma once
+
+#include <ostream>
+#include <string_view>
+
+/*!
+ * Helpers of JSON reports: traces, graph statistics and translation stats are written by hand, without a JSON library.
+ */
+class GWFJSON
+{
+public:
+  // Writes a quoted string literal; quotes, backslashes and control characters are escaped
+  static void WriteString(std::ostream & stream, std::string_view string);
+};
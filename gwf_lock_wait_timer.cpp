@@ -0,0 +1,22 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "gwf_lock_wait_timer.hpp"
+
+namespace
+{
+thread_local GWFLockWaitTimer::Clock::duration threadWaitTime{0};
+}  // namespace
+
+double GWFLockWaitTimer::GetThreadWaitTime()
+{
+  return std::chrono::duration<double>(threadWaitTime).count();
+}
+
+void GWFLockWaitTimer::AddThreadWaitTime(Clock::duration duration)
+{
+  threadWaitTime += duration;
+}
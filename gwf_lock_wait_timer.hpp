@@ -0,0 +1,37 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#pragma once
+
+#include <chrono>
+
+/*!
+ * Time that threads wait for locks shared between translations, e.g. of the blob store or of the arena chunks.
+ *
+ * A lock is tried first and timed only if it's taken by another thread, so an uncontended lock costs what it did. Wait
+ * time is accumulated per thread; batch workers report how much of their busy time it is.
+ */
+class GWFLockWaitTimer
+{
+public:
+  using Clock = std::chrono::steady_clock;
+
+  // Seconds the calling thread has waited for locks since it started
+  static double GetThreadWaitTime();
+  static void AddThreadWaitTime(Clock::duration duration);
+
+  // Locks std::unique_lock or std::shared_lock that is constructed with std::defer_lock
+  template <class Lock>
+  static void Acquire(Lock & lock)
+  {
+    if (lock.try_lock())
+      return;
+
+    auto const start = Clock::now();
+    lock.lock();
+    AddThreadWaitTime(Clock::now() - start);
+  }
+};
@@ -0,0 +1,354 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "gwf_output_checker.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include <sc-memory/sc_debug.hpp>
+
+#include "buffer.hpp"
+#include "gwf_parser.hpp"
+#include "sc_scs_writer.hpp"
+
+namespace
+{
+std::string const WHITESPACES = " \t\r\n";
+std::string const CONNECTOR_SYMBOLS = "<>-=~|/._";
+
+std::string Trim(std::string const & string)
+{
+  size_t const begin = string.find_first_not_of(WHITESPACES);
+  if (begin == std::string::npos)
+    return "";
+
+  size_t const end = string.find_last_not_of(WHITESPACES);
+  return string.substr(begin, end - begin + 1);
+}
+
+std::string Join(std::vector<std::string>::const_iterator begin, std::vector<std::string>::const_iterator end)
+{
+  std::string result;
+  for (auto it = begin; it != end; ++it)
+  {
+    if (!result.empty())
+      result += " ";
+    result += *it;
+  }
+  return result;
+}
+
+std::string ReadFile(std::string const & filePath)
+{
+  std::ifstream file(filePath, std::ios::binary);
+  if (!file.is_open())
+    SC_THROW_EXCEPTION(
+        utils::ExceptionItemNotFound, "GWFOutputChecker::ReadFile: Unable to open `" << filePath << "`.");
+
+  std::stringstream content;
+  content << file.rdbuf();
+  return content.str();
+}
+
+void WriteFile(std::string const & filePath, std::string const & content)
+{
+  std::ofstream file(filePath, std::ios::binary);
+  file << content;
+  if (!file)
+    SC_THROW_EXCEPTION(
+        utils::ExceptionInvalidState, "GWFOutputChecker::WriteFile: Unable to write `" << filePath << "`.");
+}
+
+bool IsFileExisting(std::string const & filePath)
+{
+  return std::ifstream(filePath).is_open();
+}
+}  // namespace
+
+std::string GWFOutputChecker::TranslateWithReferencePipeline(std::string const & xmlStr)
+{
+  SCgElements elementsWithoutParents;
+  GWFParser::Parse(xmlStr, elementsWithoutParents);
+
+  Buffer buffer;
+  SCsWriter::IdentifierIndex const identifiers(elementsWithoutParents);
+  SCgElementsSet writtenElements;
+  SCsWriter::Write(elementsWithoutParents, "", buffer, 0, writtenElements, identifiers);
+  return buffer.GetValue();
+}
+
+std::string GWFOutputChecker::GetGoldenFilePath(std::string const & filePath)
+{
+  return filePath + ".scs.golden";
+}
+
+std::string GWFOutputChecker::GetGoldenErrorFilePath(std::string const & filePath)
+{
+  return filePath + ".error.golden";
+}
+
+std::size_t GWFOutputChecker::FreezeReference(std::vector<std::string> const & filePaths, Pipeline const & reference)
+{
+  std::size_t writtenCount = 0;
+  for (auto const & filePath : filePaths)
+  {
+    if (IsFileExisting(GetGoldenFilePath(filePath)) || IsFileExisting(GetGoldenErrorFilePath(filePath)))
+      continue;
+
+    std::string const & xmlStr = ReadFile(filePath);
+    std::string referenceText;
+    std::string referenceError;
+    try
+    {
+      referenceText = reference(xmlStr);
+    }
+    catch (std::exception const & exception)
+    {
+      referenceError = exception.what();
+    }
+
+    if (referenceError.empty())
+      WriteFile(GetGoldenFilePath(filePath), referenceText);
+    else
+      WriteFile(GetGoldenErrorFilePath(filePath), referenceError);
+    ++writtenCount;
+  }
+
+  return writtenCount;
+}
+
+// Reads the SCs subset the writer produces: sentences ended with `;;`, contours `identifier = [* ... *];;`, contents
+// `[...]` that may contain any symbols but `];;` and strings `"..."` with quotes and backslashes escaped
+GWFOutputChecker::Triples GWFOutputChecker::Normalize(std::string const & scsText)
+{
+  Triples triples;
+  std::vector<std::string> contours;
+  std::string lastSubject;
+  std::string statement;
+
+  auto const & getContourPath = [&]()
+  {
+    std::string path;
+    for (auto const & contour : contours)
+      path += "/" + contour;
+    return path;
+  };
+
+  for (size_t i = 0; i < scsText.size(); ++i)
+  {
+    if (scsText.compare(i, 4, "*];;") == 0)
+    {
+      if (!contours.empty())
+        contours.pop_back();
+      statement.clear();
+      i += 3;
+      continue;
+    }
+
+    std::string const & trimmedStatement = Trim(statement);
+    if (scsText.compare(i, 2, "[*") == 0 && !trimmedStatement.empty() && trimmedStatement.back() == '=')
+    {
+      std::string const & contour = Trim(trimmedStatement.substr(0, trimmedStatement.size() - 1));
+      ++triples[getContourPath() + " | " + contour + " = [* *]"];
+      contours.push_back(contour);
+      statement.clear();
+      ++i;
+      continue;
+    }
+
+    if (scsText[i] == '[')
+    {
+      size_t const end = scsText.find("];;", i);
+      if (end == std::string::npos)
+      {
+        statement.append(scsText, i);
+        break;
+      }
+
+      statement.append(scsText, i, end + 1 - i);
+      i = end;
+      continue;
+    }
+
+    if (scsText[i] == '"')
+    {
+      size_t end = i + 1;
+      while (end < scsText.size() && scsText[end] != '"')
+        end += scsText[end] == '\\' ? 2 : 1;
+
+      statement.append(scsText, i, end + 1 - i);
+      i = end;
+      continue;
+    }
+
+    if (scsText.compare(i, 2, ";;") == 0)
+    {
+      AddStatement(getContourPath(), statement, lastSubject, triples);
+      statement.clear();
+      ++i;
+      continue;
+    }
+
+    statement += scsText[i];
+  }
+
+  if (!Trim(statement).empty())
+    AddStatement(getContourPath(), statement, lastSubject, triples);
+
+  return triples;
+}
+
+// A sentence without subject, e.g. content of a link written under its type, continues the previous subject
+void GWFOutputChecker::AddStatement(
+    std::string const & contourPath,
+    std::string const & statement,
+    std::string & lastSubject,
+    Triples & triples)
+{
+  size_t const contentBegin = statement.find('[');
+  std::vector<std::string> tokens;
+  std::istringstream stream(statement.substr(0, contentBegin));
+  for (std::string token; stream >> token;)
+    tokens.push_back(token);
+  if (contentBegin != std::string::npos)
+    tokens.push_back(statement.substr(contentBegin, statement.rfind(']') + 1 - contentBegin));
+
+  if (tokens.empty())
+    return;
+
+  auto const connectorIt = std::find_if(tokens.cbegin(), tokens.cend(), IsConnector);
+  if (connectorIt == tokens.cend())
+  {
+    lastSubject = Join(tokens.cbegin(), tokens.cend());
+    ++triples[contourPath + " | " + lastSubject];
+    return;
+  }
+
+  std::string subject = Join(tokens.cbegin(), connectorIt);
+  if (subject.empty())
+    subject = lastSubject;
+  else
+    lastSubject = subject;
+
+  auto objectIt = connectorIt + 1;
+  auto const attributeEndIt = std::find_if(
+      objectIt,
+      tokens.cend(),
+      [](std::string const & token)
+      {
+        return token.back() == ':' && token.front() != '[';
+      });
+  std::string attribute;
+  if (attributeEndIt != tokens.cend())
+  {
+    attribute = Join(objectIt, attributeEndIt + 1);
+    objectIt = attributeEndIt + 1;
+  }
+  std::string object = Join(objectIt, tokens.cend());
+
+  std::string connector = *connectorIt;
+  if (TurnConnector(connector) != connector)
+  {
+    connector = TurnConnector(connector);
+    std::swap(subject, object);
+  }
+
+  std::string const & attributePart = attribute.empty() ? "" : attribute + " ";
+  ++triples[contourPath + " | " + subject + " " + connector + " " + attributePart + object];
+}
+
+bool GWFOutputChecker::IsConnector(std::string const & token)
+{
+  return !token.empty() && token.find_first_not_of(CONNECTOR_SYMBOLS) == std::string::npos
+         && token.find_first_of("<>=") != std::string::npos;
+}
+
+// Turns a left-directed connector to the right, e.g. `<-` to `->` and `_<|-` to `_-|>`. Other connectors are returned
+// as they are.
+std::string GWFOutputChecker::TurnConnector(std::string const & connector)
+{
+  size_t const begin = connector.find_first_not_of('_');
+  if (begin == std::string::npos || connector[begin] != '<' || connector.back() == '>')
+    return connector;
+
+  std::string turned(connector.crbegin(), connector.crend() - begin);
+  std::replace(turned.begin(), turned.end(), '<', '>');
+  return connector.substr(0, begin) + turned;
+}
+
+std::string GWFOutputChecker::FindFirstDivergence(Triples const & reference, Triples const & candidate)
+{
+  auto referenceIt = reference.cbegin();
+  auto candidateIt = candidate.cbegin();
+  while (referenceIt != reference.cend() || candidateIt != candidate.cend())
+  {
+    if (candidateIt == candidate.cend() || (referenceIt != reference.cend() && referenceIt->first < candidateIt->first))
+      return "missing `" + referenceIt->first + "`";
+
+    if (referenceIt == reference.cend() || candidateIt->first < referenceIt->first)
+      return "unexpected `" + candidateIt->first + "`";
+
+    if (referenceIt->second != candidateIt->second)
+      return "`" + referenceIt->first + "` occurs " + std::to_string(candidateIt->second) + " times instead of "
+             + std::to_string(referenceIt->second);
+
+    ++referenceIt;
+    ++candidateIt;
+  }
+
+  return "";
+}
+
+std::vector<GWFOutputChecker::Divergence> GWFOutputChecker::Check(
+    std::vector<std::string> const & filePaths,
+    Pipeline const & candidate)
+{
+  std::vector<Divergence> divergences;
+  for (auto const & filePath : filePaths)
+  {
+    std::string const & xmlStr = ReadFile(filePath);
+
+    std::string referenceText;
+    std::string referenceError;
+    if (IsFileExisting(GetGoldenFilePath(filePath)))
+      referenceText = ReadFile(GetGoldenFilePath(filePath));
+    else if (IsFileExisting(GetGoldenErrorFilePath(filePath)))
+      referenceError = ReadFile(GetGoldenErrorFilePath(filePath));
+    else
+    {
+      divergences.push_back({filePath, "no golden files, the reference isn't frozen"});
+      continue;
+    }
+
+    std::string candidateText;
+    std::string candidateError;
+    try
+    {
+      candidateText = candidate(xmlStr);
+    }
+    catch (std::exception const & exception)
+    {
+      candidateError = exception.what();
+    }
+
+    if (!referenceError.empty() || !candidateError.empty())
+    {
+      if (referenceError.empty())
+        divergences.push_back({filePath, "only candidate fails: " + candidateError});
+      else if (candidateError.empty())
+        divergences.push_back({filePath, "only reference fails: " + referenceError});
+      continue;
+    }
+
+    std::string const & divergence = FindFirstDivergence(Normalize(referenceText), Normalize(candidateText));
+    if (!divergence.empty())
+      divergences.push_back({filePath, divergence});
+  }
+
+  return divergences;
+}
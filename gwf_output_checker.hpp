@@ -0,0 +1,70 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+/*!
+ * Checks that an optimized translation pipeline produces the same knowledge as the reference one, GWFParser with
+ * SCsWriter.
+ *
+ * The reference is frozen: FreezeReference writes its output for every gwf-file next to it, as `<file>.scs.golden`,
+ * or its error as `<file>.error.golden`, and never overwrites existing ones. Check compares candidates with these
+ * golden files, so changes of the parser or the writer don't move the reference along with the candidate. Golden
+ * files are frozen at a trusted revision and kept with the corpus.
+ *
+ * Outputs aren't compared as texts, because statements follow unordered_map iteration order. Both outputs are
+ * normalized into multisets of triples instead: every statement becomes `subject connector attribute: object`,
+ * prefixed with the path of contours it's written in, and left-directed connectors are turned around.
+ */
+class GWFOutputChecker
+{
+public:
+  // Translates content of a gwf-file to SCs text
+  using Pipeline = std::function<std::string(std::string const & xmlStr)>;
+  // Normalized triple -> number of its occurrences
+  using Triples = std::map<std::string, std::size_t>;
+
+  struct Divergence
+  {
+    std::string m_filePath;
+    std::string m_description;
+  };
+
+  static std::string TranslateWithReferencePipeline(std::string const & xmlStr);
+
+  static std::string GetGoldenFilePath(std::string const & filePath);
+  static std::string GetGoldenErrorFilePath(std::string const & filePath);
+
+  // Writes golden files of files that have none yet. Returns the number of files written.
+  static std::size_t FreezeReference(
+      std::vector<std::string> const & filePaths,
+      Pipeline const & reference = TranslateWithReferencePipeline);
+
+  static Triples Normalize(std::string const & scsText);
+
+  // Describes the first triple, in sorted order, that occurs in one set more times than in the other. Empty if sets
+  // are equal.
+  static std::string FindFirstDivergence(Triples const & reference, Triples const & candidate);
+
+  // Translates every file with the candidate and compares it with the golden files. A file is also divergent if only
+  // one of pipelines fails on it, or if it has no golden files.
+  static std::vector<Divergence> Check(std::vector<std::string> const & filePaths, Pipeline const & candidate);
+
+private:
+  static bool IsConnector(std::string const & token);
+  static std::string TurnConnector(std::string const & connector);
+  static void AddStatement(
+      std::string const & contourPath,
+      std::string const & statement,
+      std::string & lastSubject,
+      Triples & triples);
+};
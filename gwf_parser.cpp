@@ -6,200 +6,921 @@
 
 #include "gwf_parser.hpp"
 
+#include <exception>
+#include <fstream>
 #include <iostream>
 
-#include <sc-memory/utils/sc_base64.hpp>
+#include <libxml/parserInternals.h>
+
 #include <sc-memory/sc_debug.hpp>
 
+#include "gwf_base64_decoder.hpp"
+#include "gwf_hot_path_counters.hpp"
+#include "gwf_validator.hpp"
 #include "sc_scg_element.hpp"
 
 using namespace Constants;
 
+namespace
+{
+// Smaller contents aren't worth a write to the spill file, they stay in memory even if the budget is exhausted
+std::size_t const MIN_SPILLED_CONTENT_SIZE = 4 * 1024;
+// Decoded bytes of an image content are moved to the blob store, or counted against the memory budget of the spill
+// file, in steps of this size while the content is read
+std::size_t const LARGE_CONTENT_SIZE = 1024 * 1024;
+std::size_t const FILE_CHUNK_SIZE = 64 * 1024;
+// Contents of links, e.g. images, may be larger than libxml2 lets text nodes be by default
+int const XML_PARSE_OPTIONS = XML_PARSE_HUGE;
+
+// Element, its strings and its reference counter are allocated together from the resource of a translation
+template <class Element, class... Args>
+std::shared_ptr<Element> MakeElement(std::pmr::memory_resource * resource, Args &&... args)
+{
+  return std::allocate_shared<Element>(
+      std::pmr::polymorphic_allocator<Element>(resource), std::forward<Args>(args)..., resource);
+}
+
+/*
+ * Builds a document like xmlReadMemory does, but without text of image content nodes, which is collected into detached
+ * contents.
+ *
+ * SAX2 handlers of the document builder are wrapped. If contents are deferred, characters of an image content node that
+ * libxml2 passes right from its copy of the gwf text are only counted into a range of the text. Otherwise, or once the
+ * text of the node turns out not to be verbatim in the gwf text, because of a reference, a CDATA section, a line break
+ * normalization or an input encoding, the characters are decoded as they come. Decoded bytes of a content that grows
+ * too large to be held in memory are moved to the blob store chunk by chunk, or to the spill file once they don't fit
+ * into its memory budget.
+ *
+ * Handlers of libxml2 must not throw, so the first error stops the parser and is rethrown once it returns.
+ */
+class ContentDetachingReader
+{
+public:
+  explicit ContentDetachingReader(GWFContentStorage const & storage)
+    : m_storage(storage)
+    , m_detachedContents(*storage.m_detachedContents)
+    , m_xmlStr(nullptr)
+    , m_defaultHandler()
+    , m_contentNode(nullptr)
+    , m_isDeferring(false)
+    , m_contentBegin(0)
+    , m_contentEnd(0)
+    , m_movedSize(0)
+    , m_reservedSize(0)
+  {
+  }
+
+  xmlDocPtr ReadMemory(std::string const & xmlStr, char const * documentName)
+  {
+    m_xmlStr = &xmlStr;
+
+    ParserContextPtr context(xmlCreateMemoryParserCtxt(xmlStr.c_str(), xmlStr.size()), FreeContext);
+    if (context == nullptr)
+      return nullptr;
+
+    xmlCtxtUseOptions(context.get(), XML_PARSE_OPTIONS);
+    if (context->input->filename == nullptr)
+      context->input->filename = reinterpret_cast<char *>(xmlStrdup(BAD_CAST documentName));
+    WrapHandlers(context.get());
+
+    xmlParseDocument(context.get());
+    return TakeDocument(context.get());
+  }
+
+  xmlDocPtr ReadFile(std::string const & filePath, std::size_t & fileSize)
+  {
+    std::ifstream file(filePath, std::ios::binary);
+    if (!file.is_open())
+      SC_THROW_EXCEPTION(
+          utils::ExceptionParseError, "GWFParser::ParseFile: Failed to open XML file `" << filePath << "`.");
+
+    ParserContextPtr context(
+        xmlCreatePushParserCtxt(nullptr, nullptr, nullptr, 0, filePath.c_str()), FreeContext);
+    if (context == nullptr)
+      return nullptr;
+
+    xmlCtxtUseOptions(context.get(), XML_PARSE_OPTIONS);
+    WrapHandlers(context.get());
+
+    fileSize = 0;
+    std::vector<char> chunk(FILE_CHUNK_SIZE);
+    while (!context->disableSAX)
+    {
+      file.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+      auto const size = static_cast<std::size_t>(file.gcount());
+      if (file.bad())
+        SC_THROW_EXCEPTION(
+            utils::ExceptionParseError, "GWFParser::ParseFile: Failed to read XML file `" << filePath << "`.");
+      if (size == 0)
+        break;
+
+      fileSize += size;
+      xmlParseChunk(context.get(), chunk.data(), static_cast<int>(size), 0);
+    }
+    xmlParseChunk(context.get(), nullptr, 0, 1);
+
+    return TakeDocument(context.get());
+  }
+
+private:
+  // A document isn't taken from the context if reading throws in the middle of it, it's freed with the context then
+  static void FreeContext(xmlParserCtxtPtr context)
+  {
+    xmlFreeDoc(context->myDoc);
+    xmlFreeParserCtxt(context);
+  }
+
+  using ParserContextPtr = std::unique_ptr<xmlParserCtxt, decltype(&FreeContext)>;
+
+  GWFContentStorage const & m_storage;
+  GWFDetachedContents & m_detachedContents;
+  // Gwf text, if the whole of it is in memory
+  std::string const * m_xmlStr;
+  xmlSAXHandler m_defaultHandler;
+  std::exception_ptr m_error;
+
+  // Image content node which text is being collected, if any
+  xmlNodePtr m_contentNode;
+  bool m_isDeferring;
+  std::size_t m_contentBegin;
+  std::size_t m_contentEnd;
+
+  GWFBase64Decoder m_decoder;
+  // Bytes that are decoded and not moved out of memory yet
+  std::pmr::string m_decodedContent;
+  std::size_t m_movedSize;
+  // Bytes counted against the memory budget of the spill file
+  std::size_t m_reservedSize;
+  std::unique_ptr<GWFBlobStore::Writer> m_blobWriter;
+  std::optional<GWFSpillFile::Range> m_spilledContent;
+
+  void WrapHandlers(xmlParserCtxtPtr context)
+  {
+    m_defaultHandler = *context->sax;
+    context->sax->startElementNs = StartElement;
+    context->sax->endElementNs = EndElement;
+    context->sax->characters = Characters;
+    context->sax->ignorableWhitespace = IgnorableWhitespace;
+    context->sax->cdataBlock = CDataBlock;
+    context->sax->reference = Reference;
+    context->sax->comment = Comment;
+    context->sax->processingInstruction = ProcessingInstruction;
+    context->_private = this;
+  }
+
+  xmlDocPtr TakeDocument(xmlParserCtxtPtr context)
+  {
+    xmlDocPtr document = context->myDoc;
+    context->myDoc = nullptr;
+    if (m_error != nullptr || !context->wellFormed)
+    {
+      xmlFreeDoc(document);
+      m_detachedContents.clear();
+      if (m_error != nullptr)
+        std::rethrow_exception(m_error);
+      return nullptr;
+    }
+
+    return document;
+  }
+
+  static ContentDetachingReader & GetReader(xmlParserCtxtPtr context)
+  {
+    return *static_cast<ContentDetachingReader *>(context->_private);
+  }
+
+  // Every attribute is given by its local name, prefix, URI, value beginning and value end
+  static std::string_view FindAttribute(std::string const & name, int attributesCount, xmlChar const ** attributes)
+  {
+    for (int i = 0; i < attributesCount; ++i)
+    {
+      xmlChar const ** attribute = attributes + i * 5;
+      if (xmlStrEqual(attribute[0], BAD_CAST name.c_str()))
+        return {reinterpret_cast<char const *>(attribute[3]), static_cast<std::size_t>(attribute[4] - attribute[3])};
+    }
+    return {};
+  }
+
+  bool IsInContent(xmlParserCtxtPtr context) const
+  {
+    return m_contentNode != nullptr && m_contentNode == context->node;
+  }
+
+  // Runs an action of a handler, the first error of which stops the parser
+  template <class Action>
+  void Try(xmlParserCtxtPtr context, Action const & action)
+  {
+    if (m_error != nullptr)
+      return;
+
+    try
+    {
+      action();
+    }
+    catch (...)
+    {
+      m_error = std::current_exception();
+      xmlStopParser(context);
+    }
+  }
+
+  static void StartElement(
+      void * userData,
+      xmlChar const * localName,
+      xmlChar const * prefix,
+      xmlChar const * uri,
+      int namespacesCount,
+      xmlChar const ** namespaces,
+      int attributesCount,
+      int defaultedAttributesCount,
+      xmlChar const ** attributes)
+  {
+    auto * context = static_cast<xmlParserCtxtPtr>(userData);
+    ContentDetachingReader & reader = GetReader(context);
+    if (reader.IsInContent(context))
+    {
+      reader.Try(
+          context,
+          [&]()
+          {
+            SC_THROW_EXCEPTION(
+                utils::ExceptionParseError,
+                "GWFParser: Image content can't contain element `" << reinterpret_cast<char const *>(localName)
+                                                                   << "`.");
+          });
+      return;
+    }
+
+    reader.m_defaultHandler.startElementNs(
+        userData,
+        localName,
+        prefix,
+        uri,
+        namespacesCount,
+        namespaces,
+        attributesCount,
+        defaultedAttributesCount,
+        attributes);
+
+    if (context->node != nullptr && xmlStrEqual(localName, CONTENT)
+        && FindAttribute(TYPE, attributesCount, attributes) == "4")
+      reader.StartContent(context->node);
+  }
+
+  static void EndElement(void * userData, xmlChar const * localName, xmlChar const * prefix, xmlChar const * uri)
+  {
+    auto * context = static_cast<xmlParserCtxtPtr>(userData);
+    ContentDetachingReader & reader = GetReader(context);
+    if (reader.IsInContent(context))
+      reader.Try(
+          context,
+          [&reader]()
+          {
+            reader.FinishContent();
+          });
+    reader.m_defaultHandler.endElementNs(userData, localName, prefix, uri);
+  }
+
+  static void Characters(void * userData, xmlChar const * characters, int size)
+  {
+    auto * context = static_cast<xmlParserCtxtPtr>(userData);
+    ContentDetachingReader & reader = GetReader(context);
+    if (!reader.IsInContent(context))
+      reader.m_defaultHandler.characters(userData, characters, size);
+    else if (!reader.Defer(context, characters, size))
+      reader.Decode(context, reinterpret_cast<char const *>(characters), size);
+  }
+
+  static void IgnorableWhitespace(void * userData, xmlChar const * characters, int size)
+  {
+    auto * context = static_cast<xmlParserCtxtPtr>(userData);
+    ContentDetachingReader & reader = GetReader(context);
+    if (!reader.IsInContent(context))
+      reader.m_defaultHandler.ignorableWhitespace(userData, characters, size);
+    else if (!reader.Defer(context, characters, size))
+      reader.Decode(context, reinterpret_cast<char const *>(characters), size);
+  }
+
+  static void CDataBlock(void * userData, xmlChar const * value, int size)
+  {
+    auto * context = static_cast<xmlParserCtxtPtr>(userData);
+    ContentDetachingReader & reader = GetReader(context);
+    if (!reader.IsInContent(context))
+      reader.m_defaultHandler.cdataBlock(userData, value, size);
+    else
+    {
+      reader.StopDeferring(context);
+      reader.Decode(context, reinterpret_cast<char const *>(value), size);
+    }
+  }
+
+  // Text of entities isn't known to SAX handlers, so references to them are only allowed outside of image contents
+  static void Reference(void * userData, xmlChar const * name)
+  {
+    auto * context = static_cast<xmlParserCtxtPtr>(userData);
+    ContentDetachingReader & reader = GetReader(context);
+    if (!reader.IsInContent(context))
+      reader.m_defaultHandler.reference(userData, name);
+    else
+      reader.Try(
+          context,
+          [name]()
+          {
+            SC_THROW_EXCEPTION(
+                utils::ExceptionParseError,
+                "GWFParser: Image content can't contain reference to entity `" << reinterpret_cast<char const *>(name)
+                                                                                << "`.");
+          });
+  }
+
+  static void Comment(void * userData, xmlChar const * value)
+  {
+    auto * context = static_cast<xmlParserCtxtPtr>(userData);
+    GetReader(context).StopDeferring(context);
+    GetReader(context).m_defaultHandler.comment(userData, value);
+  }
+
+  static void ProcessingInstruction(void * userData, xmlChar const * target, xmlChar const * data)
+  {
+    auto * context = static_cast<xmlParserCtxtPtr>(userData);
+    GetReader(context).StopDeferring(context);
+    GetReader(context).m_defaultHandler.processingInstruction(userData, target, data);
+  }
+
+  void StartContent(xmlNodePtr contentNode)
+  {
+    m_contentNode = contentNode;
+    m_isDeferring = m_xmlStr != nullptr && m_storage.m_isContentDeferred && m_storage.m_blobStore == nullptr;
+    m_contentBegin = 0;
+    m_contentEnd = 0;
+    m_decoder = GWFBase64Decoder();
+    m_movedSize = 0;
+    m_reservedSize = 0;
+    m_spilledContent.reset();
+  }
+
+  void FinishContent()
+  {
+    xmlNodePtr const contentNode = m_contentNode;
+    m_contentNode = nullptr;
+
+    GWFDetachedContent content;
+    if (m_isDeferring && m_contentEnd != m_contentBegin)
+      content.m_encodedContent = std::string_view(*m_xmlStr).substr(m_contentBegin, m_contentEnd - m_contentBegin);
+    else
+    {
+      std::size_t const size = m_decodedContent.size();
+      m_decodedContent.resize(size + 2);
+      m_decodedContent.resize(size + m_decoder.Finish(m_decodedContent.data() + size));
+
+      if (m_blobWriter != nullptr)
+      {
+        MoveDecodedContent();
+        content.m_storedContentPath = m_blobWriter->Finish();
+        content.m_storedContentSize = m_movedSize;
+        m_blobWriter.reset();
+      }
+      else
+      {
+        if (m_storage.m_blobStore == nullptr && m_storage.m_spillFile != nullptr && !m_spilledContent
+            && m_decodedContent.size() >= MIN_SPILLED_CONTENT_SIZE)
+          ReserveOrSpill();
+
+        if (m_spilledContent)
+        {
+          MoveDecodedContent();
+          content.m_spilledContent = m_spilledContent;
+        }
+        else
+          content.m_decodedContent = std::move(m_decodedContent);
+      }
+    }
+
+    m_decodedContent.clear();
+    m_detachedContents.emplace(contentNode, std::move(content));
+  }
+
+  // Extends the range of the content node if characters are the next ones of the gwf text
+  bool Defer(xmlParserCtxtPtr context, xmlChar const * characters, int size)
+  {
+    if (!m_isDeferring)
+      return false;
+    if (size <= 0)
+      return true;
+
+    xmlParserInputPtr const input = context->input;
+    if (context->inputNr == 1 && input->buf != nullptr && input->buf->encoder == nullptr && characters >= input->base
+        && characters + size <= input->end)
+    {
+      std::size_t const begin = input->consumed + (characters - input->base);
+      bool const isNext = m_contentEnd == m_contentBegin || begin == m_contentEnd;
+      if (isNext && begin + size <= m_xmlStr->size() && (*m_xmlStr)[begin] == char(characters[0])
+          && (*m_xmlStr)[begin + size - 1] == char(characters[size - 1]))
+      {
+        if (m_contentEnd == m_contentBegin)
+          m_contentBegin = begin;
+        m_contentEnd = begin + size;
+        return true;
+      }
+    }
+
+    StopDeferring(context);
+    return false;
+  }
+
+  // Decodes the characters collected for the content node
+  void StopDeferring(xmlParserCtxtPtr context)
+  {
+    if (!IsInContent(context) || !m_isDeferring)
+      return;
+
+    m_isDeferring = false;
+    Decode(context, m_xmlStr->data() + m_contentBegin, static_cast<int>(m_contentEnd - m_contentBegin));
+  }
+
+  void Decode(xmlParserCtxtPtr context, char const * characters, int size)
+  {
+    Try(context,
+        [&]()
+        {
+          std::size_t const decodedSize = m_decodedContent.size();
+          m_decodedContent.resize(decodedSize + GWFBase64Decoder::GetMaxDecodedSize(size));
+          m_decodedContent.resize(
+              decodedSize + m_decoder.DecodeChunk(characters, size, m_decodedContent.data() + decodedSize));
+
+          if (m_storage.m_blobStore != nullptr)
+          {
+            if (m_decodedContent.size() >= LARGE_CONTENT_SIZE)
+              MoveDecodedContent();
+          }
+          else if (m_storage.m_spillFile != nullptr)
+          {
+            if (m_spilledContent)
+            {
+              if (m_decodedContent.size() >= LARGE_CONTENT_SIZE)
+                MoveDecodedContent();
+            }
+            else if (m_decodedContent.size() >= m_reservedSize + LARGE_CONTENT_SIZE)
+              ReserveOrSpill();
+          }
+        });
+  }
+
+  // Counts decoded bytes against the memory budget, or spills them if they don't fit in it
+  void ReserveOrSpill()
+  {
+    GWFSpillFile * spillFile = m_storage.m_spillFile;
+    if (spillFile->TryReserve(m_decodedContent.size() - m_reservedSize))
+      m_reservedSize = m_decodedContent.size();
+    else
+    {
+      spillFile->Release(m_reservedSize);
+      m_reservedSize = 0;
+      MoveDecodedContent();
+      // Memory that held the reserved bytes isn't needed for the rest of the content
+      std::pmr::string().swap(m_decodedContent);
+    }
+  }
+
+  // Writes are appended to the spill file, so the ones of a content that is read make up one range
+  void MoveDecodedContent()
+  {
+    if (m_storage.m_blobStore != nullptr)
+    {
+      if (m_blobWriter == nullptr)
+        m_blobWriter = std::make_unique<GWFBlobStore::Writer>(*m_storage.m_blobStore);
+      m_blobWriter->Write(m_decodedContent.data(), m_decodedContent.size());
+    }
+    else
+    {
+      auto const & range = m_storage.m_spillFile->Write(m_decodedContent.data(), m_decodedContent.size());
+      if (!m_spilledContent)
+        m_spilledContent = range;
+      else if (range.m_offset == m_spilledContent->m_offset + m_spilledContent->m_size)
+        m_spilledContent->m_size += range.m_size;
+      else
+        SC_THROW_EXCEPTION(utils::ExceptionCritical, "GWFParser: Image content has been spilled in pieces.");
+    }
+
+    m_movedSize += m_decodedContent.size();
+    m_decodedContent.clear();
+  }
+};
+}  // namespace
+
 void XmlCharDeleter::operator()(xmlChar * ptr) const
 {
   if (ptr != nullptr)
     xmlFree(ptr);
 }
 
-void GWFParser::Parse(std::string const & xmlStr, SCgElements & elements)
+void GWFParser::Parse(
+    std::string const & xmlStr,
+    SCgElements & elements,
+    GWFTranslatorStats * stats,
+    GWFContentStorage const & storage,
+    std::string const & filePath)
 {
   xmlInitParser();
 
-  auto xmlTree = std::unique_ptr<xmlDoc, decltype(&xmlFreeDoc)>(
-      xmlReadMemory(xmlStr.c_str(), xmlStr.size(), "noname.xml", nullptr, 0), xmlFreeDoc);
-  if (xmlTree == nullptr)
-    SC_THROW_EXCEPTION(utils::ExceptionParseError, "Failed to open XML xmlTree.");
+  GWFDetachedContents detachedContents(elements.get_allocator().resource());
+  GWFContentStorage documentStorage = storage;
+  if (documentStorage.m_detachedContents == nullptr)
+    documentStorage.m_detachedContents = &detachedContents;
 
-  xmlNodePtr rootElement = xmlDocGetRootElement(xmlTree.get());
-  xmlNodePtr staticSector = nullptr;
+  XmlDocumentPtr xmlTree(nullptr, xmlFreeDoc);
+  {
+    GWFTranslatorStats::ScopedMeasurement const measurement(stats, GWFTranslatorStats::Phase::XMLParse);
+    xmlTree = ReadDocument(xmlStr, documentStorage, filePath);
+  }
+  ParseDocument(std::move(xmlTree), elements, stats, documentStorage);
+}
 
-  for (xmlNodePtr node = rootElement->children; node != nullptr; node = node->next)
+void GWFParser::Parse(
+    std::string && xmlStr,
+    SCgElements & elements,
+    GWFTranslatorStats * stats,
+    GWFContentStorage const & storage,
+    std::string const & filePath)
+{
+  xmlInitParser();
+
+  GWFDetachedContents detachedContents(elements.get_allocator().resource());
+  GWFContentStorage const documentStorage = {
+      storage.m_blobStore, storage.m_spillFile, storage.m_isContentDeferred, &detachedContents};
+
+  XmlDocumentPtr xmlTree(nullptr, xmlFreeDoc);
   {
-    if (xmlStrEqual(node->name, STATIC_SECTOR))
+    GWFTranslatorStats::ScopedMeasurement const measurement(stats, GWFTranslatorStats::Phase::XMLParse);
+    xmlTree = ReadDocument(xmlStr, documentStorage, filePath);
+    for (auto & [node, content] : detachedContents)
     {
-      staticSector = node;
-      break;
+      if (content.m_encodedContent.empty())
+        continue;
+
+      content.m_keptEncodedContent = content.m_encodedContent;
+      content.m_encodedContent = content.m_keptEncodedContent;
     }
+    std::string().swap(xmlStr);
   }
+  ParseDocument(std::move(xmlTree), elements, stats, documentStorage);
+}
 
-  if (staticSector == nullptr)
-    SC_THROW_EXCEPTION(utils::ExceptionParseError, "StaticSector not found in XML xmlTree.");
+std::size_t GWFParser::ParseFile(
+    std::string const & filePath,
+    SCgElements & elements,
+    GWFTranslatorStats * stats,
+    GWFContentStorage const & storage)
+{
+  xmlInitParser();
+
+  GWFDetachedContents detachedContents(elements.get_allocator().resource());
+  GWFContentStorage const documentStorage = {storage.m_blobStore, storage.m_spillFile, false, &detachedContents};
+
+  std::size_t fileSize = 0;
+  XmlDocumentPtr xmlTree(nullptr, xmlFreeDoc);
+  {
+    GWFTranslatorStats::ScopedMeasurement const measurement(stats, GWFTranslatorStats::Phase::XMLParse);
+    xmlTree.reset(ContentDetachingReader(documentStorage).ReadFile(filePath, fileSize));
+    if (xmlTree == nullptr)
+      SC_THROW_EXCEPTION(
+          utils::ExceptionParseError, "GWFParser::ParseFile: Failed to parse XML file `" << filePath << "`.");
+  }
+  ParseDocument(std::move(xmlTree), elements, stats, documentStorage);
+  return fileSize;
+}
+
+void GWFParser::ParseDocument(
+    XmlDocumentPtr xmlTree,
+    SCgElements & elements,
+    GWFTranslatorStats * stats,
+    GWFContentStorage const & storage)
+{
+  using Phase = GWFTranslatorStats::Phase;
+
+  xmlNodePtr const staticSector = FindStaticSector(xmlTree.get());
 
   if (staticSector->children == nullptr)
     return;
 
-  ProcessStaticSector(staticSector, elements);
-  xmlCleanupParser();
+  std::pmr::memory_resource * resource = elements.get_allocator().resource();
+  // A broken document fails with all of its problems before any element is created
+  {
+    GWFTranslatorStats::ScopedMeasurement const measurement(stats, Phase::Validation);
+    GWFValidator::Check(staticSector, resource);
+  }
+
+  SCgElements allElements(resource);
+  SCgConnectors connectors(resource);  // connectors = {connector: (sourceId, targetId)}
+  SCgContours contours(resource);
+  {
+    GWFTranslatorStats::ScopedMeasurement const measurement(stats, Phase::ElementCreation);
+    ProcessStaticSector(staticSector, elements, allElements, connectors, contours, storage);
+  }
+  // Elements hold copies of everything they need from the document
+  xmlTree.reset();
+
+  if (stats != nullptr)
+    CountElements(allElements, stats->m_elements);
+
+  // To correctly process contours and connectors all elements are first collected, then the contours and connectors are
+  // assigned elements
+  {
+    GWFTranslatorStats::ScopedMeasurement const measurement(stats, Phase::ConnectorResolution);
+    FillConnectors(connectors, allElements);
+  }
+  {
+    GWFTranslatorStats::ScopedMeasurement const measurement(stats, Phase::ContourResolution);
+    FillContours(contours, allElements);
+  }
 }
 
-void GWFParser::ProcessStaticSector(xmlNodePtr staticSector, SCgElements & elementsWithoutParents)
+GWFParser::XmlDocumentPtr GWFParser::ReadDocument(
+    std::string const & xmlStr,
+    GWFContentStorage const & storage,
+    std::string const & filePath)
 {
-  SCgElements allElements;
-  SCgConnectors connectors;  // connectors = {connector: (sourceId, targetId)}
-  SCgContours contours;
+  char const * documentName = filePath.empty() ? "noname.xml" : filePath.c_str();
+  XmlDocumentPtr xmlTree(nullptr, xmlFreeDoc);
+  if (storage.m_detachedContents != nullptr)
+    xmlTree.reset(ContentDetachingReader(storage).ReadMemory(xmlStr, documentName));
+  else
+    xmlTree.reset(xmlReadMemory(xmlStr.c_str(), xmlStr.size(), documentName, nullptr, XML_PARSE_OPTIONS));
+  if (xmlTree == nullptr)
+    SC_THROW_EXCEPTION(
+        utils::ExceptionParseError, "GWFParser::ReadDocument: Failed to parse XML file `" << documentName << "`.");
+
+  return xmlTree;
+}
 
+xmlNodePtr GWFParser::FindStaticSector(xmlDocPtr document)
+{
+  xmlNodePtr rootElement = xmlDocGetRootElement(document);
+
+  for (xmlNodePtr node = rootElement->children; node != nullptr; node = node->next)
+  {
+    if (xmlStrEqual(node->name, STATIC_SECTOR))
+      return node;
+  }
+
+  SC_THROW_EXCEPTION(utils::ExceptionParseError, "StaticSector not found in XML xmlTree.");
+}
+
+void GWFParser::ProcessStaticSector(
+    xmlNodePtr staticSector,
+    SCgElements & elementsWithoutParents,
+    SCgElements & allElements,
+    SCgConnectors & connectors,
+    SCgContours & contours,
+    GWFContentStorage const & storage)
+{
+  std::pmr::memory_resource * resource = allElements.get_allocator().resource();
   for (xmlNodePtr child = staticSector->children; child != nullptr; child = child->next)
   {
     if (child->type == XML_ELEMENT_NODE)
     {
-      auto const id = GetXmlPropStr(child, ID);
-      auto const parent = GetXmlPropStr(child, PARENT);
-      auto const identifier = GetXmlPropStr(child, IDENTIFIER);
-      auto const type = GetXmlPropStr(child, TYPE);
-      auto const tag = XmlCharToString(std::unique_ptr<xmlChar, XmlCharDeleter>(xmlStrdup(child->name)));
+      auto const id = GetXmlPropStr(child, ID, resource);
+      auto const parent = GetXmlPropStr(child, PARENT, resource);
+      auto const identifier = GetXmlPropStr(child, IDENTIFIER, resource);
+      auto const type = GetXmlPropStr(child, TYPE, resource);
+      std::string_view const tag(reinterpret_cast<char const *>(child->name));
 
       SCgElementPtr scgElement;
       if (tag == NODE)
       {
         if (HasContent(child))
-          scgElement = CreateLink(id, parent, identifier, type, tag, child);
+          scgElement = CreateLink(id, parent, identifier, type, tag, child, storage, resource);
         else
-          scgElement = CreateNode(id, parent, identifier, type, tag);
+          scgElement = CreateNode(id, parent, identifier, type, tag, resource);
       }
       else if (tag == BUS)
-        scgElement = CreateBus(id, parent, identifier, type, tag, child);
+        scgElement = CreateBus(id, parent, identifier, type, tag, child, resource);
       else if (tag == CONTOUR)
-        scgElement = CreateContour(id, parent, identifier, type, tag);
+        scgElement = CreateContour(id, parent, identifier, type, tag, resource);
       else if (tag == PAIR || tag == ARC)
-        scgElement = CreateConnector(id, parent, identifier, type, tag, child, connectors);
+        scgElement = CreateConnector(id, parent, identifier, type, tag, child, connectors, resource);
       else
         SC_THROW_EXCEPTION(
             utils::ExceptionParseError, "GWFParser::ProcessStaticSector: Unknown tag  " << tag << " with id " << id);
 
-      if (parent == NO_PARENT)
-        elementsWithoutParents[id] = scgElement;
+      // Keys are views of the id that the element holds
+      std::string_view const elementId = scgElement->GetId();
+      if (std::string_view(parent) == NO_PARENT)
+        elementsWithoutParents[elementId] = scgElement;
       else
-      {
-        if (!contours.count(parent))
-          contours.insert({parent, {}});
-
-        contours[parent].insert({id, scgElement});
-      }
+        contours[parent].insert({elementId, scgElement});
 
-      allElements[id] = scgElement;
+      allElements[elementId] = scgElement;
     }
   }
+}
 
-  // To correctly process contours and connectors all elements are first collected, then the contours and connectors are
-  // assigned elements
-  FillConnectors(connectors, allElements);
-  FillContours(contours, allElements);
+void GWFParser::CountElements(SCgElements const & elements, GWFTranslatorStats::ElementsCounts & counts)
+{
+  for (auto const & [id, element] : elements)
+  {
+    std::string_view const tag = element->GetTag();
+    if (tag == NODE)
+    {
+      if (std::dynamic_pointer_cast<SCgLink>(element))
+        ++counts.m_links;
+      else
+        ++counts.m_nodes;
+    }
+    else if (tag == BUS)
+      ++counts.m_buses;
+    else if (tag == CONTOUR)
+      ++counts.m_contours;
+    else
+      ++counts.m_connectors;
+  }
 }
 
 std::shared_ptr<SCgNode> GWFParser::CreateNode(
-    std::string const & id,
-    std::string const & parent,
-    std::string const & identifier,
-    std::string const & type,
-    std::string const & tag)
+    std::string_view id,
+    std::string_view parent,
+    std::string_view identifier,
+    std::string_view type,
+    std::string_view tag,
+    std::pmr::memory_resource * resource)
 {
-  return std::make_shared<SCgNode>(id, parent, identifier, type, tag);
+  return MakeElement<SCgNode>(resource, id, parent, identifier, type, tag);
 }
 
 std::shared_ptr<SCgLink> GWFParser::CreateLink(
-    std::string const & id,
-    std::string const & parent,
-    std::string const & identifier,
-    std::string const & type,
-    std::string const & tag,
-    xmlNodePtr el)
+    std::string_view id,
+    std::string_view parent,
+    std::string_view identifier,
+    std::string_view type,
+    std::string_view tag,
+    xmlNodePtr el,
+    GWFContentStorage const & storage,
+    std::pmr::memory_resource * resource)
 {
   for (xmlNodePtr contentChild = el->children; contentChild; contentChild = contentChild->next)
   {
     if (contentChild->type == XML_ELEMENT_NODE && xmlStrcmp(contentChild->name, CONTENT) == 0)
     {
-      auto const contentType = GetXmlPropStr(contentChild, TYPE);
-      auto const mimeType = GetXmlPropStr(contentChild, MIME_TYPE);
-      auto const fileName = GetXmlPropStr(contentChild, FILE_NAME);
-      auto contentData = XmlCharToString(std::unique_ptr<xmlChar, XmlCharDeleter>(xmlNodeGetContent(contentChild)));
-
-      if (!contentType.empty() && std::stoi(contentType) < 4)
+      auto const contentType = GetXmlPropStr(contentChild, TYPE, resource);
+      auto const mimeType = GetXmlPropStr(contentChild, MIME_TYPE, resource);
+      auto const fileName = GetXmlPropStr(contentChild, FILE_NAME, resource);
+      // Text is allocated with the link, while decoded images are moved from the heap without a copy
+      std::pmr::string contentData(contentType == "4" ? std::pmr::get_default_resource() : resource);
+      // Detached contents are counted against the memory budget while they're read
+      bool isContentBudgeted = false;
+
+      if (!contentType.empty() && std::stoi(contentType.c_str()) < 4)
       {
         // Content is num or string that don't need conversion
+        std::unique_ptr<xmlChar, XmlCharDeleter> const text(xmlNodeGetContent(contentChild));
+        contentData.assign(reinterpret_cast<char const *>(text.get()), xmlStrlen(text.get()));
       }
       else if (contentType == "4")
       {
         // Content in binary format (image)
-        contentData = ScBase64::Decode(contentData);
+        GWFDetachedContent * content = nullptr;
+        if (storage.m_detachedContents != nullptr)
+        {
+          auto const it = storage.m_detachedContents->find(contentChild);
+          if (it != storage.m_detachedContents->end())
+            content = &it->second;
+        }
+
+        if (content == nullptr)
+          contentData = DecodeBase64Content(contentChild);
+        else if (!content->m_encodedContent.empty())
+        {
+          auto link = MakeElement<SCgLink>(
+              resource, id, parent, identifier, type, tag, contentType, mimeType, fileName, std::pmr::string());
+          if (content->m_keptEncodedContent.empty())
+            link->SetDeferredContent(content->m_encodedContent, SCgLink::ContentEncoding::Base64);
+          else
+            link->SetDeferredContent(std::move(content->m_keptEncodedContent), SCgLink::ContentEncoding::Base64);
+          return link;
+        }
+        else if (!content->m_storedContentPath.empty())
+        {
+          auto link = MakeElement<SCgLink>(
+              resource, id, parent, identifier, type, tag, contentType, mimeType, fileName, std::pmr::string());
+          link->SetStoredContent(content->m_storedContentPath, content->m_storedContentSize);
+          return link;
+        }
+        else if (content->m_spilledContent)
+        {
+          auto link = MakeElement<SCgLink>(
+              resource, id, parent, identifier, type, tag, contentType, mimeType, fileName, std::pmr::string());
+          link->SetSpilledContent(storage.m_spillFile, *content->m_spilledContent);
+          return link;
+        }
+        else
+        {
+          contentData = std::move(content->m_decodedContent);
+          isContentBudgeted = true;
+        }
       }
       else
         SC_THROW_EXCEPTION(
             utils::ExceptionParseError, "GWFParser::CreateLink: Content type is not supported: " << contentType);
 
-      return std::make_shared<SCgLink>(id, parent, identifier, type, tag, contentType, mimeType, fileName, contentData);
+      if (storage.m_blobStore != nullptr && contentType == "4")
+      {
+        auto link = MakeElement<SCgLink>(
+            resource, id, parent, identifier, type, tag, contentType, mimeType, fileName, std::pmr::string());
+        link->SetStoredContent(storage.m_blobStore->Store(contentData), contentData.size());
+        return link;
+      }
+
+      GWFSpillFile * spillFile = storage.m_spillFile;
+      if (spillFile != nullptr && !isContentBudgeted && contentData.size() >= MIN_SPILLED_CONTENT_SIZE
+          && !spillFile->TryReserve(contentData.size()))
+      {
+        auto const & range = spillFile->Write(contentData.data(), contentData.size());
+        auto link = MakeElement<SCgLink>(
+            resource, id, parent, identifier, type, tag, contentType, mimeType, fileName, std::pmr::string());
+        link->SetSpilledContent(spillFile, range);
+        return link;
+      }
+
+      return MakeElement<SCgLink>(
+          resource, id, parent, identifier, type, tag, contentType, mimeType, fileName, std::move(contentData));
     }
   }
 
   return nullptr;
 }
 
+std::pmr::string GWFParser::DecodeBase64Content(xmlNodePtr contentNode)
+{
+  std::size_t encodedSize = 0;
+  for (xmlNodePtr child = contentNode->children; child; child = child->next)
+  {
+    // Text of other nodes, e.g. entity references, is assembled by libxml
+    if (child->type != XML_TEXT_NODE && child->type != XML_CDATA_SECTION_NODE)
+      return std::pmr::string(GWFBase64Decoder::Decode(
+          XmlCharToString(std::unique_ptr<xmlChar, XmlCharDeleter>(xmlNodeGetContent(contentNode)))));
+    encodedSize += xmlStrlen(child->content);
+  }
+
+  std::pmr::string bytes(GWFBase64Decoder::GetMaxDecodedSize(encodedSize), '\0');
+  GWFBase64Decoder decoder;
+  std::size_t size = 0;
+  for (xmlNodePtr child = contentNode->children; child; child = child->next)
+    size += decoder.DecodeChunk(
+        reinterpret_cast<char const *>(child->content), xmlStrlen(child->content), bytes.data() + size);
+  size += decoder.Finish(bytes.data() + size);
+
+  bytes.resize(size);
+  return bytes;
+}
+
 bool GWFParser::HasContent(xmlNodePtr node)
 {
   for (xmlNodePtr child = node->children; child; child = child->next)
   {
     if (child->type == XML_ELEMENT_NODE && xmlStrcmp(child->name, CONTENT) == 0
-        && GetXmlPropStr(child, TYPE) != NO_CONTENT)
+        && std::string_view(GetXmlPropStr(child, TYPE)) != NO_CONTENT)
       return true;
   }
   return false;
 }
 
 std::shared_ptr<SCgBus> GWFParser::CreateBus(
-    std::string const & id,
-    std::string const & parent,
-    std::string const & identifier,
-    std::string const & type,
-    std::string const & tag,
-    xmlNodePtr el)
+    std::string_view id,
+    std::string_view parent,
+    std::string_view identifier,
+    std::string_view type,
+    std::string_view tag,
+    xmlNodePtr el,
+    std::pmr::memory_resource * resource)
 {
   auto const nodeId = GetXmlPropStr(el, OWNER);
-  return std::make_shared<SCgBus>(id, parent, identifier, type, tag, nodeId);
+  return MakeElement<SCgBus>(resource, id, parent, identifier, type, tag, nodeId);
 }
 
 std::shared_ptr<SCgContour> GWFParser::CreateContour(
-    std::string const & id,
-    std::string const & parent,
-    std::string const & identifier,
-    std::string const & type,
-    std::string const & tag)
+    std::string_view id,
+    std::string_view parent,
+    std::string_view identifier,
+    std::string_view type,
+    std::string_view tag,
+    std::pmr::memory_resource * resource)
 {
-  return std::make_shared<SCgContour>(id, parent, identifier, type, tag);
+  return MakeElement<SCgContour>(resource, id, parent, identifier, type, tag);
 }
 
 std::shared_ptr<SCgConnector> GWFParser::CreateConnector(
-    std::string const & id,
-    std::string const & parent,
-    std::string const & identifier,
-    std::string const & type,
-    std::string const & tag,
+    std::string_view id,
+    std::string_view parent,
+    std::string_view identifier,
+    std::string_view type,
+    std::string_view tag,
     xmlNodePtr el,
-    SCgConnectors & connectors)
+    SCgConnectors & connectors,
+    std::pmr::memory_resource * resource)
 {
-  std::string const & sourceId = GetXmlPropStr(el, ID_B);
-  std::string const & targetId = GetXmlPropStr(el, ID_E);
-
-  auto connector = std::make_shared<SCgConnector>(id, parent, identifier, type, tag, nullptr, nullptr);
-  connectors.insert({connector, {sourceId, targetId}});
+  auto connector = MakeElement<SCgConnector>(resource, id, parent, identifier, type, tag, nullptr, nullptr);
+  // Ids are moved into the pair, so they stay in the resource
+  connectors.try_emplace(connector, GetXmlPropStr(el, ID_B, resource), GetXmlPropStr(el, ID_E, resource));
   return connector;
 }
 
@@ -218,8 +939,8 @@ void GWFParser::FillConnectors(SCgConnectors const & connectors, SCgElements con
 
   for (auto const & [connector, incidentElements] : connectors)
   {
-    std::string const & sourceId = incidentElements.first;
-    std::string const & targetId = incidentElements.second;
+    std::string_view const sourceId = incidentElements.first;
+    std::string_view const targetId = incidentElements.second;
 
     auto sourceIt = elements.find(sourceId);
     auto targetIt = elements.find(targetId);
@@ -267,11 +988,15 @@ std::string GWFParser::XmlCharToString(std::unique_ptr<xmlChar, XmlCharDeleter>
 
 std::unique_ptr<xmlChar, XmlCharDeleter> GWFParser::GetXmlProp(xmlNodePtr node, std::string const & propName)
 {
+  GWF_COUNT_HOT_PATH(XmlPropReads);
   xmlChar * propValue = xmlGetProp(node, BAD_CAST propName.c_str());
   return std::unique_ptr<xmlChar, XmlCharDeleter>(propValue);
 }
 
-std::string GWFParser::GetXmlPropStr(xmlNodePtr node, std::string const & propName)
+std::pmr::string GWFParser::GetXmlPropStr(
+    xmlNodePtr node,
+    std::string const & propName,
+    std::pmr::memory_resource * resource)
 {
   std::unique_ptr<xmlChar, XmlCharDeleter> const prop = GetXmlProp(node, propName);
   if (prop == nullptr)
@@ -279,6 +1004,5 @@ std::string GWFParser::GetXmlPropStr(xmlNodePtr node, std::string const & propNa
         utils::ExceptionParseError,
         "GWFParser::GetXmlPropStr: Gwf-element doesn't have property name `" << propName << "`.");
 
-  std::string const propStr = XmlCharToString(prop);
-  return propStr;
+  return std::pmr::string(reinterpret_cast<char const *>(prop.get()), xmlStrlen(prop.get()), resource);
 }
@@ -11,11 +11,16 @@
 #include <cstring>
 #include <memory>
 #include <list>
+#include <optional>
+#include <string_view>
 
 #include <libxml/parser.h>
 #include <libxml/tree.h>
 
+#include "gwf_blob_store.hpp"
+#include "gwf_spill_file.hpp"
 #include "gwf_translator_constants.hpp"
+#include "gwf_translator_stats.hpp"
 #include "sc_scg_element.hpp"
 
 class XmlCharDeleter
@@ -24,60 +29,150 @@ public:
   void operator()(xmlChar * ptr) const;
 };
 
+// Image content that a document was read without. It's left in the gwf text, or decoded while it's read: into memory,
+// or, if it doesn't fit there, into the blob store or the spill file.
+struct GWFDetachedContent
+{
+  // View of the encoded content in the gwf text, if it's deferred
+  std::string_view m_encodedContent;
+  // Copy of the encoded content, if it's deferred and the gwf text is released once it's read. The view refers to it.
+  std::string m_keptEncodedContent;
+  // Decoded bytes are taken from the heap, so that they're moved into a link without a copy
+  std::pmr::string m_decodedContent;
+  std::string m_storedContentPath;
+  std::size_t m_storedContentSize = 0;
+  std::optional<GWFSpillFile::Range> m_spilledContent;
+};
+
+// Image contents by content nodes
+using GWFDetachedContents = std::pmr::unordered_map<xmlNodePtr, GWFDetachedContent>;
+
+// Places for link contents other than links themselves
+struct GWFContentStorage
+{
+  // Image contents are stored once in the blob store and links refer to them
+  GWFBlobStore * m_blobStore = nullptr;
+  // Contents that don't fit into the memory budget of the spill file are spilled to it
+  GWFSpillFile * m_spillFile = nullptr;
+  // Image contents are left encoded in the gwf text, which must outlive the links unless Parse releases it, and decoded
+  // when they're read. Ignored if there is a blob store, it needs decoded contents.
+  bool m_isContentDeferred = false;
+  // Image contents the document was read without, see GWFParser::ReadDocument. Parse collects them itself.
+  GWFDetachedContents * m_detachedContents = nullptr;
+};
+
 class GWFParser
 {
 public:
-  static void Parse(std::string const & xmlStr, SCgElements & elements);
+  using XmlDocumentPtr = std::unique_ptr<xmlDoc, decltype(&xmlFreeDoc)>;
+
+  // Elements and containers of the parsed graph are allocated from the memory resource of elements. The path of the
+  // file xmlStr is read from, if any, names the document in errors.
+  static void Parse(
+      std::string const & xmlStr,
+      SCgElements & elements,
+      GWFTranslatorStats * stats = nullptr,
+      GWFContentStorage const & storage = {},
+      std::string const & filePath = "");
+  // Releases xmlStr as soon as the document is read, so that the text and the SCg elements aren't resident together.
+  // Deferred contents are copied out of the text before it's released, only their ranges are kept.
+  static void Parse(
+      std::string && xmlStr,
+      SCgElements & elements,
+      GWFTranslatorStats * stats = nullptr,
+      GWFContentStorage const & storage = {},
+      std::string const & filePath = "");
+  // Reads the file in chunks, so that the gwf text is never resident as a whole. Contents aren't deferred. Returns the
+  // size of the file.
+  static std::size_t ParseFile(
+      std::string const & filePath,
+      SCgElements & elements,
+      GWFTranslatorStats * stats = nullptr,
+      GWFContentStorage const & storage = {});
+
+  // Parsing phases, Parse runs them one after another. Elements are allocated from the resource of allElements.
+  // If storage has detached contents, text of image content nodes isn't copied into the document, it's collected into
+  // them instead, see GWFDetachedContent. Text that isn't verbatim in xmlStr, e.g. because of character references,
+  // isn't deferred but decoded.
+  static XmlDocumentPtr ReadDocument(
+      std::string const & xmlStr,
+      GWFContentStorage const & storage = {},
+      std::string const & filePath = "");
+  static xmlNodePtr FindStaticSector(xmlDocPtr document);
+  static void ProcessStaticSector(
+      xmlNodePtr staticSector,
+      SCgElements & elementsWithoutParents,
+      SCgElements & allElements,
+      SCgConnectors & connectors,
+      SCgContours & contours,
+      GWFContentStorage const & storage = {});
+  static void FillConnectors(SCgConnectors const & connectors, SCgElements const & elements);
+  static void FillContours(SCgContours const & contours, SCgElements const & elements);
 
 private:
+  // Frees the document as soon as elements are created from it
+  static void ParseDocument(
+      XmlDocumentPtr xmlTree,
+      SCgElements & elements,
+      GWFTranslatorStats * stats,
+      GWFContentStorage const & storage);
+
   static std::shared_ptr<SCgNode> CreateNode(
-      std::string const & id,
-      std::string const & parent,
-      std::string const & identifier,
-      std::string const & type,
-      std::string const & tag);
+      std::string_view id,
+      std::string_view parent,
+      std::string_view identifier,
+      std::string_view type,
+      std::string_view tag,
+      std::pmr::memory_resource * resource);
 
   static std::shared_ptr<SCgLink> CreateLink(
-      std::string const & id,
-      std::string const & parent,
-      std::string const & identifier,
-      std::string const & type,
-      std::string const & tag,
-      xmlNodePtr el);
+      std::string_view id,
+      std::string_view parent,
+      std::string_view identifier,
+      std::string_view type,
+      std::string_view tag,
+      xmlNodePtr el,
+      GWFContentStorage const & storage,
+      std::pmr::memory_resource * resource);
+
+  // Decodes text of a content node straight from the document, without copying it out first
+  static std::pmr::string DecodeBase64Content(xmlNodePtr contentNode);
 
   static bool HasContent(xmlNodePtr node);
 
   static std::shared_ptr<SCgBus> CreateBus(
-      std::string const & id,
-      std::string const & parent,
-      std::string const & identifier,
-      std::string const & type,
-      std::string const & tag,
-      xmlNodePtr el);
+      std::string_view id,
+      std::string_view parent,
+      std::string_view identifier,
+      std::string_view type,
+      std::string_view tag,
+      xmlNodePtr el,
+      std::pmr::memory_resource * resource);
 
   static std::shared_ptr<SCgContour> CreateContour(
-      std::string const & id,
-      std::string const & parent,
-      std::string const & identifier,
-      std::string const & type,
-      std::string const & tag);
+      std::string_view id,
+      std::string_view parent,
+      std::string_view identifier,
+      std::string_view type,
+      std::string_view tag,
+      std::pmr::memory_resource * resource);
 
   static std::shared_ptr<SCgConnector> CreateConnector(
-      std::string const & id,
-      std::string const & parent,
-      std::string const & identifier,
-      std::string const & type,
-      std::string const & tag,
+      std::string_view id,
+      std::string_view parent,
+      std::string_view identifier,
+      std::string_view type,
+      std::string_view tag,
       xmlNodePtr el,
-      SCgConnectors & connectors);
-
-  static void FillConnectors(SCgConnectors const & connectors, SCgElements const & elements);
-
-  static void FillContours(SCgContours const & contours, SCgElements const & elements);
+      SCgConnectors & connectors,
+      std::pmr::memory_resource * resource);
 
-  static void ProcessStaticSector(xmlNodePtr staticSector, SCgElements & elementsWithParents);
+  static void CountElements(SCgElements const & elements, GWFTranslatorStats::ElementsCounts & counts);
 
   static std::string XmlCharToString(std::unique_ptr<xmlChar, XmlCharDeleter> const & ptr);
   static std::unique_ptr<xmlChar, XmlCharDeleter> GetXmlProp(xmlNodePtr node, std::string const & propName);
-  static std::string GetXmlPropStr(xmlNodePtr node, std::string const & propName);
+  static std::pmr::string GetXmlPropStr(
+      xmlNodePtr node,
+      std::string const & propName,
+      std::pmr::memory_resource * resource = std::pmr::get_default_resource());
 };
@@ -0,0 +1,152 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "gwf_perf_counters.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <sc-memory/sc_debug.hpp>
+
+namespace
+{
+std::atomic<bool> isEnabled{false};
+// Bit per counter that couldn't be opened in some thread
+std::atomic<uint32_t> unavailableCounters{0};
+
+struct CounterConfig
+{
+  uint32_t m_type;
+  uint64_t m_config;
+};
+
+CounterConfig GetConfig(GWFPerfCounters::Counter counter)
+{
+  using Counter = GWFPerfCounters::Counter;
+
+  switch (counter)
+  {
+  case Counter::Cycles:
+    return {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES};
+  case Counter::Instructions:
+    return {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS};
+  case Counter::L1DataMisses:
+    return {
+        PERF_TYPE_HW_CACHE,
+        PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)};
+  case Counter::LLCMisses:
+    return {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES};
+  default:
+    return {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES};
+  }
+}
+}  // namespace
+
+void GWFPerfCounters::Enable()
+{
+  isEnabled.store(true, std::memory_order_relaxed);
+}
+
+void GWFPerfCounters::Disable()
+{
+  isEnabled.store(false, std::memory_order_relaxed);
+}
+
+bool GWFPerfCounters::IsEnabled()
+{
+  return isEnabled.load(std::memory_order_relaxed);
+}
+
+bool GWFPerfCounters::IsAvailable(Counter counter)
+{
+  return (unavailableCounters.load(std::memory_order_relaxed) & (1u << static_cast<uint32_t>(counter))) == 0;
+}
+
+char const * GWFPerfCounters::GetCounterName(Counter counter)
+{
+  switch (counter)
+  {
+  case Counter::Cycles:
+    return "cycles";
+  case Counter::Instructions:
+    return "instructions";
+  case Counter::L1DataMisses:
+    return "l1d_misses";
+  case Counter::LLCMisses:
+    return "llc_misses";
+  case Counter::BranchMisses:
+    return "branch_misses";
+  default:
+    return "unknown";
+  }
+}
+
+GWFPerfCounters::Values GWFPerfCounters::Read()
+{
+  thread_local ThreadCounters const threadCounters;
+
+  Values values{};
+  for (std::size_t i = 0; i < values.size(); ++i)
+  {
+    int const descriptor = threadCounters.m_descriptors[i];
+    if (descriptor < 0)
+      continue;
+
+    // value, time enabled, time running
+    uint64_t data[3];
+    if (read(descriptor, data, sizeof(data)) != sizeof(data) || data[2] == 0)
+      continue;
+
+    values[i] = data[2] < data[1] ? static_cast<uint64_t>(static_cast<double>(data[0]) * data[1] / data[2]) : data[0];
+  }
+  return values;
+}
+
+GWFPerfCounters::ThreadCounters::ThreadCounters()
+{
+  for (std::size_t i = 0; i < m_descriptors.size(); ++i)
+    m_descriptors[i] = Open(static_cast<Counter>(i));
+}
+
+GWFPerfCounters::ThreadCounters::~ThreadCounters()
+{
+  for (int const descriptor : m_descriptors)
+  {
+    if (descriptor >= 0)
+      close(descriptor);
+  }
+}
+
+int GWFPerfCounters::Open(Counter counter)
+{
+  CounterConfig const config = GetConfig(counter);
+
+  perf_event_attr attributes;
+  std::memset(&attributes, 0, sizeof(attributes));
+  attributes.size = sizeof(attributes);
+  attributes.type = config.m_type;
+  attributes.config = config.m_config;
+  attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  // Unprivileged processes may count only their own user space code
+  attributes.exclude_kernel = 1;
+  attributes.exclude_hv = 1;
+
+  int const descriptor = static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+  if (descriptor < 0)
+  {
+    uint32_t const bit = 1u << static_cast<uint32_t>(counter);
+    if ((unavailableCounters.fetch_or(bit, std::memory_order_relaxed) & bit) == 0)
+      SC_LOG_WARNING(
+          "GWFPerfCounters::Open: Counter `" << GetCounterName(counter)
+                                             << "` is unavailable: " << std::strerror(errno) << ".");
+  }
+  return descriptor;
+}
@@ -0,0 +1,56 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/*!
+ * Reads hardware performance counters of the calling thread with perf_event_open.
+ *
+ * Counters are opened for every thread on its first read and stay open until the thread exits. A counter the kernel
+ * refuses to open, e.g. in an unprivileged container or on a CPU without it, is marked unavailable for the process and
+ * reads as zero, so measurements still work without it. Counters multiplexed by the kernel are scaled to the time they
+ * were enabled.
+ */
+class GWFPerfCounters
+{
+public:
+  enum class Counter : std::size_t
+  {
+    Cycles,
+    Instructions,
+    L1DataMisses,
+    LLCMisses,
+    BranchMisses,
+    Count
+  };
+
+  using Values = std::array<uint64_t, static_cast<std::size_t>(Counter::Count)>;
+
+  // Counters are read only while enabled, they cost a system call per counter on every read
+  static void Enable();
+  static void Disable();
+  static bool IsEnabled();
+
+  static bool IsAvailable(Counter counter);
+  static char const * GetCounterName(Counter counter);
+
+  static Values Read();
+
+private:
+  struct ThreadCounters
+  {
+    ThreadCounters();
+    ~ThreadCounters();
+
+    std::array<int, static_cast<std::size_t>(Counter::Count)> m_descriptors;
+  };
+
+  static int Open(Counter counter);
+};
@@ -0,0 +1,100 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "gwf_spill_file.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#include <sc-memory/sc_debug.hpp>
+
+namespace
+{
+std::size_t const READ_CHUNK_SIZE = 64 * 1024;
+std::size_t const MIN_MEMORY_BUDGET = 64 * 1024;
+}  // namespace
+
+// tmpfile creates an unnamed file, so it's removed even if the process is killed
+GWFSpillFile::GWFSpillFile(std::size_t memoryBudget)
+  : m_file(std::tmpfile())
+  , m_memoryBudget(std::max(memoryBudget, MIN_MEMORY_BUDGET))
+  , m_residentBytes(0)
+  , m_spilledBytes(0)
+  , m_spillsCount(0)
+{
+  if (m_file == nullptr)
+    SC_THROW_EXCEPTION(utils::ExceptionCritical, "GWFSpillFile: Unable to create a temporary file.");
+}
+
+GWFSpillFile::~GWFSpillFile()
+{
+  std::fclose(m_file);
+}
+
+bool GWFSpillFile::TryReserve(std::size_t size)
+{
+  if (m_residentBytes + size > m_memoryBudget)
+    return false;
+
+  m_residentBytes += size;
+  return true;
+}
+
+void GWFSpillFile::Release(std::size_t size)
+{
+  m_residentBytes -= std::min(size, m_residentBytes);
+}
+
+GWFSpillFile::Range GWFSpillFile::Write(char const * data, std::size_t size)
+{
+  Range const range{m_spilledBytes, size};
+  if (std::fseek(m_file, static_cast<long>(range.m_offset), SEEK_SET) != 0
+      || std::fwrite(data, 1, size, m_file) != size)
+    SC_THROW_EXCEPTION(
+        utils::ExceptionCritical, "GWFSpillFile::Write: Unable to spill " << size << " bytes to a temporary file.");
+
+  m_spilledBytes += size;
+  ++m_spillsCount;
+  return range;
+}
+
+// The consumer may spill too, e.g. a buffer that a spilled link content is copied to, so every chunk is read after a
+// seek of its own
+void GWFSpillFile::Read(Range const & range, Consumer const & consumer) const
+{
+  std::vector<char> chunk(std::min(range.m_size, READ_CHUNK_SIZE));
+  for (std::size_t readBytes = 0; readBytes < range.m_size;)
+  {
+    std::size_t const size = std::min(range.m_size - readBytes, chunk.size());
+    if (std::fseek(m_file, static_cast<long>(range.m_offset + readBytes), SEEK_SET) != 0
+        || std::fread(chunk.data(), 1, size, m_file) != size)
+      SC_THROW_EXCEPTION(
+          utils::ExceptionCritical, "GWFSpillFile::Read: Unable to read spilled bytes from a temporary file.");
+
+    consumer(chunk.data(), size);
+    readBytes += size;
+  }
+}
+
+std::size_t GWFSpillFile::GetMemoryBudget() const
+{
+  return m_memoryBudget;
+}
+
+std::size_t GWFSpillFile::GetSpilledBytes() const
+{
+  return m_spilledBytes;
+}
+
+std::size_t GWFSpillFile::GetSpillsCount() const
+{
+  return m_spillsCount;
+}
+
+std::size_t GWFSpillFile::GetMinMemoryBudget()
+{
+  return MIN_MEMORY_BUDGET;
+}
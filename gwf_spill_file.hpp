@@ -0,0 +1,61 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <functional>
+#include <string>
+
+/*!
+ * Memory budget of a bounded-memory translation and the temporary file for data that doesn't fit into it.
+ *
+ * Large link payloads and the SCs buffer are counted against the budget. Once it's exhausted they are written to the
+ * file instead of being kept in memory, so resident memory stays bounded whatever the size of a diagram. The file is
+ * removed when the object is destroyed.
+ *
+ * Data is spilled in chunks of at least GetMinMemoryBudget bytes, so that a spill isn't a write per append. A smaller
+ * budget couldn't be kept, it's raised to the minimum.
+ */
+class GWFSpillFile
+{
+public:
+  struct Range
+  {
+    std::size_t m_offset = 0;
+    std::size_t m_size = 0;
+  };
+
+  using Consumer = std::function<void(char const * data, std::size_t size)>;
+
+  explicit GWFSpillFile(std::size_t memoryBudget);
+  ~GWFSpillFile();
+
+  GWFSpillFile(GWFSpillFile const &) = delete;
+  GWFSpillFile & operator=(GWFSpillFile const &) = delete;
+
+  // Counts bytes as resident. Returns false and counts nothing if they don't fit into the budget.
+  bool TryReserve(std::size_t size);
+  void Release(std::size_t size);
+
+  Range Write(char const * data, std::size_t size);
+  // Passes data of a range to the consumer in chunks, so that the range isn't loaded into memory at once
+  void Read(Range const & range, Consumer const & consumer) const;
+
+  std::size_t GetMemoryBudget() const;
+  std::size_t GetSpilledBytes() const;
+  std::size_t GetSpillsCount() const;
+
+  static std::size_t GetMinMemoryBudget();
+
+private:
+  std::FILE * m_file;
+  std::size_t m_memoryBudget;
+  std::size_t m_residentBytes;
+  std::size_t m_spilledBytes;
+  std::size_t m_spillsCount;
+};
@@ -0,0 +1,167 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "gwf_tracer.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+
+#include <unistd.h>
+
+#include <sc-memory/sc_debug.hpp>
+
+#include "gwf_json.hpp"
+
+namespace
+{
+std::atomic<bool> isEnabled{false};
+std::chrono::steady_clock::time_point const epoch = std::chrono::steady_clock::now();
+}  // namespace
+
+std::vector<std::shared_ptr<GWFTracer::ThreadBuffer>> GWFTracer::m_buffers;
+std::mutex GWFTracer::m_buffersMutex;
+
+void GWFTracer::Enable()
+{
+  isEnabled.store(true, std::memory_order_relaxed);
+}
+
+void GWFTracer::Disable()
+{
+  isEnabled.store(false, std::memory_order_relaxed);
+}
+
+bool GWFTracer::IsEnabled()
+{
+  return isEnabled.load(std::memory_order_relaxed);
+}
+
+void GWFTracer::SetThreadName(std::string const & name)
+{
+  ThreadBuffer & buffer = GetThreadBuffer();
+  std::lock_guard<std::mutex> lock(buffer.m_mutex);
+  buffer.m_threadName = name;
+}
+
+void GWFTracer::Write(std::ostream & stream)
+{
+  std::lock_guard<std::mutex> lock(m_buffersMutex);
+  long const processId = getpid();
+
+  stream << "{\"traceEvents\": [";
+  bool isFirst = true;
+  auto const & writeSeparator = [&]()
+  {
+    if (!isFirst)
+      stream << ",";
+    stream << "\n";
+    isFirst = false;
+  };
+
+  for (auto const & pointer : m_buffers)
+  {
+    auto & buffer = *pointer;
+    std::lock_guard<std::mutex> bufferLock(buffer.m_mutex);
+    if (!buffer.m_threadName.empty())
+    {
+      writeSeparator();
+      stream << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << processId
+             << ", \"tid\": " << buffer.m_threadId << ", \"args\": {\"name\": ";
+      GWFJSON::WriteString(stream, buffer.m_threadName);
+      stream << "}}";
+    }
+
+    for (auto const & event : buffer.m_events)
+    {
+      writeSeparator();
+      stream << "{\"name\": ";
+      GWFJSON::WriteString(stream, event.m_name);
+      stream << ", \"cat\": \"" << event.m_category << "\", \"ph\": \"X\", \"ts\": " << event.m_start
+             << ", \"dur\": " << event.m_duration << ", \"pid\": " << processId << ", \"tid\": " << buffer.m_threadId
+             << "}";
+    }
+  }
+
+  stream << "\n], \"displayTimeUnit\": \"ms\"}\n";
+}
+
+void GWFTracer::Write(std::string const & filePath)
+{
+  std::ofstream stream(filePath, std::ios::binary);
+  if (!stream.is_open())
+    SC_THROW_EXCEPTION(utils::ExceptionCritical, "GWFTracer::Write: Error creating trace file `" << filePath << "`.");
+
+  Write(stream);
+
+  if (stream.fail())
+    SC_THROW_EXCEPTION(utils::ExceptionCritical, "GWFTracer::Write: Error writing trace file `" << filePath << "`.");
+}
+
+void GWFTracer::Clear()
+{
+  std::lock_guard<std::mutex> lock(m_buffersMutex);
+  for (auto const & buffer : m_buffers)
+  {
+    std::lock_guard<std::mutex> bufferLock(buffer->m_mutex);
+    buffer->m_events.clear();
+  }
+}
+
+GWFTracer::ThreadBuffer & GWFTracer::GetThreadBuffer()
+{
+  thread_local ThreadBuffer * threadBuffer = nullptr;
+  if (threadBuffer == nullptr)
+  {
+    auto buffer = std::make_shared<ThreadBuffer>();
+    std::lock_guard<std::mutex> lock(m_buffersMutex);
+    buffer->m_threadId = static_cast<uint32_t>(m_buffers.size() + 1);
+    m_buffers.push_back(buffer);
+    threadBuffer = buffer.get();
+  }
+  return *threadBuffer;
+}
+
+uint64_t GWFTracer::GetTimestamp()
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+// ScopedSpan
+GWFTracer::ScopedSpan::ScopedSpan(char const * category, char const * name)
+  : m_category(nullptr)
+  , m_start(0)
+{
+  if (category == nullptr || !IsEnabled())
+    return;
+
+  m_category = category;
+  m_name = name;
+  m_start = GetTimestamp();
+}
+
+GWFTracer::ScopedSpan::ScopedSpan(char const * category, std::string_view name)
+  : m_category(nullptr)
+  , m_start(0)
+{
+  if (category == nullptr || !IsEnabled())
+    return;
+
+  m_category = category;
+  m_name = name;
+  m_start = GetTimestamp();
+}
+
+GWFTracer::ScopedSpan::~ScopedSpan()
+{
+  if (m_category == nullptr)
+    return;
+
+  uint64_t const end = GetTimestamp();
+  ThreadBuffer & buffer = GetThreadBuffer();
+  std::lock_guard<std::mutex> lock(buffer.m_mutex);
+  buffer.m_events.push_back({m_category, std::move(m_name), m_start, end - m_start});
+}
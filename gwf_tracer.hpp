@@ -0,0 +1,80 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*!
+ * Records spans of translation runs as Chrome trace events, that can be viewed in Perfetto or chrome://tracing.
+ *
+ * Every thread appends spans to its own buffer. The buffer has its own lock, which is contended only while the trace is
+ * written or cleared, so threads don't wait for each other; the registry lock is taken once per thread to register the
+ * buffer. Write and Clear may be called while threads record spans. While tracing is disabled a span costs one relaxed
+ * atomic load.
+ */
+class GWFTracer
+{
+public:
+  static void Enable();
+  static void Disable();
+  static bool IsEnabled();
+
+  // Names the calling thread in the trace, e.g. with a worker id
+  static void SetThreadName(std::string const & name);
+
+  static void Write(std::ostream & stream);
+  static void Write(std::string const & filePath);
+  static void Clear();
+
+  // A span with nullptr category isn't recorded
+  class ScopedSpan
+  {
+  public:
+    ScopedSpan(char const * category, char const * name);
+    ScopedSpan(char const * category, std::string_view name);
+    ~ScopedSpan();
+
+    ScopedSpan(ScopedSpan const &) = delete;
+    ScopedSpan & operator=(ScopedSpan const &) = delete;
+
+  private:
+    char const * m_category;
+    std::string m_name;
+    uint64_t m_start;
+  };
+
+private:
+  struct Event
+  {
+    char const * m_category;
+    std::string m_name;
+    uint64_t m_start;
+    uint64_t m_duration;
+  };
+
+  struct ThreadBuffer
+  {
+    // Guards the name and the events
+    std::mutex m_mutex;
+    uint32_t m_threadId;
+    std::string m_threadName;
+    std::vector<Event> m_events;
+  };
+
+  // Buffers are shared with the registry, so spans of finished threads are written too
+  static std::vector<std::shared_ptr<ThreadBuffer>> m_buffers;
+  static std::mutex m_buffersMutex;
+
+  static ThreadBuffer & GetThreadBuffer();
+  static uint64_t GetTimestamp();
+};
@@ -0,0 +1,234 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "gwf_translation_session.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <libxml/parser.h>
+#include <libxml/xmlerror.h>
+#include <libxml/xmlmemory.h>
+
+#include <sc-memory/sc_debug.hpp>
+
+#include "gwf_parser.hpp"
+#include "gwf_tracer.hpp"
+#include "sc_scs_writer.hpp"
+
+namespace
+{
+// Arena of the session that parses in the calling thread, if any
+thread_local GWFArena * xmlArena = nullptr;
+
+// Allocator that was installed before the session one, e.g. the counting one. Blocks that aren't allocated from an
+// arena are passed to it.
+xmlFreeFunc previousFree = nullptr;
+xmlMallocFunc previousMalloc = nullptr;
+xmlReallocFunc previousRealloc = nullptr;
+xmlStrdupFunc previousStrdup = nullptr;
+
+// libxml2 reallocates blocks without telling their sizes, so every block of an arena starts with its size
+struct alignas(std::max_align_t) ArenaBlockHeader
+{
+  std::size_t m_size;
+};
+
+void * ArenaMalloc(std::size_t size)
+{
+  if (xmlArena == nullptr)
+    return previousMalloc(size);
+
+  auto * header = static_cast<ArenaBlockHeader *>(
+      xmlArena->allocate(sizeof(ArenaBlockHeader) + size, alignof(ArenaBlockHeader)));
+  header->m_size = size;
+  return header + 1;
+}
+
+// Blocks of an arena are reclaimed when it's reset. Every block libxml2 allocates from an arena is freed in the same
+// thread while the arena is used (see ScopedXmlArena), so blocks are recognized by the arena of the calling thread,
+// without locks.
+bool IsArenaBlock(void const * pointer)
+{
+  return xmlArena != nullptr && xmlArena->Contains(pointer);
+}
+
+void ArenaFree(void * pointer)
+{
+  if (pointer == nullptr || IsArenaBlock(pointer))
+    return;
+
+  previousFree(pointer);
+}
+
+void * ArenaRealloc(void * pointer, std::size_t size)
+{
+  if (pointer == nullptr)
+    return ArenaMalloc(size);
+
+  if (!IsArenaBlock(pointer))
+    return previousRealloc(pointer, size);
+
+  std::size_t const oldSize = (static_cast<ArenaBlockHeader *>(pointer) - 1)->m_size;
+  if (size <= oldSize)
+    return pointer;
+
+  void * newPointer = ArenaMalloc(size);
+  if (newPointer != nullptr)
+    std::memcpy(newPointer, pointer, oldSize);
+  return newPointer;
+}
+
+char * ArenaStrdup(char const * string)
+{
+  if (xmlArena == nullptr)
+    return previousStrdup(string);
+
+  std::size_t const size = std::strlen(string) + 1;
+  auto * copy = static_cast<char *>(ArenaMalloc(size));
+  std::memcpy(copy, string, size);
+  return copy;
+}
+
+// Installed after static initialization, so that the counting allocator is already installed and gets all blocks
+// that aren't allocated from arenas
+void InstallXmlArenaAllocator()
+{
+  static std::once_flag installed;
+  std::call_once(
+      installed,
+      []()
+      {
+        xmlInitParser();
+        xmlMemGet(&previousFree, &previousMalloc, &previousRealloc, &previousStrdup);
+        xmlMemSetup(ArenaFree, ArenaMalloc, ArenaRealloc, ArenaStrdup);
+      });
+}
+
+// Every block that libxml2 allocates during parsing must be freed during it too, in the same thread: the document is
+// freed by the parser, and the last error, which outlives parsing, is reset before the arena stops being used
+class ScopedXmlArena
+{
+public:
+  explicit ScopedXmlArena(GWFArena & arena)
+  {
+    xmlArena = &arena;
+  }
+
+  ~ScopedXmlArena()
+  {
+    xmlResetLastError();
+    xmlArena = nullptr;
+  }
+};
+}  // namespace
+
+GWFTranslationSession::GWFTranslationSession()
+  : m_blobStore(nullptr)
+{
+  InstallXmlArenaAllocator();
+}
+
+Buffer const & GWFTranslationSession::Translate(
+    std::string const & filename,
+    GWFTranslatorStats * stats,
+    IsCancelled const & isCancelled)
+{
+  using Phase = GWFTranslatorStats::Phase;
+
+  GWFTranslatorStats::ScopedMeasurement const measurement(stats);
+  GWFTracer::ScopedSpan const span("file", filename);
+
+  m_scsBuffer.Clear();
+  m_arena.Reset();
+  {
+    GWFTranslatorStats::ScopedMeasurement const phaseMeasurement(stats, Phase::FileRead);
+    ReadFile(filename, m_gwfText);
+  }
+
+  {
+    // Elements are destroyed before the arena is reset by the next translation
+    SCgElements elementsWithoutParents(&m_arena);
+    {
+      // Image contents, unless they are stored, stay in the gwf text until they are written
+      ScopedXmlArena const xmlArenaScope(m_arena);
+      GWFParser::Parse(m_gwfText, elementsWithoutParents, stats, {m_blobStore, nullptr, true}, filename);
+    }
+
+    if (elementsWithoutParents.empty())
+      SC_THROW_EXCEPTION(
+          utils::ExceptionParseError,
+          "GWFTranslationSession::Translate: There are no elements in file `" << filename << "`.");
+
+    if (isCancelled != nullptr && isCancelled())
+      return m_scsBuffer;
+
+    GWFTranslatorStats::ScopedMeasurement const phaseMeasurement(stats, Phase::SCsRendering);
+    SCsWriter::IdentifierIndex const identifiers(elementsWithoutParents, &m_arena);
+    SCgElementsSet writtenElements(&m_arena);
+    SCsWriter::Write(elementsWithoutParents, filename, m_scsBuffer, 0, writtenElements, identifiers);
+    if (stats != nullptr)
+      stats->m_identifierCollisionsCount = identifiers.GetCollisionsCount();
+  }
+
+  if (stats != nullptr)
+  {
+    stats->m_inputBytes = m_gwfText.size();
+    stats->m_outputBytes = m_scsBuffer.GetSize();
+  }
+
+  return m_scsBuffer;
+}
+
+void GWFTranslationSession::SetBlobStore(GWFBlobStore * blobStore)
+{
+  m_blobStore = blobStore;
+}
+
+std::size_t GWFTranslationSession::GetCapacity() const
+{
+  return m_gwfText.capacity() + m_arena.GetCapacity() + m_scsBuffer.GetCapacity();
+}
+
+// Reads into the existing string, so that its capacity is reused
+void GWFTranslationSession::ReadFile(std::string const & filename, std::string & content)
+{
+  int const descriptor = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+  if (descriptor < 0)
+    SC_THROW_EXCEPTION(
+        utils::ExceptionParseError, "GWFTranslationSession::ReadFile: Failed to open XML file `" << filename << "`.");
+
+  struct stat status;
+  if (fstat(descriptor, &status) != 0)
+  {
+    close(descriptor);
+    SC_THROW_EXCEPTION(
+        utils::ExceptionParseError, "GWFTranslationSession::ReadFile: Failed to read XML file `" << filename << "`.");
+  }
+
+  content.resize(static_cast<std::size_t>(status.st_size));
+  std::size_t readBytes = 0;
+  while (readBytes < content.size())
+  {
+    ssize_t const result = read(descriptor, content.data() + readBytes, content.size() - readBytes);
+    if (result < 0 && errno == EINTR)
+      continue;
+    if (result <= 0)
+    {
+      close(descriptor);
+      SC_THROW_EXCEPTION(
+          utils::ExceptionParseError, "GWFTranslationSession::ReadFile: Failed to read XML file `" << filename << "`.");
+    }
+    readBytes += static_cast<std::size_t>(result);
+  }
+
+  close(descriptor);
+}
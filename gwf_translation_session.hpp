@@ -0,0 +1,59 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include "buffer.hpp"
+#include "gwf_arena.hpp"
+#include "gwf_blob_store.hpp"
+#include "gwf_translator_stats.hpp"
+
+/*!
+ * Translates file after file with reusable scratch state, e.g. in a watcher or a batch worker.
+ *
+ * The session owns the gwf text, the arena that libxml2 documents, SCg elements and their containers are allocated
+ * from, and the SCs buffer. They are reset between translations instead of being freed, so once the session has
+ * translated a file, files of similar shape are translated without heap allocations: strings of SCg elements, names
+ * of the writer and working data of the validator are taken from the arena too.
+ *
+ * A session is used by one thread at a time. libxml2 allocates from the arena only during parsing in a session; other
+ * parsing, in any thread, allocates from the heap as before.
+ */
+class GWFTranslationSession
+{
+public:
+  GWFTranslationSession();
+
+  GWFTranslationSession(GWFTranslationSession const &) = delete;
+  GWFTranslationSession & operator=(GWFTranslationSession const &) = delete;
+
+  // Tells whether the result of a translation is no longer needed, e.g. because the file has been saved again
+  using IsCancelled = std::function<bool()>;
+
+  // The returned buffer holds the SCs text until the next translation. A translation that is cancelled by the time the
+  // file is parsed isn't written, its buffer is left empty.
+  Buffer const & Translate(
+      std::string const & filename,
+      GWFTranslatorStats * stats = nullptr,
+      IsCancelled const & isCancelled = nullptr);
+
+  // If set, image contents are stored once in the blob store and SCs texts refer to them. The store isn't owned.
+  void SetBlobStore(GWFBlobStore * blobStore);
+
+  // Bytes kept between translations
+  std::size_t GetCapacity() const;
+
+private:
+  std::string m_gwfText;
+  GWFArena m_arena;
+  Buffer m_scsBuffer;
+  GWFBlobStore * m_blobStore;
+
+  static void ReadFile(std::string const & filename, std::string & content);
+};
@@ -7,6 +7,7 @@
 #include "gwf_translator.hpp"
 
 #include <filesystem>
+#include <fstream>
 
 #include <sc-memory/utils/sc_exec.hpp>
 
@@ -19,72 +20,269 @@ using namespace Constants;
 GWFTranslator::GWFTranslator(ScMemoryContext & context)
   : Translator(context)
   , m_scsTranslator(context)
+  , m_isStatsLoggingEnabled(false)
+  , m_memoryBudget(0)
+  , m_blobStore(nullptr)
 {
 }
 
 bool GWFTranslator::TranslateImpl(Params const & params)
 {
-  std::string const & scsText = TranslateXMLFileContentToSCs(params.m_fileName);
-  std::string const & scsSource = WriteStringToFile(scsText, params.m_fileName);
+  using Phase = GWFTranslatorStats::Phase;
 
-  Params newParams;
-  newParams.m_fileName = scsSource;
-  newParams.m_autoFormatInfo = params.m_autoFormatInfo;
-  newParams.m_outputStructure = params.m_outputStructure;
-  bool status = m_scsTranslator.Translate(newParams);
+  m_stats = GWFTranslatorStats();
+  bool status;
+  {
+    GWFTranslatorStats::ScopedMeasurement const measurement(&m_stats);
+
+    std::string scsSource;
+    if (m_memoryBudget == 0)
+    {
+      std::string const & scsText =
+          TranslateFileToSCs(params.m_fileName, &m_stats, std::pmr::get_default_resource(), m_blobStore);
+      GWFTranslatorStats::ScopedMeasurement const phaseMeasurement(&m_stats, Phase::FileWrite);
+      scsSource = WriteStringToFile(scsText, params.m_fileName);
+    }
+    else
+      scsSource = TranslateFileToSCsFile(params.m_fileName, m_memoryBudget, &m_stats, m_blobStore);
+
+    Params newParams;
+    newParams.m_fileName = scsSource;
+    newParams.m_autoFormatInfo = params.m_autoFormatInfo;
+    newParams.m_outputStructure = params.m_outputStructure;
+    {
+      GWFTranslatorStats::ScopedMeasurement const phaseMeasurement(&m_stats, Phase::SCsTranslation);
+      status = m_scsTranslator.Translate(newParams);
+    }
+
+    std::filesystem::remove(scsSource.c_str());
+  }
 
-  std::filesystem::remove(scsSource.c_str());
+  if (m_isStatsLoggingEnabled)
+    SC_LOG_INFO("GWFTranslator: Translation stats of `" << params.m_fileName << "`: " << m_stats.ToJSON());
 
   return status;
 }
 
-std::string GWFTranslator::TranslateXMLFileContentToSCs(std::string const & filename)
+GWFTranslatorStats const & GWFTranslator::GetStats() const
+{
+  return m_stats;
+}
+
+void GWFTranslator::SetStatsLogging(bool isEnabled)
+{
+  m_isStatsLoggingEnabled = isEnabled;
+}
+
+void GWFTranslator::SetMemoryBudget(std::size_t memoryBudget)
+{
+  if (memoryBudget > 0 && memoryBudget < GWFSpillFile::GetMinMemoryBudget())
+  {
+    SC_LOG_WARNING(
+        "GWFTranslator::SetMemoryBudget: Memory budget of " << memoryBudget << " bytes is below the smallest spill of "
+                                                            << GWFSpillFile::GetMinMemoryBudget()
+                                                            << " bytes, it's raised to it.");
+    memoryBudget = GWFSpillFile::GetMinMemoryBudget();
+  }
+  m_memoryBudget = memoryBudget;
+}
+
+void GWFTranslator::SetBlobStore(GWFBlobStore * blobStore)
+{
+  m_blobStore = blobStore;
+}
+
+std::string GWFTranslator::TranslateXMLFileContentToSCs(
+    std::string const & filename,
+    GWFTranslatorStats * stats,
+    std::pmr::memory_resource * upstream)
+{
+  GWFTranslatorStats::ScopedMeasurement const measurement(stats);
+  return TranslateFileToSCs(filename, stats, upstream);
+}
+
+GWFGraphStatistics GWFTranslator::CollectGraphStatistics(std::string const & filename)
+{
+  return GWFGraphStatistics::Collect(GetXMLFileContent(filename), filename);
+}
+
+std::string GWFTranslator::TranslateFileToSCs(
+    std::string const & filename,
+    GWFTranslatorStats * stats,
+    std::pmr::memory_resource * upstream,
+    GWFBlobStore * blobStore)
+{
+  GWFTracer::ScopedSpan const span("file", filename);
+
+  std::size_t inputBytes = 0;
+  std::string scsText;
+  if (blobStore != nullptr)
+  {
+    // Image contents are stored while they're read, so the gwf text isn't needed as a whole
+    Buffer scsBuffer;
+    inputBytes = RenderGWFFileToSCs(filename, scsBuffer, stats, {blobStore, nullptr}, upstream);
+    scsText = scsBuffer.GetValue();
+  }
+  else
+  {
+    std::string gwfText;
+    {
+      GWFTranslatorStats::ScopedMeasurement const measurement(stats, GWFTranslatorStats::Phase::FileRead);
+      gwfText = GetXMLFileContent(filename);
+    }
+    inputBytes = gwfText.size();
+    scsText = TranslateGWFToSCs(std::move(gwfText), filename, stats, upstream);
+  }
+
+  if (stats != nullptr)
+  {
+    stats->m_inputBytes = inputBytes;
+    stats->m_outputBytes = scsText.size();
+  }
+
+  return scsText;
+}
+
+std::string GWFTranslator::TranslateFileToSCsFile(
+    std::string const & filename,
+    std::size_t memoryBudget,
+    GWFTranslatorStats * stats,
+    GWFBlobStore * blobStore)
 {
-  std::string const & gwfText = GetXMLFileContent(filename);
-  return TranslateGWFToSCs(gwfText, filename);
+  GWFTracer::ScopedSpan const span("file", filename);
+
+  GWFSpillFile spillFile(memoryBudget);
+  Buffer scsBuffer(&spillFile);
+  std::size_t const inputBytes = RenderGWFFileToSCs(
+      filename, scsBuffer, stats, {blobStore, &spillFile}, std::pmr::get_default_resource());
+
+  std::string scsSource;
+  {
+    GWFTranslatorStats::ScopedMeasurement const measurement(stats, GWFTranslatorStats::Phase::FileWrite);
+    scsSource = WriteToFile(
+        filename,
+        [&scsBuffer](std::ostream & stream)
+        {
+          scsBuffer.WriteTo(stream);
+        });
+  }
+
+  if (spillFile.GetSpilledBytes() > 0)
+    SC_LOG_INFO(
+        "GWFTranslator: Translation of `" << filename << "` exceeded the memory budget of "
+                                          << spillFile.GetMemoryBudget() << " bytes, " << spillFile.GetSpilledBytes()
+                                          << " bytes have been spilled.");
+
+  if (stats != nullptr)
+  {
+    stats->m_inputBytes = inputBytes;
+    stats->m_outputBytes = scsBuffer.GetSize();
+    stats->m_spilledBytes = spillFile.GetSpilledBytes();
+    stats->m_spillsCount = spillFile.GetSpillsCount();
+  }
+
+  return scsSource;
 }
 
+// Reads raw bytes of a file: parsing it into a document only to dump it back would build a second document, as large
+// as the one the parser builds, before the translation starts
 std::string GWFTranslator::GetXMLFileContent(std::string const & fileName)
 {
-  xmlInitParser();
+  std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+  if (!file.is_open())
+    SC_THROW_EXCEPTION(
+        utils::ExceptionParseError, "GWFTranslator::GetXMLFileContent: Failed to open XML file `" << fileName << "`.");
 
-  xmlDocPtr const & document = xmlReadFile(fileName.c_str(), nullptr, 0);
-  if (document == nullptr)
+  std::string xmlString(static_cast<std::size_t>(file.tellg()), '\0');
+  file.seekg(0);
+  if (!file.read(xmlString.data(), static_cast<std::streamsize>(xmlString.size())))
     SC_THROW_EXCEPTION(
-        utils::ExceptionParseError, "GWFTranslator::GetXMLFileContent: Failed to parse XML file `" << fileName << "`.");
+        utils::ExceptionParseError, "GWFTranslator::GetXMLFileContent: Failed to read XML file `" << fileName << "`.");
+
+  return xmlString;
+}
 
-  xmlChar * xmlBuffer;
-  int bufferSize;
-  xmlDocDumpFormatMemory(document, &xmlBuffer, &bufferSize, 0);
+std::string GWFTranslator::TranslateGWFToSCs(
+    std::string && xmlStr,
+    std::string const & filePath,
+    GWFTranslatorStats * stats,
+    std::pmr::memory_resource * upstream,
+    GWFBlobStore * blobStore)
+{
+  Buffer scsBuffer;
+  RenderGWFToSCs(std::move(xmlStr), filePath, scsBuffer, stats, {blobStore, nullptr}, upstream);
+  return scsBuffer.GetValue();
+}
 
-  std::string xmlString((char *)xmlBuffer, bufferSize);
+void GWFTranslator::RenderGWFToSCs(
+    std::string && xmlStr,
+    std::string const & filePath,
+    Buffer & buffer,
+    GWFTranslatorStats * stats,
+    GWFContentStorage const & storage,
+    std::pmr::memory_resource * upstream)
+{
+  // Elements and containers of the translation are released together with the resource, after all of them are destroyed
+  std::pmr::monotonic_buffer_resource resource(upstream);
+  SCgElements elementsWithoutParents(&resource);
 
-  xmlFree(xmlBuffer);
-  xmlFreeDoc(document);
-  xmlCleanupParser();
+  // Unless contents are stored or spilled, images stay encoded until they are written. The gwf text is released once
+  // it's read anyway, only ranges of the images are kept.
+  GWFContentStorage documentStorage = storage;
+  documentStorage.m_isContentDeferred = storage.m_blobStore == nullptr && storage.m_spillFile == nullptr;
+  GWFParser::Parse(std::move(xmlStr), elementsWithoutParents, stats, documentStorage, filePath);
 
-  return xmlString;
+  RenderElements(elementsWithoutParents, filePath, buffer, stats);
 }
 
-std::string GWFTranslator::TranslateGWFToSCs(std::string const & xmlStr, std::string const & filePath)
+std::size_t GWFTranslator::RenderGWFFileToSCs(
+    std::string const & filePath,
+    Buffer & buffer,
+    GWFTranslatorStats * stats,
+    GWFContentStorage const & storage,
+    std::pmr::memory_resource * upstream)
 {
-  SCgElements elementsWithoutParents;
+  std::pmr::monotonic_buffer_resource resource(upstream);
+  SCgElements elementsWithoutParents(&resource);
+  std::size_t const inputBytes = GWFParser::ParseFile(filePath, elementsWithoutParents, stats, storage);
 
-  GWFParser::Parse(xmlStr, elementsWithoutParents);
+  RenderElements(elementsWithoutParents, filePath, buffer, stats);
+  return inputBytes;
+}
 
+void GWFTranslator::RenderElements(
+    SCgElements const & elementsWithoutParents,
+    std::string const & filePath,
+    Buffer & buffer,
+    GWFTranslatorStats * stats)
+{
   if (elementsWithoutParents.empty())
     SC_THROW_EXCEPTION(
         utils::ExceptionParseError,
         "GWFTranslator::TranslateGWFToSCs: There are no elements in file `" << filePath << "`.");
 
-  Buffer scsBuffer;
-  std::unordered_set<SCgElementPtr> writtenElements;
-  SCsWriter::Write(elementsWithoutParents, filePath, scsBuffer, 0, writtenElements);
-
-  return scsBuffer.GetValue();
+  GWFTranslatorStats::ScopedMeasurement const measurement(stats, GWFTranslatorStats::Phase::SCsRendering);
+  std::pmr::memory_resource * resource = elementsWithoutParents.get_allocator().resource();
+  SCsWriter::IdentifierIndex const identifiers(elementsWithoutParents, resource);
+  SCgElementsSet writtenElements(resource);
+  SCsWriter::Write(elementsWithoutParents, filePath, buffer, 0, writtenElements, identifiers);
+  if (stats != nullptr)
+    stats->m_identifierCollisionsCount = identifiers.GetCollisionsCount();
 }
 
 std::string GWFTranslator::WriteStringToFile(std::string const & scsText, std::string const & fileName)
+{
+  return WriteToFile(
+      fileName,
+      [&scsText](std::ostream & stream)
+      {
+        stream << scsText;
+      });
+}
+
+std::string GWFTranslator::WriteToFile(
+    std::string const & fileName,
+    std::function<void(std::ostream & stream)> const & write)
 {
   std::string const & filePath = fileName + GENERATED_EXTENTION + SCS_EXTENTION;
   std::ofstream outputFile(filePath, std::ios::binary);
@@ -92,16 +290,16 @@ std::string GWFTranslator::WriteStringToFile(std::string const & scsText, std::s
   if (!outputFile.is_open())
     SC_THROW_EXCEPTION(
         utils::ExceptionCritical,
-        "GWFTranslator::WriteStringToFile: Error creating file for writing `" << filePath << "`.");
+        "GWFTranslator::WriteToFile: Error creating file for writing `" << filePath << "`.");
 
-  outputFile << scsText;
+  write(outputFile);
 
   if (outputFile.fail())
   {
     outputFile.close();
     std::remove(filePath.c_str());
     SC_THROW_EXCEPTION(
-        utils::ExceptionCritical, "GWFTranslator::WriteStringToFile: Error writing to file `" << filePath << "`.");
+        utils::ExceptionCritical, "GWFTranslator::WriteToFile: Error writing to file `" << filePath << "`.");
   }
 
   outputFile.close();
@@ -110,7 +308,7 @@ std::string GWFTranslator::WriteStringToFile(std::string const & scsText, std::s
   {
     std::remove(filePath.c_str());
     SC_THROW_EXCEPTION(
-        utils::ExceptionCritical, "GWFTranslator::WriteStringToFile: Error closing the file `" << filePath << "`.");
+        utils::ExceptionCritical, "GWFTranslator::WriteToFile: Error closing the file `" << filePath << "`.");
   }
 
   return filePath;
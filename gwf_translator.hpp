@@ -6,14 +6,24 @@
 
 #pragma once
 
+#include <functional>
+#include <ostream>
 #include <vector>
 #include <string>
 #include <list>
+#include <memory_resource>
 
 #include "sc-builder/translator.hpp"
 
 #include "scs_translator.hpp"
 
+#include "buffer.hpp"
+#include "gwf_blob_store.hpp"
+#include "gwf_graph_statistics.hpp"
+#include "gwf_parser.hpp"
+#include "gwf_spill_file.hpp"
+#include "gwf_translator_stats.hpp"
+
 class GWFTranslator : public Translator
 {
 public:
@@ -22,12 +32,76 @@ public:
 
   bool TranslateImpl(Params const & params) override;
 
-  static std::string TranslateXMLFileContentToSCs(std::string const & filename);
+  // Elements of the translation are allocated from a monotonic buffer resource over upstream and freed at once when the
+  // translation ends. A caller that translates many files can pass a pooling upstream to reuse memory between them.
+  static std::string TranslateXMLFileContentToSCs(
+      std::string const & filename,
+      GWFTranslatorStats * stats = nullptr,
+      std::pmr::memory_resource * upstream = std::pmr::get_default_resource());
+  // Parses a file without translating it, see GWFGraphStatistics
+  static GWFGraphStatistics CollectGraphStatistics(std::string const & filename);
+
+  // Figures of the last TranslateImpl call, SCs translation into sc-memory included
+  GWFTranslatorStats const & GetStats() const;
+  // If enabled, TranslateImpl logs the figures of every translation as JSON
+  void SetStatsLogging(bool isEnabled);
+  // Bytes that a translation may keep resident in link contents and the SCs buffer before they are spilled to a
+  // temporary file, see GWFSpillFile. 0, the default, means no budget. A budget below
+  // GWFSpillFile::GetMinMemoryBudget is raised to it with a warning.
+  void SetMemoryBudget(std::size_t memoryBudget);
+  // If set, image contents are stored once in the blob store and SCs texts refer to them. The store isn't owned.
+  void SetBlobStore(GWFBlobStore * blobStore);
 
 protected:
   SCsTranslator m_scsTranslator;
+  GWFTranslatorStats m_stats;
+  bool m_isStatsLoggingEnabled;
+  std::size_t m_memoryBudget;
+  GWFBlobStore * m_blobStore;
+
+  static std::string TranslateFileToSCs(
+      std::string const & filename,
+      GWFTranslatorStats * stats,
+      std::pmr::memory_resource * upstream = std::pmr::get_default_resource(),
+      GWFBlobStore * blobStore = nullptr);
+  // Writes the SCs text to a file without keeping it in memory, returns the path of the file
+  static std::string TranslateFileToSCsFile(
+      std::string const & filename,
+      std::size_t memoryBudget,
+      GWFTranslatorStats * stats,
+      GWFBlobStore * blobStore);
 
   static std::string WriteStringToFile(std::string const & scsStr, std::string const & filePath);
-  static std::string TranslateGWFToSCs(std::string const & xmlStr, std::string const & filePath);
+  static std::string WriteToFile(
+      std::string const & fileName,
+      std::function<void(std::ostream & stream)> const & write);
+  // Rendering functions take the gwf text over. It's released once it's parsed, unless image contents are left in it
+  // until they are written.
+  static std::string TranslateGWFToSCs(
+      std::string && xmlStr,
+      std::string const & filePath,
+      GWFTranslatorStats * stats = nullptr,
+      std::pmr::memory_resource * upstream = std::pmr::get_default_resource(),
+      GWFBlobStore * blobStore = nullptr);
+  static void RenderGWFToSCs(
+      std::string && xmlStr,
+      std::string const & filePath,
+      Buffer & buffer,
+      GWFTranslatorStats * stats,
+      GWFContentStorage const & storage,
+      std::pmr::memory_resource * upstream);
+  // Parses the file while it's read in chunks, so that neither the gwf text nor large image contents are ever resident
+  // as a whole. Returns the size of the file.
+  static std::size_t RenderGWFFileToSCs(
+      std::string const & filePath,
+      Buffer & buffer,
+      GWFTranslatorStats * stats,
+      GWFContentStorage const & storage,
+      std::pmr::memory_resource * upstream);
+  static void RenderElements(
+      SCgElements const & elementsWithoutParents,
+      std::string const & filePath,
+      Buffer & buffer,
+      GWFTranslatorStats * stats);
   static std::string GetXMLFileContent(std::string const & filename);
 };
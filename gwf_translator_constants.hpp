@@ -7,8 +7,11 @@
 #pragma once
 
 #include <memory>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <unordered_set>
 #include <libxml/xmlstring.h>
 
 namespace Constants
@@ -49,6 +52,7 @@ std::string const FILE_PREFIX = "file://";
 std::string const EL_PREFIX = "..el";
 std::string const EL_VAR_PREFIX = ".._el";
 std::string const SCS_EXTENTION = ".scs";
+std::string const GWF_EXTENTION = ".gwf";
 std::string const GENERATED_EXTENTION = ".generated";
 
 std::string const OPEN_PARENTHESIS = "(";
@@ -87,6 +91,10 @@ xmlChar const * const CONTENT = (xmlChar const *)"content";
 using SCsElementPtr = std::shared_ptr<class SCsElement>;
 using SCgElementPtr = std::shared_ptr<class SCgElement>;
 
-using SCgElements = std::unordered_map<std::string, SCgElementPtr>;
-using SCgConnectors = std::unordered_map<std::shared_ptr<class SCgConnector>, std::pair<std::string, std::string>>;
-using SCgContours = std::unordered_map<std::string, SCgElements>;
+// Containers of a translation allocate from its memory resource, nested containers take it from the outer ones.
+// Elements are keyed by views of their own ids, which live as long as the elements stored under them
+using SCgElements = std::pmr::unordered_map<std::string_view, SCgElementPtr>;
+using SCgConnectors =
+    std::pmr::unordered_map<std::shared_ptr<class SCgConnector>, std::pair<std::pmr::string, std::pmr::string>>;
+using SCgContours = std::pmr::unordered_map<std::pmr::string, SCgElements>;
+using SCgElementsSet = std::pmr::unordered_set<SCgElementPtr>;
@@ -0,0 +1,337 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "gwf_translator_stats.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <sstream>
+#include <unordered_set>
+
+#include <sys/resource.h>
+
+#include <sc-memory/sc_debug.hpp>
+
+#include "gwf_allocation_counter.hpp"
+
+namespace
+{
+// Counters are written in total and per element, so that diagrams of different sizes can be compared. Unavailable
+// counters are left out instead of being reported as zeros.
+void WriteCounters(std::stringstream & json, GWFPerfCounters::Values const & counters, std::size_t elementsCount)
+{
+  using Counter = GWFPerfCounters::Counter;
+
+  std::stringstream perElement;
+  json << ", \"counters\": {";
+  perElement << ", \"counters_per_element\": {";
+  bool isFirst = true;
+  for (std::size_t i = 0; i < counters.size(); ++i)
+  {
+    auto const counter = static_cast<Counter>(i);
+    if (!GWFPerfCounters::IsAvailable(counter))
+      continue;
+
+    if (!isFirst)
+    {
+      json << ", ";
+      perElement << ", ";
+    }
+    isFirst = false;
+
+    char const * name = GWFPerfCounters::GetCounterName(counter);
+    json << "\"" << name << "\": " << counters[i];
+    perElement << "\"" << name << "\": " << (elementsCount > 0 ? static_cast<double>(counters[i]) / elementsCount : 0);
+  }
+  json << "}" << perElement.str() << "}";
+}
+
+void WriteFigures(
+    std::stringstream & json,
+    GWFTranslatorStats::Figures const & figures,
+    std::size_t elementsCount)
+{
+  json << "\"wall_time\": " << figures.m_wallTime << ", \"cpu_time\": " << figures.m_cpuTime
+       << ", \"allocated_bytes\": " << figures.m_allocatedBytes << ", \"allocations\": " << figures.m_allocationsCount
+       << ", \"peak_live_bytes\": " << figures.m_peakLiveBytes;
+
+  if (GWFPerfCounters::IsEnabled())
+    WriteCounters(json, figures.m_counters, elementsCount);
+}
+}  // namespace
+
+GWFTranslatorStats::Figures const & GWFTranslatorStats::GetPhase(Phase phase) const
+{
+  return m_phases[static_cast<std::size_t>(phase)];
+}
+
+std::size_t GWFTranslatorStats::GetElementsCount() const
+{
+  return m_elements.m_nodes + m_elements.m_links + m_elements.m_buses + m_elements.m_contours
+         + m_elements.m_connectors;
+}
+
+char const * GWFTranslatorStats::GetPhaseName(Phase phase)
+{
+  switch (phase)
+  {
+  case Phase::FileRead:
+    return "file_read";
+  case Phase::XMLParse:
+    return "xml_parse";
+  case Phase::Validation:
+    return "validation";
+  case Phase::ElementCreation:
+    return "element_creation";
+  case Phase::ConnectorResolution:
+    return "connector_resolution";
+  case Phase::ContourResolution:
+    return "contour_resolution";
+  case Phase::SCsRendering:
+    return "scs_rendering";
+  case Phase::FileWrite:
+    return "file_write";
+  case Phase::SCsTranslation:
+    return "scs_translation";
+  default:
+    return "unknown";
+  }
+}
+
+std::string GWFTranslatorStats::ToJSON() const
+{
+  std::stringstream json;
+  json << "{";
+  WriteFigures(json, m_total, GetElementsCount());
+  json << ", \"exact_allocations\": " << (GWFAllocationCounter::IsExact() ? "true" : "false")
+       << ", \"peak_rss\": " << m_peakRSS << ", \"input_bytes\": " << m_inputBytes
+       << ", \"output_bytes\": " << m_outputBytes << ", \"spilled_bytes\": " << m_spilledBytes
+       << ", \"spills\": " << m_spillsCount << ", \"identifier_collisions\": " << m_identifierCollisionsCount
+       << ", \"elements\": {\"nodes\": " << m_elements.m_nodes
+       << ", \"links\": " << m_elements.m_links << ", \"buses\": " << m_elements.m_buses
+       << ", \"contours\": " << m_elements.m_contours << ", \"connectors\": " << m_elements.m_connectors
+       << "}, \"phases\": {";
+
+  for (std::size_t i = 0; i < m_phases.size(); ++i)
+  {
+    if (i > 0)
+      json << ", ";
+    json << "\"" << GetPhaseName(static_cast<Phase>(i)) << "\": {";
+    WriteFigures(json, m_phases[i], GetElementsCount());
+    json << "}";
+  }
+
+  json << "}}";
+  return json.str();
+}
+
+std::vector<std::string> GWFTranslatorStats::FindRegressions(
+    std::string const & reportJSON,
+    std::string const & baselineJSON,
+    double thresholdPercent)
+{
+  auto const & report = ReadNumbers(reportJSON);
+  auto const & baseline = ReadNumbers(baselineJSON);
+
+  std::vector<std::string> regressions;
+  for (auto const & [name, baselineValue] : baseline)
+  {
+    if (!IsCost(name))
+      continue;
+
+    auto const it = report.find(name);
+    if (it == report.cend())
+      continue;
+
+    // No percentage of zero can be exceeded, so a cost that was zero regresses as soon as it appears, e.g. heap
+    // allocations of a warm translation
+    std::stringstream regression;
+    if (baselineValue == 0)
+    {
+      if (it->second > 0)
+        regression << name << ": " << it->second << " where baseline is 0";
+    }
+    else if (it->second > baselineValue * (1 + thresholdPercent / 100))
+      regression << name << ": " << it->second << " exceeds baseline " << baselineValue << " by more than "
+                 << thresholdPercent << "%";
+
+    if (!regression.str().empty())
+      regressions.push_back(regression.str());
+  }
+  return regressions;
+}
+
+// Costs are times, allocations, bytes that are held or spilled and hardware counters. Other figures describe the
+// diagram, e.g. input bytes or counts of elements, spills and identifier collisions: they differ from the baseline
+// when the input does, not when the translator gets slower
+bool GWFTranslatorStats::IsCost(std::string const & name)
+{
+  static std::unordered_set<std::string> const costs = {
+      "wall_time", "cpu_time", "allocated_bytes", "allocations", "peak_live_bytes", "peak_rss", "spilled_bytes"};
+
+  std::size_t const groupEnd = name.rfind('.');
+  if (groupEnd == std::string::npos || groupEnd == 0)
+    return costs.count(name) > 0;
+  if (costs.count(name.substr(groupEnd + 1)) > 0)
+    return true;
+
+  std::size_t const groupStart = name.rfind('.', groupEnd - 1);
+  std::size_t const groupBegin = groupStart == std::string::npos ? 0 : groupStart + 1;
+  std::string const group = name.substr(groupBegin, groupEnd - groupBegin);
+  return group == "counters" || group == "counters_per_element";
+}
+
+// Reads all numbers of a JSON document, nested figures are named by their path, e.g. `phases.xml_parse.wall_time`.
+// Strings, booleans and arrays are skipped: reports and baselines don't compare them.
+std::unordered_map<std::string, double> GWFTranslatorStats::ReadNumbers(std::string const & json)
+{
+  std::unordered_map<std::string, double> numbers;
+  std::vector<std::string> path;
+  std::string key;
+  size_t arraysDepth = 0;
+
+  auto const & getName = [&]()
+  {
+    std::string name;
+    for (auto const & part : path)
+      name += part + ".";
+    return name + key;
+  };
+
+  for (size_t i = 0; i < json.size(); ++i)
+  {
+    char const symbol = json[i];
+    if (symbol == '"')
+    {
+      size_t const end = json.find('"', i + 1);
+      if (end == std::string::npos)
+        SC_THROW_EXCEPTION(utils::ExceptionParseError, "GWFTranslatorStats::ReadNumbers: Unterminated string.");
+
+      std::string const string = json.substr(i + 1, end - i - 1);
+      i = end;
+
+      size_t const next = json.find_first_not_of(" \t\r\n", i + 1);
+      if (arraysDepth == 0 && next != std::string::npos && json[next] == ':')
+        key = string;
+    }
+    else if (symbol == '{' && arraysDepth == 0)
+    {
+      if (!key.empty())
+        path.push_back(key);
+      key.clear();
+    }
+    else if (symbol == '}' && arraysDepth == 0)
+    {
+      if (!path.empty())
+        path.pop_back();
+      key.clear();
+    }
+    else if (symbol == '[')
+      ++arraysDepth;
+    else if (symbol == ']' && arraysDepth > 0)
+      --arraysDepth;
+    else if ((symbol == '-' || (symbol >= '0' && symbol <= '9')) && arraysDepth == 0 && !key.empty())
+    {
+      char * end = nullptr;
+      double const value = std::strtod(json.c_str() + i, &end);
+      numbers[getName()] = value;
+      i = end - json.c_str() - 1;
+      key.clear();
+    }
+  }
+
+  return numbers;
+}
+
+GWFTranslatorStats::ScopedMeasurement::ScopedMeasurement(GWFTranslatorStats * stats)
+  : ScopedMeasurement(stats, Phase::Count)
+{
+}
+
+GWFTranslatorStats::ScopedMeasurement::ScopedMeasurement(GWFTranslatorStats * stats, Phase phase)
+  : m_span(phase == Phase::Count ? nullptr : "phase", GetPhaseName(phase))
+  , m_stats(stats)
+  , m_figures(nullptr)
+  , m_cpuStart(0)
+  , m_allocatedBytesStart(0)
+  , m_allocationsCountStart(0)
+  , m_liveBytesStart(0)
+  , m_enclosingPeakLiveBytes(0)
+  , m_countersStart{}
+{
+  if (m_stats == nullptr)
+    return;
+
+  m_figures = phase == Phase::Count ? &m_stats->m_total : &m_stats->m_phases[static_cast<std::size_t>(phase)];
+
+  auto const & snapshot = GWFAllocationCounter::TakeSnapshot();
+  m_allocatedBytesStart = snapshot.m_allocatedBytes;
+  m_allocationsCountStart = snapshot.m_allocationsCount;
+  m_liveBytesStart = snapshot.m_liveBytes;
+  m_enclosingPeakLiveBytes = GWFAllocationCounter::ResetPeakLiveBytes();
+
+  m_wallStart = std::chrono::steady_clock::now();
+  m_cpuStart = GetThreadCPUTime();
+  if (GWFPerfCounters::IsEnabled())
+    m_countersStart = GWFPerfCounters::Read();
+}
+
+GWFTranslatorStats::ScopedMeasurement::~ScopedMeasurement()
+{
+  if (m_stats == nullptr)
+    return;
+
+  if (GWFPerfCounters::IsEnabled())
+  {
+    auto const & counters = GWFPerfCounters::Read();
+    for (std::size_t i = 0; i < counters.size(); ++i)
+      m_figures->m_counters[i] += counters[i] - m_countersStart[i];
+  }
+
+  m_figures->m_wallTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - m_wallStart).count();
+  m_figures->m_cpuTime += GetThreadCPUTime() - m_cpuStart;
+
+  auto const & snapshot = GWFAllocationCounter::TakeSnapshot();
+  std::size_t const peakLiveBytes = std::max(GWFAllocationCounter::GetPeakLiveBytes(), m_liveBytesStart);
+  GWFAllocationCounter::RestorePeakLiveBytes(m_enclosingPeakLiveBytes);
+
+  if (GWFAllocationCounter::IsExact())
+  {
+    m_figures->m_allocatedBytes += snapshot.m_allocatedBytes - m_allocatedBytesStart;
+    m_figures->m_allocationsCount += snapshot.m_allocationsCount - m_allocationsCountStart;
+  }
+  else if (snapshot.m_liveBytes > m_liveBytesStart)
+  {
+    // Without exact counting only growth of live bytes is known
+    m_figures->m_allocatedBytes += snapshot.m_liveBytes - m_liveBytesStart;
+  }
+  m_figures->m_peakLiveBytes = std::max(m_figures->m_peakLiveBytes, peakLiveBytes);
+  // Without exact counting peaks are sampled at scope ends only, so phases also report their peaks to the total
+  m_stats->m_total.m_peakLiveBytes = std::max(m_stats->m_total.m_peakLiveBytes, peakLiveBytes);
+
+  if (m_figures == &m_stats->m_total)
+    m_stats->m_peakRSS = GetPeakRSS();
+}
+
+double GWFTranslatorStats::GetThreadCPUTime()
+{
+  timespec time;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0)
+    return 0;
+
+  return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+std::size_t GWFTranslatorStats::GetPeakRSS()
+{
+  rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+
+  // Linux reports kilobytes
+  return static_cast<std::size_t>(usage.ru_maxrss) * 1024;
+}
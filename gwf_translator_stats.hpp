@@ -0,0 +1,133 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gwf_perf_counters.hpp"
+#include "gwf_tracer.hpp"
+
+/*!
+ * Figures of one translation. They are gathered only if a caller passes a stats object to the translator, so
+ * translations without stats don't pay for measurements.
+ */
+struct GWFTranslatorStats
+{
+  enum class Phase : std::size_t
+  {
+    FileRead,
+    XMLParse,
+    Validation,
+    ElementCreation,
+    ConnectorResolution,
+    ContourResolution,
+    SCsRendering,
+    FileWrite,
+    SCsTranslation,
+    Count
+  };
+
+  struct Figures
+  {
+    // Seconds
+    double m_wallTime = 0;
+    // Seconds of CPU time of the translating thread
+    double m_cpuTime = 0;
+    std::size_t m_allocatedBytes = 0;
+    std::size_t m_allocationsCount = 0;
+    // High-water mark of live heap bytes of the process
+    std::size_t m_peakLiveBytes = 0;
+    // Hardware counters of the translating thread, gathered only if GWFPerfCounters are enabled
+    GWFPerfCounters::Values m_counters{};
+  };
+
+  struct ElementsCounts
+  {
+    std::size_t m_nodes = 0;
+    std::size_t m_links = 0;
+    std::size_t m_buses = 0;
+    std::size_t m_contours = 0;
+    std::size_t m_connectors = 0;
+  };
+
+  Figures m_total;
+  std::array<Figures, static_cast<std::size_t>(Phase::Count)> m_phases;
+
+  // Bytes, high-water mark of the whole process
+  std::size_t m_peakRSS = 0;
+  std::size_t m_inputBytes = 0;
+  std::size_t m_outputBytes = 0;
+  // Bytes written to the spill file by a bounded-memory translation, see GWFSpillFile
+  std::size_t m_spilledBytes = 0;
+  std::size_t m_spillsCount = 0;
+  // Names of elements without identifiers that were suffixed not to merge with other elements, see
+  // SCsWriter::IdentifierIndex
+  std::size_t m_identifierCollisionsCount = 0;
+  ElementsCounts m_elements;
+
+  std::size_t GetElementsCount() const;
+
+  Figures const & GetPhase(Phase phase) const;
+  static char const * GetPhaseName(Phase phase);
+
+  std::string ToJSON() const;
+
+  /*!
+   * Compares cost figures of a JSON report with the same figures of a baseline report: times, allocations, bytes that
+   * are held or spilled and hardware counters. A cost that exceeds its baseline by more than thresholdPercent is a
+   * regression, and so is a cost that is above zero where its baseline is zero. Figures that describe the diagram
+   * aren't compared, e.g. input bytes or counts of elements.
+   * @returns Descriptions of all regressions, empty if there are none.
+   */
+  static std::vector<std::string> FindRegressions(
+      std::string const & reportJSON,
+      std::string const & baselineJSON,
+      double thresholdPercent);
+
+  /*!
+   * Measures wall and CPU time of a scope with a monotonic clock, and heap allocations made during it (see
+   * GWFAllocationCounter), and hardware counters if they are enabled. Without a phase it measures the whole translation
+   * and also records the peak RSS at its end.
+   * Does nothing if stats is nullptr. Phases are also recorded as trace spans if tracing is enabled, with or without
+   * stats.
+   */
+  class ScopedMeasurement
+  {
+  public:
+    explicit ScopedMeasurement(GWFTranslatorStats * stats);
+    ScopedMeasurement(GWFTranslatorStats * stats, Phase phase);
+    ~ScopedMeasurement();
+
+    ScopedMeasurement(ScopedMeasurement const &) = delete;
+    ScopedMeasurement & operator=(ScopedMeasurement const &) = delete;
+
+  private:
+    GWFTracer::ScopedSpan m_span;
+    GWFTranslatorStats * m_stats;
+    Figures * m_figures;
+    std::chrono::steady_clock::time_point m_wallStart;
+    double m_cpuStart;
+    std::size_t m_allocatedBytesStart;
+    std::size_t m_allocationsCountStart;
+    std::size_t m_liveBytesStart;
+    int64_t m_enclosingPeakLiveBytes;
+    GWFPerfCounters::Values m_countersStart;
+  };
+
+  static double GetThreadCPUTime();
+  static std::size_t GetPeakRSS();
+
+private:
+  static std::unordered_map<std::string, double> ReadNumbers(std::string const & json);
+  static bool IsCost(std::string const & name);
+};
@@ -0,0 +1,316 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "gwf_validator.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <optional>
+#include <sstream>
+#include <string_view>
+#include <unordered_map>
+
+#include <sc-memory/sc_debug.hpp>
+
+#include "gwf_translator_constants.hpp"
+
+using namespace Constants;
+
+namespace
+{
+std::size_t const NO_INDEX = static_cast<std::size_t>(-1);
+
+// Types of these kinds are written as SCs types, strict check requires them to be types of the same kind
+std::string const NODE_TYPE_PREFIX = "node/";
+std::string const PAIR_TYPE_PREFIX = "pair/";
+std::string const ARC_TYPE_PREFIX = "arc/";
+
+enum class Kind
+{
+  Node,
+  Bus,
+  Contour,
+  Connector,
+  // Element with a tag that isn't supported. It's indexed to resolve references to it, but references aren't checked
+  // further, so that the tag is reported once instead of for every element that refers to it
+  Unsupported
+};
+
+// Element of the static sector, references are kept as ids until all elements are indexed. Properties are views of
+// the document.
+struct Element
+{
+  xmlNodePtr m_node = nullptr;
+  Kind m_kind = Kind::Node;
+  std::string_view m_id;
+  std::optional<std::string_view> m_parent;
+  // Ends of a connector, owner of a bus is kept as its source
+  std::optional<std::string_view> m_source;
+  std::optional<std::string_view> m_target;
+};
+
+// Values of attributes are read in place, unless they are made of several nodes because of entity references; these
+// are assembled into storage
+std::optional<std::string_view> GetProperty(
+    xmlNodePtr node,
+    std::string const & name,
+    std::pmr::deque<std::pmr::string> & storage)
+{
+  xmlAttrPtr const attribute = xmlHasProp(node, BAD_CAST name.c_str());
+  if (attribute == nullptr || attribute->type != XML_ATTRIBUTE_NODE)
+    return std::nullopt;
+
+  xmlNodePtr const value = attribute->children;
+  if (value == nullptr)
+    return std::string_view();
+  if (value->next == nullptr && value->type == XML_TEXT_NODE && value->content != nullptr)
+    return std::string_view(reinterpret_cast<char const *>(value->content));
+
+  xmlChar * assembledValue = xmlNodeListGetString(node->doc, value, 1);
+  storage.emplace_back(assembledValue != nullptr ? reinterpret_cast<char const *>(assembledValue) : "");
+  xmlFree(assembledValue);
+  return std::string_view(storage.back());
+}
+
+bool StartsWith(std::string_view string, std::string const & prefix)
+{
+  return string.compare(0, prefix.size(), prefix) == 0;
+}
+
+std::string Quote(std::string_view string)
+{
+  return "`" + std::string(string) + "`";
+}
+}  // namespace
+
+std::string GWFValidator::Problem::ToString() const
+{
+  std::stringstream string;
+  string << "line " << m_line;
+  if (!m_elementId.empty())
+    string << ", element `" << m_elementId << "`";
+  string << ": " << m_description;
+  return string.str();
+}
+
+std::vector<GWFValidator::Problem> GWFValidator::Validate(
+    xmlNodePtr staticSector,
+    std::pmr::memory_resource * resource,
+    bool isStrict)
+{
+  std::vector<Problem> problems;
+  auto const & addProblem = [&problems](xmlNodePtr node, std::string const & elementId, std::string description)
+  {
+    problems.push_back({xmlGetLineNo(node), elementId, std::move(description)});
+  };
+
+  // Elements are indexed in document order, element properties and states of the walk over contour parents are bits at
+  // element indices
+  std::size_t const elementsCount = xmlChildElementCount(staticSector);
+  std::pmr::vector<Element> elements(resource);
+  elements.reserve(elementsCount);
+  std::pmr::unordered_map<std::string_view, std::size_t> indices(resource);
+  indices.reserve(elementsCount);
+  std::pmr::deque<std::pmr::string> assembledProperties(resource);
+  std::pmr::vector<bool> isContour(resource);
+  isContour.reserve(elementsCount);
+  std::pmr::vector<bool> isBus(resource);
+  isBus.reserve(elementsCount);
+  std::pmr::vector<bool> isSupported(resource);
+  isSupported.reserve(elementsCount);
+
+  for (xmlNodePtr child = staticSector->children; child != nullptr; child = child->next)
+  {
+    if (child->type != XML_ELEMENT_NODE)
+      continue;
+
+    Element element;
+    element.m_node = child;
+    std::string_view const tag = reinterpret_cast<char const *>(child->name);
+    if (tag == NODE)
+      element.m_kind = Kind::Node;
+    else if (tag == BUS)
+      element.m_kind = Kind::Bus;
+    else if (tag == CONTOUR)
+      element.m_kind = Kind::Contour;
+    else if (tag == PAIR || tag == ARC)
+      element.m_kind = Kind::Connector;
+    else
+    {
+      element.m_kind = Kind::Unsupported;
+      addProblem(
+          child,
+          std::string(GetProperty(child, ID, assembledProperties).value_or("")),
+          "Tag " + Quote(tag) + " isn't supported.");
+    }
+
+    // Element without an id can't be referred to, so it isn't indexed
+    std::optional<std::string_view> const & id = GetProperty(child, ID, assembledProperties);
+    if (!id)
+    {
+      if (element.m_kind != Kind::Unsupported)
+        addProblem(child, "", "Element " + Quote(tag) + " doesn't have property " + Quote(ID) + ".");
+      continue;
+    }
+    element.m_id = *id;
+
+    auto const & getRequiredProperty = [&](xmlNodePtr node, std::string const & name)
+    {
+      std::optional<std::string_view> const property = GetProperty(node, name, assembledProperties);
+      if (!property)
+        addProblem(
+            node, std::string(element.m_id), "Element " + Quote(tag) + " doesn't have property " + Quote(name) + ".");
+      return property;
+    };
+
+    if (element.m_kind != Kind::Unsupported)
+    {
+      element.m_parent = getRequiredProperty(child, PARENT);
+      getRequiredProperty(child, IDENTIFIER);
+    }
+    std::optional<std::string_view> const & type =
+        element.m_kind != Kind::Unsupported ? getRequiredProperty(child, TYPE) : std::nullopt;
+
+    if (element.m_kind == Kind::Node)
+    {
+      if (isStrict && type && !StartsWith(*type, NODE_TYPE_PREFIX))
+        addProblem(child, std::string(element.m_id), "Type " + Quote(*type) + " isn't a node type.");
+
+      for (xmlNodePtr content = child->children; content != nullptr; content = content->next)
+      {
+        if (content->type != XML_ELEMENT_NODE || !xmlStrEqual(content->name, CONTENT))
+          continue;
+
+        std::optional<std::string_view> const & contentType = getRequiredProperty(content, TYPE);
+        if (!contentType || *contentType == NO_CONTENT)
+          continue;
+
+        if (isStrict && (contentType->size() != 1 || (*contentType)[0] < '1' || (*contentType)[0] > '4'))
+          addProblem(content, std::string(element.m_id), "Content type " + Quote(*contentType) + " isn't supported.");
+        getRequiredProperty(content, MIME_TYPE);
+        getRequiredProperty(content, FILE_NAME);
+      }
+    }
+    else if (element.m_kind == Kind::Connector)
+    {
+      if (isStrict && type && !StartsWith(*type, PAIR_TYPE_PREFIX) && !StartsWith(*type, ARC_TYPE_PREFIX))
+        addProblem(child, std::string(element.m_id), "Type " + Quote(*type) + " isn't a connector type.");
+
+      element.m_source = getRequiredProperty(child, ID_B);
+      element.m_target = getRequiredProperty(child, ID_E);
+    }
+    else if (element.m_kind == Kind::Bus)
+      element.m_source = getRequiredProperty(child, OWNER);
+
+    auto const & [it, isInserted] = indices.emplace(element.m_id, elements.size());
+    if (!isInserted)
+    {
+      addProblem(
+          child,
+          std::string(element.m_id),
+          "Id is already used by the element on line " + std::to_string(xmlGetLineNo(elements[it->second].m_node))
+              + ".");
+      continue;
+    }
+
+    isContour.push_back(element.m_kind == Kind::Contour);
+    isBus.push_back(element.m_kind == Kind::Bus);
+    isSupported.push_back(element.m_kind != Kind::Unsupported);
+    elements.push_back(std::move(element));
+  }
+
+  auto const & findIndex = [&indices](std::string_view id)
+  {
+    auto const it = indices.find(id);
+    return it == indices.cend() ? NO_INDEX : it->second;
+  };
+
+  // Only contours can be parents, so every element has one parent contour at most
+  std::pmr::vector<std::size_t> parents(elements.size(), NO_INDEX, resource);
+  for (std::size_t i = 0; i < elements.size(); ++i)
+  {
+    Element const & element = elements[i];
+    if (element.m_parent && *element.m_parent != NO_PARENT)
+    {
+      std::size_t const parent = findIndex(*element.m_parent);
+      if (parent == NO_INDEX)
+        addProblem(element.m_node, std::string(element.m_id), "Parent " + Quote(*element.m_parent) + " doesn't exist.");
+      else if (!isContour[parent] && isSupported[parent])
+        addProblem(
+            element.m_node, std::string(element.m_id), "Parent " + Quote(*element.m_parent) + " isn't a contour.");
+      else
+        parents[i] = parent;
+    }
+
+    if (element.m_kind == Kind::Connector)
+    {
+      if (element.m_source && findIndex(*element.m_source) == NO_INDEX)
+        addProblem(element.m_node, std::string(element.m_id), "Source " + Quote(*element.m_source) + " doesn't exist.");
+      if (element.m_target && findIndex(*element.m_target) == NO_INDEX)
+        addProblem(element.m_node, std::string(element.m_id), "Target " + Quote(*element.m_target) + " doesn't exist.");
+    }
+    else if (element.m_kind == Kind::Bus && element.m_source)
+    {
+      std::size_t const owner = findIndex(*element.m_source);
+      if (owner == NO_INDEX)
+        addProblem(element.m_node, std::string(element.m_id), "Owner " + Quote(*element.m_source) + " doesn't exist.");
+      else if (isStrict && isBus[owner])
+        addProblem(element.m_node, std::string(element.m_id), "Owner " + Quote(*element.m_source) + " is a bus.");
+    }
+  }
+
+  // Every chain of parents is walked up to a root or an element that has been walked already, so each element is
+  // visited once. A chain that comes back to an element on the walked path is a cycle.
+  std::pmr::vector<bool> isVisited(elements.size(), false, resource);
+  std::pmr::vector<bool> isOnPath(elements.size(), false, resource);
+  std::pmr::vector<std::size_t> path(resource);
+  for (std::size_t i = 0; i < elements.size(); ++i)
+  {
+    path.clear();
+    std::size_t current = i;
+    for (; current != NO_INDEX && !isVisited[current]; current = parents[current])
+    {
+      isVisited[current] = true;
+      isOnPath[current] = true;
+      path.push_back(current);
+    }
+
+    if (current != NO_INDEX && isOnPath[current])
+    {
+      std::string cycle;
+      for (auto it = std::find(path.cbegin(), path.cend(), current); it != path.cend(); ++it)
+        cycle += Quote(elements[*it].m_id) + " -> ";
+      cycle += Quote(elements[current].m_id);
+      addProblem(
+          elements[current].m_node, std::string(elements[current].m_id), "Contour parents make a cycle " + cycle + ".");
+    }
+
+    for (std::size_t const index : path)
+      isOnPath[index] = false;
+  }
+
+  std::stable_sort(
+      problems.begin(),
+      problems.end(),
+      [](Problem const & first, Problem const & second)
+      {
+        return first.m_line < second.m_line;
+      });
+  return problems;
+}
+
+void GWFValidator::Check(xmlNodePtr staticSector, std::pmr::memory_resource * resource, bool isStrict)
+{
+  std::vector<Problem> const & problems = Validate(staticSector, resource, isStrict);
+  if (problems.empty())
+    return;
+
+  std::stringstream message;
+  message << "GWFValidator::Check: Document has " << problems.size() << " problems:";
+  for (Problem const & problem : problems)
+    message << "\n  " << problem.ToString();
+  SC_THROW_EXCEPTION(utils::ExceptionParseError, message.str());
+}
@@ -0,0 +1,51 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include <libxml/tree.h>
+
+/*!
+ * Structural check of the static sector of a gwf document, run before any SCg element is created from it.
+ *
+ * Elements get dense indices in document order and their properties are kept as bitsets over these indices, so every
+ * reference is resolved once and the check takes linear time whatever the shape of a diagram. All problems are
+ * collected instead of the first one, so a broken diagram is fixed in one round. Checked are missing attributes,
+ * unknown tags, duplicate ids, missing connector ends and bus owners, parents that aren't contours and cycles of
+ * contour parents.
+ *
+ * Strict check also rejects diagrams that the translator accepts, but that editors don't save: types that don't match
+ * their elements, content types other than the known ones and buses owned by buses.
+ */
+class GWFValidator
+{
+public:
+  struct Problem
+  {
+    // Line of the element in the gwf text
+    long m_line = 0;
+    std::string m_elementId;
+    std::string m_description;
+
+    std::string ToString() const;
+  };
+
+  // Working data of the check is allocated from the resource, problems are not
+  static std::vector<Problem> Validate(
+      xmlNodePtr staticSector,
+      std::pmr::memory_resource * resource = std::pmr::get_default_resource(),
+      bool isStrict = false);
+  // Throws utils::ExceptionParseError that lists all problems, if there are any
+  static void Check(
+      xmlNodePtr staticSector,
+      std::pmr::memory_resource * resource = std::pmr::get_default_resource(),
+      bool isStrict = false);
+};
@@ -0,0 +1,455 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "gwf_watcher.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <sc-memory/sc_debug.hpp>
+
+#include "gwf_translation_session.hpp"
+#include "gwf_translator_constants.hpp"
+#include "gwf_tracer.hpp"
+
+using namespace Constants;
+
+namespace
+{
+uint32_t const DIRECTORY_EVENTS =
+    IN_CREATE | IN_MOVED_TO | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_DELETE | IN_DELETE_SELF | IN_ONLYDIR;
+
+bool IsGWFFile(std::string const & filePath)
+{
+  return filePath.size() > GWF_EXTENTION.size()
+         && filePath.compare(filePath.size() - GWF_EXTENTION.size(), GWF_EXTENTION.size(), GWF_EXTENTION) == 0;
+}
+
+bool IsInDirectory(std::string const & path, std::string const & directoryPath)
+{
+  return path.size() > directoryPath.size() && path.compare(0, directoryPath.size(), directoryPath) == 0
+         && path[directoryPath.size()] == '/';
+}
+
+// Closes a descriptor and resets it when it leaves the scope, unless it has been released to its owner by then
+class DescriptorGuard
+{
+public:
+  explicit DescriptorGuard(int & descriptor)
+    : m_descriptor(&descriptor)
+  {
+  }
+
+  ~DescriptorGuard()
+  {
+    if (m_descriptor == nullptr || *m_descriptor < 0)
+      return;
+
+    close(*m_descriptor);
+    *m_descriptor = -1;
+  }
+
+  DescriptorGuard(DescriptorGuard const &) = delete;
+  DescriptorGuard & operator=(DescriptorGuard const &) = delete;
+
+  void Release()
+  {
+    m_descriptor = nullptr;
+  }
+
+private:
+  int * m_descriptor;
+};
+}  // namespace
+
+GWFWatcher::GWFWatcher(
+    std::string const & rootPath,
+    OnTranslated const & onTranslated,
+    OnError const & onError,
+    std::chrono::milliseconds const & debounce)
+  : m_rootPath(rootPath)
+  , m_onTranslated(onTranslated)
+  , m_onError(onError)
+  , m_debounce(debounce)
+  , m_inotifyDescriptor(-1)
+  , m_stopDescriptor(-1)
+  , m_isRunning(false)
+  , m_lastGeneration(0)
+  , m_isStopped(false)
+{
+}
+
+GWFWatcher::~GWFWatcher()
+{
+  Stop();
+}
+
+void GWFWatcher::Start()
+{
+  if (m_isRunning)
+    return;
+
+  m_inotifyDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (m_inotifyDescriptor < 0)
+    SC_THROW_EXCEPTION(
+        utils::ExceptionCritical, "GWFWatcher::Start: Unable to initialize inotify: " << std::strerror(errno) << ".");
+  DescriptorGuard inotifyGuard(m_inotifyDescriptor);
+
+  m_stopDescriptor = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (m_stopDescriptor < 0)
+    SC_THROW_EXCEPTION(
+        utils::ExceptionCritical, "GWFWatcher::Start: Unable to create stop event: " << std::strerror(errno) << ".");
+  DescriptorGuard stopGuard(m_stopDescriptor);
+
+  std::error_code error;
+  if (!std::filesystem::is_directory(m_rootPath, error))
+    SC_THROW_EXCEPTION(
+        utils::ExceptionInvalidParams, "GWFWatcher::Start: `" << m_rootPath << "` isn't a directory to watch.");
+
+  m_watchedDirectories.clear();
+  AddWatchesRecursively(m_rootPath, false);
+
+  m_isStopped = false;
+  m_eventsThread = std::thread(&GWFWatcher::ProcessEvents, this);
+  try
+  {
+    m_translationThread = std::thread(&GWFWatcher::ProcessTranslations, this);
+  }
+  catch (...)
+  {
+    uint64_t const signal = 1;
+    if (write(m_stopDescriptor, &signal, sizeof(signal)) < 0)
+      SC_LOG_WARNING("GWFWatcher::Start: Unable to signal stop event: " << std::strerror(errno) << ".");
+    m_eventsThread.join();
+    m_watchedDirectories.clear();
+    throw;
+  }
+
+  inotifyGuard.Release();
+  stopGuard.Release();
+  m_isRunning = true;
+}
+
+void GWFWatcher::Stop()
+{
+  if (!m_isRunning)
+    return;
+
+  uint64_t const signal = 1;
+  if (write(m_stopDescriptor, &signal, sizeof(signal)) < 0)
+    SC_LOG_WARNING("GWFWatcher::Stop: Unable to signal stop event: " << std::strerror(errno) << ".");
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_isStopped = true;
+  }
+  m_condition.notify_all();
+
+  m_eventsThread.join();
+  m_translationThread.join();
+
+  close(m_inotifyDescriptor);
+  close(m_stopDescriptor);
+  m_inotifyDescriptor = -1;
+  m_stopDescriptor = -1;
+  m_watchedDirectories.clear();
+  m_generations.clear();
+  m_pendingFiles.clear();
+  m_readyFiles.clear();
+  m_isRunning = false;
+}
+
+void GWFWatcher::AddWatches(std::string const & directoryPath)
+{
+  int const watchDescriptor = inotify_add_watch(m_inotifyDescriptor, directoryPath.c_str(), DIRECTORY_EVENTS);
+  if (watchDescriptor < 0)
+  {
+    SC_LOG_WARNING(
+        "GWFWatcher::AddWatches: Unable to watch directory `" << directoryPath << "`: " << std::strerror(errno)
+                                                              << ".");
+    return;
+  }
+
+  m_watchedDirectories[watchDescriptor] = directoryPath;
+}
+
+void GWFWatcher::AddWatchesRecursively(std::string const & directoryPath, bool scheduleFiles)
+{
+  // The directory is watched before it is walked, so files that appear during the walk are reported by events and
+  // files that are already there are found by the walk; a file found both ways is scheduled once
+  AddWatches(directoryPath);
+
+  std::error_code error;
+  std::filesystem::recursive_directory_iterator it(
+      directoryPath, std::filesystem::directory_options::skip_permission_denied, error);
+  for (; !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error))
+  {
+    std::error_code statusError;
+    std::filesystem::file_status const status = it->symlink_status(statusError);
+    std::string const & path = it->path().string();
+    if (std::filesystem::is_directory(status))
+      AddWatches(path);
+    else if (scheduleFiles && std::filesystem::is_regular_file(status) && IsGWFFile(path))
+      ScheduleFile(path);
+  }
+
+  if (error)
+    SC_LOG_WARNING(
+        "GWFWatcher::AddWatchesRecursively: Unable to walk directory `" << directoryPath << "`: " << error.message()
+                                                                        << ".");
+}
+
+void GWFWatcher::RemoveWatches(std::string const & directoryPath)
+{
+  // A moved directory keeps its watches, but their paths are stale. They are removed here, and the directory is
+  // watched again under its new path if it has been moved within the tree
+  for (auto it = m_watchedDirectories.begin(); it != m_watchedDirectories.end();)
+  {
+    if (it->second != directoryPath && !IsInDirectory(it->second, directoryPath))
+    {
+      ++it;
+      continue;
+    }
+
+    inotify_rm_watch(m_inotifyDescriptor, it->first);
+    it = m_watchedDirectories.erase(it);
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (auto it = m_generations.begin(); it != m_generations.end();)
+  {
+    if (IsInDirectory(it->first, directoryPath))
+    {
+      m_pendingFiles.erase(it->first);
+      m_readyFiles.erase(std::remove(m_readyFiles.begin(), m_readyFiles.end(), it->first), m_readyFiles.end());
+      it = m_generations.erase(it);
+    }
+    else
+      ++it;
+  }
+}
+
+void GWFWatcher::ProcessEvents()
+{
+  std::array<pollfd, 2> descriptors = {{{m_inotifyDescriptor, POLLIN, 0}, {m_stopDescriptor, POLLIN, 0}}};
+
+  while (true)
+  {
+    int const count = poll(descriptors.data(), descriptors.size(), GetPollTimeout());
+    if (count < 0)
+    {
+      if (errno == EINTR)
+        continue;
+
+      SC_LOG_ERROR("GWFWatcher::ProcessEvents: Unable to poll inotify events: " << std::strerror(errno) << ".");
+      break;
+    }
+
+    if (descriptors[1].revents & POLLIN)
+      break;
+
+    if (descriptors[0].revents & POLLIN)
+      ReadEvents();
+
+    ScheduleReadyFiles();
+  }
+}
+
+void GWFWatcher::ReadEvents()
+{
+  alignas(inotify_event) std::array<char, 16 * 1024> events;
+
+  while (true)
+  {
+    ssize_t const length = read(m_inotifyDescriptor, events.data(), events.size());
+    if (length <= 0)
+      break;
+
+    for (char const * pointer = events.data(); pointer < events.data() + length;)
+    {
+      auto const * event = reinterpret_cast<inotify_event const *>(pointer);
+      pointer += sizeof(inotify_event) + event->len;
+
+      if (event->mask & IN_IGNORED)
+      {
+        m_watchedDirectories.erase(event->wd);
+        continue;
+      }
+
+      auto const directoryIt = m_watchedDirectories.find(event->wd);
+      if (directoryIt == m_watchedDirectories.cend())
+        continue;
+
+      if (event->mask & IN_DELETE_SELF)
+      {
+        if (directoryIt->second == m_rootPath)
+          SC_LOG_WARNING("GWFWatcher::ReadEvents: Watched directory `" << m_rootPath << "` has been deleted.");
+        RemoveWatches(directoryIt->second);
+        continue;
+      }
+
+      if (event->len == 0)
+        continue;
+
+      std::string const path = directoryIt->second + "/" + event->name;
+      if (event->mask & IN_ISDIR)
+      {
+        if (event->mask & IN_MOVED_FROM)
+          RemoveWatches(path);
+        else if (event->mask & (IN_CREATE | IN_MOVED_TO))
+          AddWatchesRecursively(path, true);
+        continue;
+      }
+
+      if (!IsGWFFile(path))
+        continue;
+
+      // A file that is deleted or moved away is no longer translated, a translation in flight is cancelled
+      if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+      {
+        CancelFile(path);
+        continue;
+      }
+
+      // Editors either rewrite a file in place or replace it by renaming a temporary file, so only these two events
+      // mean that a complete file has been saved
+      if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+        ScheduleFile(path);
+    }
+  }
+}
+
+void GWFWatcher::ScheduleFile(std::string const & filePath)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_generations[filePath] = ++m_lastGeneration;
+  m_pendingFiles[filePath] = Clock::now() + m_debounce;
+}
+
+void GWFWatcher::CancelFile(std::string const & filePath)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_generations.erase(filePath);
+  m_pendingFiles.erase(filePath);
+  m_readyFiles.erase(std::remove(m_readyFiles.begin(), m_readyFiles.end(), filePath), m_readyFiles.end());
+}
+
+void GWFWatcher::ScheduleReadyFiles()
+{
+  bool hasReadyFiles = false;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto const now = Clock::now();
+    for (auto it = m_pendingFiles.begin(); it != m_pendingFiles.end();)
+    {
+      if (it->second > now)
+      {
+        ++it;
+        continue;
+      }
+
+      if (std::find(m_readyFiles.cbegin(), m_readyFiles.cend(), it->first) == m_readyFiles.cend())
+        m_readyFiles.push_back(it->first);
+      it = m_pendingFiles.erase(it);
+      hasReadyFiles = true;
+    }
+  }
+
+  if (hasReadyFiles)
+    m_condition.notify_one();
+}
+
+int GWFWatcher::GetPollTimeout()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_pendingFiles.empty())
+    return -1;
+
+  auto nearestDeadline = Clock::time_point::max();
+  for (auto const & [filePath, deadline] : m_pendingFiles)
+    nearestDeadline = std::min(nearestDeadline, deadline);
+
+  auto const timeout = std::chrono::ceil<std::chrono::milliseconds>(nearestDeadline - Clock::now()).count();
+  return static_cast<int>(std::max<decltype(timeout)>(timeout, 0));
+}
+
+void GWFWatcher::ProcessTranslations()
+{
+  GWFTracer::SetThreadName("gwf watcher translation");
+  // Saved files are usually translated again and again, so scratch state of translations is kept between them
+  GWFTranslationSession session;
+
+  while (true)
+  {
+    std::string filePath;
+    uint64_t generation;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_condition.wait(
+          lock,
+          [&]()
+          {
+            return m_isStopped || !m_readyFiles.empty();
+          });
+      if (m_isStopped)
+        return;
+
+      filePath = m_readyFiles.front();
+      m_readyFiles.pop_front();
+      // A save that is still pending is translated now, its content is already in the file
+      m_pendingFiles.erase(filePath);
+      auto const generationIt = m_generations.find(filePath);
+      if (generationIt == m_generations.cend())
+        continue;
+      generation = generationIt->second;
+    }
+
+    // A translation is cancelled when the file has been saved again while it was translated: it isn't written if the
+    // newer save arrives before parsing ends, otherwise its result is dropped. The newer save is already pending and
+    // will be translated after its own debounce window.
+    try
+    {
+      auto const & isCancelled = [this, &filePath, generation]()
+      {
+        return !IsCurrentGeneration(filePath, generation);
+      };
+      std::string const scsText = session.Translate(filePath, nullptr, isCancelled).GetValue();
+      if (IsCurrentGeneration(filePath, generation))
+        m_onTranslated(filePath, scsText);
+    }
+    catch (std::exception const & exception)
+    {
+      if (IsCurrentGeneration(filePath, generation))
+        m_onError(filePath, exception.what());
+    }
+
+    ForgetGeneration(filePath, generation);
+  }
+}
+
+bool GWFWatcher::IsCurrentGeneration(std::string const & filePath, uint64_t generation)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto const it = m_generations.find(filePath);
+  return it != m_generations.cend() && it->second == generation;
+}
+
+void GWFWatcher::ForgetGeneration(std::string const & filePath, uint64_t generation)
+{
+  // A file that has been saved again keeps its newer generation until that save is translated
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto const it = m_generations.find(filePath);
+  if (it != m_generations.cend() && it->second == generation)
+    m_generations.erase(it);
+}
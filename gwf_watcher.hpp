@@ -0,0 +1,91 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+/*!
+ * Watches a knowledge base tree with inotify and re-translates gwf-files after they are saved.
+ *
+ * Bursts of events for the same file are coalesced: a file is translated only when no new event for it has arrived
+ * during the debounce window. Every save gives the file a new generation, so a translation that is in flight when a
+ * newer save arrives is cancelled: it stops before writing SCs text if it's still parsing, otherwise its result is
+ * dropped, and the file is translated again from the newest content. Parsing itself isn't interrupted, so a stale
+ * parse still occupies the translation thread until it ends. Deleting a file or moving it out of the tree cancels it
+ * the same way.
+ *
+ * Directories that are created in the tree or moved into it are watched with all their subdirectories, and gwf-files
+ * they already contain are translated.
+ */
+class GWFWatcher
+{
+public:
+  using OnTranslated = std::function<void(std::string const & filePath, std::string const & scsText)>;
+  using OnError = std::function<void(std::string const & filePath, std::string const & errorMessage)>;
+
+  GWFWatcher(
+      std::string const & rootPath,
+      OnTranslated const & onTranslated,
+      OnError const & onError,
+      std::chrono::milliseconds const & debounce = std::chrono::milliseconds(30));
+  ~GWFWatcher();
+
+  GWFWatcher(GWFWatcher const &) = delete;
+  GWFWatcher & operator=(GWFWatcher const &) = delete;
+
+  void Start();
+  void Stop();
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  std::string m_rootPath;
+  OnTranslated m_onTranslated;
+  OnError m_onError;
+  std::chrono::milliseconds m_debounce;
+
+  int m_inotifyDescriptor;
+  int m_stopDescriptor;
+  std::unordered_map<int, std::string> m_watchedDirectories;
+
+  std::thread m_eventsThread;
+  std::thread m_translationThread;
+  bool m_isRunning;
+
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  // Generations of files that are pending, ready or being translated; generations are never reused, so a file that is
+  // deleted and created again can't be mistaken for its cancelled translation
+  std::unordered_map<std::string, std::uint64_t> m_generations;
+  std::uint64_t m_lastGeneration;
+  std::unordered_map<std::string, Clock::time_point> m_pendingFiles;
+  std::deque<std::string> m_readyFiles;
+  bool m_isStopped;
+
+  void AddWatches(std::string const & directoryPath);
+  void AddWatchesRecursively(std::string const & directoryPath, bool scheduleFiles);
+  void RemoveWatches(std::string const & directoryPath);
+  void ProcessEvents();
+  void ProcessTranslations();
+
+  void ReadEvents();
+  void ScheduleReadyFiles();
+  int GetPollTimeout();
+
+  void ScheduleFile(std::string const & filePath);
+  void CancelFile(std::string const & filePath);
+  bool IsCurrentGeneration(std::string const & filePath, std::uint64_t generation);
+  void ForgetGeneration(std::string const & filePath, std::uint64_t generation);
+};
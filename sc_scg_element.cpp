@@ -6,112 +6,251 @@
 
 #include "sc_scg_element.hpp"
 
+#include <algorithm>
+#include <array>
+
+#include "gwf_base64_decoder.hpp"
+#include "gwf_hot_path_counters.hpp"
+
+namespace
+{
+// Encoded text is decoded in chunks of this size into a buffer on the stack, a multiple of 4 fills it exactly
+constexpr std::size_t DEFERRED_CONTENT_CHUNK_SIZE = 16 * 1024;
+}  // namespace
+
 // SCgElement
 SCgElement::SCgElement(
-    std::string const & id,
-    std::string const & parent,
-    std::string const & identifier,
-    std::string const & type,
-    std::string const & tag)
-  : m_id(id)
-  , m_parent(parent)
-  , m_identifier(identifier)
-  , m_type(type)
-  , m_tag(tag)
+    std::string_view id,
+    std::string_view parent,
+    std::string_view identifier,
+    std::string_view type,
+    std::string_view tag,
+    std::pmr::memory_resource * resource)
+  : m_id(id, resource)
+  , m_parent(parent, resource)
+  , m_identifier(identifier, resource)
+  , m_type(type, resource)
+  , m_tag(tag, resource)
 {
+#if defined(GWF_TRANSLATOR_COUNT_HOT_PATHS)
+  // Copies that don't fit into the small string buffer are allocated from the resource
+  for (std::pmr::string const * string : {&m_id, &m_parent, &m_identifier, &m_type, &m_tag})
+    GWF_COUNT_HOT_PATH_N(ElementStringAllocations, string->size() > std::string().capacity());
+#endif
 }
 
-std::string const & SCgElement::GetId() const
+std::string_view SCgElement::GetId() const
 {
   return m_id;
 }
 
-std::string const & SCgElement::GetIdentifier() const
+std::string_view SCgElement::GetParent() const
+{
+  return m_parent;
+}
+
+std::string_view SCgElement::GetIdentifier() const
 {
   return m_identifier;
 }
 
-std::string const & SCgElement::GetType() const
+std::string_view SCgElement::GetType() const
 {
   return m_type;
 }
 
-std::string const & SCgElement::GetTag() const
+std::string_view SCgElement::GetTag() const
 {
   return m_tag;
 }
 
 // SCgNode
 SCgNode::SCgNode(
-    std::string const & id,
-    std::string const & parent,
-    std::string const & identifier,
-    std::string const & type,
-    std::string const & tag)
-  : SCgElement(id, parent, identifier, type, tag)
+    std::string_view id,
+    std::string_view parent,
+    std::string_view identifier,
+    std::string_view type,
+    std::string_view tag,
+    std::pmr::memory_resource * resource)
+  : SCgElement(id, parent, identifier, type, tag, resource)
 {
 }
 
 // SCgLink
 SCgLink::SCgLink(
-    std::string const & id,
-    std::string const & parent,
-    std::string const & identifier,
-    std::string const & type,
-    std::string const & tag,
-    std::string const & contentType,
-    std::string const & mimeType,
-    std::string const & fileName,
-    std::string const & contentData)
-  : SCgNode(id, parent, identifier, type, tag)
-  , m_contentType(contentType)
-  , m_mimeType(mimeType)
-  , m_fileName(fileName)
-  , m_contentData(contentData)
+    std::string_view id,
+    std::string_view parent,
+    std::string_view identifier,
+    std::string_view type,
+    std::string_view tag,
+    std::string_view contentType,
+    std::string_view mimeType,
+    std::string_view fileName,
+    std::pmr::string contentData,
+    std::pmr::memory_resource * resource)
+  : SCgNode(id, parent, identifier, type, tag, resource)
+  , m_contentType(contentType, resource)
+  , m_mimeType(mimeType, resource)
+  , m_fileName(fileName, resource)
+  , m_contentData(std::move(contentData))
+  , m_spillFile(nullptr)
+  , m_storedContentPath(resource)
+  , m_storedContentSize(0)
+  , m_contentEncoding(ContentEncoding::Raw)
 {
 }
 
-std::string const & SCgLink::GetContentType() const
+std::string_view SCgLink::GetContentType() const
 {
   return m_contentType;
 }
 
-std::string const & SCgLink::GetFileName() const
+std::string_view SCgLink::GetFileName() const
 {
   return m_fileName;
 }
 
-std::string const & SCgLink::GetContentData() const
+std::pmr::string const & SCgLink::GetContentData() const
 {
+  if (IsContentDeferred())
+  {
+    if (m_contentEncoding == ContentEncoding::Base64)
+    {
+      // Decoded in place, so the bytes stay in the string's own resource
+      m_contentData.resize(GWFBase64Decoder::GetMaxDecodedSize(m_deferredContent.size()));
+      GWFBase64Decoder decoder;
+      std::size_t size = decoder.DecodeChunk(m_deferredContent.data(), m_deferredContent.size(), m_contentData.data());
+      size += decoder.Finish(m_contentData.data() + size);
+      m_contentData.resize(size);
+    }
+    else
+      m_contentData = m_deferredContent;
+    m_deferredContent = {};
+    std::string().swap(m_encodedContent);
+  }
+
   return m_contentData;
 }
 
+void SCgLink::SetSpilledContent(GWFSpillFile const * spillFile, GWFSpillFile::Range const & range)
+{
+  m_contentData.clear();
+  m_contentData.shrink_to_fit();
+  m_spillFile = spillFile;
+  m_spilledContent = range;
+}
+
+bool SCgLink::IsContentSpilled() const
+{
+  return m_spillFile != nullptr;
+}
+
+std::size_t SCgLink::GetContentSize() const
+{
+  if (!m_storedContentPath.empty())
+    return m_storedContentSize;
+  if (IsContentDeferred())
+    return m_contentEncoding == ContentEncoding::Base64 ? GWFBase64Decoder::GetDecodedSize(m_deferredContent)
+                                                        : m_deferredContent.size();
+
+  return IsContentSpilled() ? m_spilledContent.m_size : m_contentData.size();
+}
+
+void SCgLink::SetStoredContent(std::string_view path, std::size_t size)
+{
+  m_contentData.clear();
+  m_contentData.shrink_to_fit();
+  m_storedContentPath = path;
+  m_storedContentSize = size;
+}
+
+std::string_view SCgLink::GetStoredContentPath() const
+{
+  return m_storedContentPath;
+}
+
+void SCgLink::SetDeferredContent(std::string_view encodedContent, ContentEncoding encoding)
+{
+  m_contentData.clear();
+  m_contentData.shrink_to_fit();
+  m_deferredContent = encodedContent;
+  m_contentEncoding = encoding;
+}
+
+void SCgLink::SetDeferredContent(std::string && encodedContent, ContentEncoding encoding)
+{
+  m_encodedContent = std::move(encodedContent);
+  SetDeferredContent(std::string_view(m_encodedContent), encoding);
+}
+
+bool SCgLink::IsContentDeferred() const
+{
+  return !m_deferredContent.empty();
+}
+
+void SCgLink::ReadDeferredContent(GWFSpillFile::Consumer const & consumer) const
+{
+  if (!IsContentDeferred())
+    return;
+
+  if (m_contentEncoding == ContentEncoding::Raw)
+  {
+    consumer(m_deferredContent.data(), m_deferredContent.size());
+    return;
+  }
+
+  std::array<char, DEFERRED_CONTENT_CHUNK_SIZE / 4 * 3> bytes;
+  GWFBase64Decoder decoder;
+  for (std::size_t offset = 0; offset < m_deferredContent.size(); offset += DEFERRED_CONTENT_CHUNK_SIZE)
+  {
+    std::size_t const size = decoder.DecodeChunk(
+        m_deferredContent.data() + offset,
+        std::min(DEFERRED_CONTENT_CHUNK_SIZE, m_deferredContent.size() - offset),
+        bytes.data());
+    if (size != 0)
+      consumer(bytes.data(), size);
+  }
+
+  std::size_t const size = decoder.Finish(bytes.data());
+  if (size != 0)
+    consumer(bytes.data(), size);
+}
+
+void SCgLink::ReadSpilledContent(GWFSpillFile::Consumer const & consumer) const
+{
+  if (IsContentSpilled())
+    m_spillFile->Read(m_spilledContent, consumer);
+}
+
 // SCgBus
 SCgBus::SCgBus(
-    std::string const & id,
-    std::string const & parent,
-    std::string const & identifier,
-    std::string const & type,
-    std::string const & tag,
-    std::string const & nodeId)
-  : SCgNode(id, parent, identifier, type, tag)
-  , m_nodeId(nodeId)
+    std::string_view id,
+    std::string_view parent,
+    std::string_view identifier,
+    std::string_view type,
+    std::string_view tag,
+    std::string_view nodeId,
+    std::pmr::memory_resource * resource)
+  : SCgNode(id, parent, identifier, type, tag, resource)
+  , m_nodeId(nodeId, resource)
 {
 }
 
-std::string const & SCgBus::GetNodeId() const
+std::string_view SCgBus::GetNodeId() const
 {
   return m_nodeId;
 }
 
 // SCgContour
 SCgContour::SCgContour(
-    std::string const & id,
-    std::string const & parent,
-    std::string const & identifier,
-    std::string const & type,
-    std::string const & tag)
-  : SCgNode(id, parent, identifier, type, tag)
+    std::string_view id,
+    std::string_view parent,
+    std::string_view identifier,
+    std::string_view type,
+    std::string_view tag,
+    std::pmr::memory_resource * resource)
+  : SCgNode(id, parent, identifier, type, tag, resource)
+  , m_elements(resource)
 {
 }
 
@@ -127,14 +266,15 @@ SCgElements & SCgContour::GetElements()
 
 // SCgConnector
 SCgConnector::SCgConnector(
-    std::string const & id,
-    std::string const & parent,
-    std::string const & identifier,
-    std::string const & type,
-    std::string const & tag,
+    std::string_view id,
+    std::string_view parent,
+    std::string_view identifier,
+    std::string_view type,
+    std::string_view tag,
     SCgElementPtr source,
-    SCgElementPtr target)
-  : SCgElement(id, parent, identifier, type, tag)
+    SCgElementPtr target,
+    std::pmr::memory_resource * resource)
+  : SCgElement(id, parent, identifier, type, tag, resource)
   , m_source(source)
   , m_target(target)
 {
@@ -7,96 +7,142 @@
 #pragma once
 
 #include <list>
+#include <memory_resource>
+#include <string>
+#include <string_view>
 
+#include "gwf_spill_file.hpp"
 #include "gwf_translator_constants.hpp"
 
 class SCgElement
 {
 public:
   SCgElement(
-      std::string const & id,
-      std::string const & parent,
-      std::string const & identifier,
-      std::string const & type,
-      std::string const & tag);
+      std::string_view id,
+      std::string_view parent,
+      std::string_view identifier,
+      std::string_view type,
+      std::string_view tag,
+      std::pmr::memory_resource * resource = std::pmr::get_default_resource());
 
   virtual ~SCgElement() = default;
 
-  std::string const & GetId() const;
-  std::string const & GetIdentifier() const;
-  std::string const & GetType() const;
-  std::string const & GetTag() const;
+  std::string_view GetId() const;
+  std::string_view GetParent() const;
+  std::string_view GetIdentifier() const;
+  std::string_view GetType() const;
+  std::string_view GetTag() const;
 
 private:
-  std::string m_id;
-  std::string m_parent;
-  std::string m_identifier;
-  std::string m_type;
-  std::string m_tag;
+  // Strings are allocated from the resource of the translation, like the element itself
+  std::pmr::string m_id;
+  std::pmr::string m_parent;
+  std::pmr::string m_identifier;
+  std::pmr::string m_type;
+  std::pmr::string m_tag;
 };
 
 class SCgNode : public SCgElement
 {
 public:
   SCgNode(
-      std::string const & id,
-      std::string const & parent,
-      std::string const & identifier,
-      std::string const & type,
-      std::string const & tag);
+      std::string_view id,
+      std::string_view parent,
+      std::string_view identifier,
+      std::string_view type,
+      std::string_view tag,
+      std::pmr::memory_resource * resource = std::pmr::get_default_resource());
 };
 
 class SCgLink : public SCgNode
 {
 public:
+  enum class ContentEncoding
+  {
+    Raw,
+    Base64
+  };
+
   SCgLink(
-      std::string const & id,
-      std::string const & parent,
-      std::string const & identifier,
-      std::string const & type,
-      std::string const & tag,
-      std::string const & contentType,
-      std::string const & mimeType,
-      std::string const & fileName,
-      std::string const & contentData);
-
-  std::string const & GetContentType() const;
-  std::string const & GetFileName() const;
-  std::string const & GetContentData() const;
+      std::string_view id,
+      std::string_view parent,
+      std::string_view identifier,
+      std::string_view type,
+      std::string_view tag,
+      std::string_view contentType,
+      std::string_view mimeType,
+      std::string_view fileName,
+      std::pmr::string contentData,
+      std::pmr::memory_resource * resource = std::pmr::get_default_resource());
+
+  std::string_view GetContentType() const;
+  std::string_view GetFileName() const;
+  // Decodes deferred content on the first call
+  std::pmr::string const & GetContentData() const;
+
+  // Content that didn't fit into the memory budget of a translation. Content data of such link is empty.
+  void SetSpilledContent(GWFSpillFile const * spillFile, GWFSpillFile::Range const & range);
+  bool IsContentSpilled() const;
+  std::size_t GetContentSize() const;
+  void ReadSpilledContent(GWFSpillFile::Consumer const & consumer) const;
+
+  // Content stored in a blob store, see GWFBlobStore. Content data of such link is empty.
+  void SetStoredContent(std::string_view path, std::size_t size);
+  std::string_view GetStoredContentPath() const;
+
+  // Content left encoded in the gwf text, see GWFContentStorage. The text must outlive the link. Content data of such
+  // link is decoded when it's read.
+  void SetDeferredContent(std::string_view encodedContent, ContentEncoding encoding);
+  // Content encoded in a copy of its range of the gwf text, which the link keeps, so the text itself can be released
+  void SetDeferredContent(std::string && encodedContent, ContentEncoding encoding);
+  bool IsContentDeferred() const;
+  // Decodes deferred content chunk by chunk, without materializing content data
+  void ReadDeferredContent(GWFSpillFile::Consumer const & consumer) const;
 
 private:
-  std::string m_contentType;
-  std::string m_mimeType;
-  std::string m_fileName;
-  std::string m_contentData;
+  std::pmr::string m_contentType;
+  std::pmr::string m_mimeType;
+  std::pmr::string m_fileName;
+  // Keeps the resource it's passed with: decoded images are moved in from the heap, where they are decoded
+  mutable std::pmr::string m_contentData;
+  GWFSpillFile const * m_spillFile;
+  GWFSpillFile::Range m_spilledContent;
+  std::pmr::string m_storedContentPath;
+  std::size_t m_storedContentSize;
+  mutable std::string_view m_deferredContent;
+  mutable std::string m_encodedContent;
+  ContentEncoding m_contentEncoding;
 };
 
 class SCgBus : public SCgNode
 {
 public:
   SCgBus(
-      std::string const & id,
-      std::string const & parent,
-      std::string const & identifier,
-      std::string const & type,
-      std::string const & tag,
-      std::string const & nodeId);
+      std::string_view id,
+      std::string_view parent,
+      std::string_view identifier,
+      std::string_view type,
+      std::string_view tag,
+      std::string_view nodeId,
+      std::pmr::memory_resource * resource = std::pmr::get_default_resource());
 
-  std::string const & GetNodeId() const;
+  std::string_view GetNodeId() const;
 
 private:
-  std::string m_nodeId;
+  std::pmr::string m_nodeId;
 };
 
 class SCgContour : public SCgNode
 {
 public:
+  // Elements of the contour are allocated from the resource
   SCgContour(
-      std::string const & id,
-      std::string const & parent,
-      std::string const & identifier,
-      std::string const & type,
-      std::string const & tag);
+      std::string_view id,
+      std::string_view parent,
+      std::string_view identifier,
+      std::string_view type,
+      std::string_view tag,
+      std::pmr::memory_resource * resource = std::pmr::get_default_resource());
 
   void SetElements(SCgElements const & elements);
   SCgElements & GetElements();
@@ -109,13 +155,14 @@ class SCgConnector : public SCgElement
 {
 public:
   SCgConnector(
-      std::string const & id,
-      std::string const & parent,
-      std::string const & identifier,
-      std::string const & type,
-      std::string const & tag,
+      std::string_view id,
+      std::string_view parent,
+      std::string_view identifier,
+      std::string_view type,
+      std::string_view tag,
       SCgElementPtr sourceEl,
-      SCgElementPtr targetEl);
+      SCgElementPtr targetEl,
+      std::pmr::memory_resource * resource = std::pmr::get_default_resource());
 
   SCgElementPtr GetSource() const;
   SCgElementPtr GetTarget() const;
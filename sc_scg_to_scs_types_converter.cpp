@@ -6,7 +6,11 @@
 
 #include "sc_scg_to_scs_types_converter.hpp"
 
-std::unordered_map<std::string, std::string> const SCgToSCsTypesConverter::m_nodeTypeSets = {
+#include <algorithm>
+
+#include "gwf_hot_path_counters.hpp"
+
+SCgToSCsTypesConverter::Dictionary const SCgToSCsTypesConverter::m_nodeTypeSets = {
     {"node/-/-/not_define", "sc_node"},
     {"node/-/not_define", "sc_node"},
 
@@ -31,7 +35,7 @@ std::unordered_map<std::string, std::string> const SCgToSCsTypesConverter::m_nod
     {"node/var/superclass", "sc_node_superclass"},
 };
 
-std::unordered_map<std::string, std::string> const SCgToSCsTypesConverter::m_backwardNodeTypes = {
+SCgToSCsTypesConverter::Dictionary const SCgToSCsTypesConverter::m_backwardNodeTypes = {
     {"node/-/not_define", "node/-/-/not_define"},
     {"node/var/symmetry", "node/var/tuple"},
     {"node/const/general_node", "node/const/general"},
@@ -49,7 +53,7 @@ std::unordered_map<std::string, std::string> const SCgToSCsTypesConverter::m_bac
     {"node/var/super_group", "node/var/superclass"},
 };
 
-std::unordered_map<std::string, std::string> const SCgToSCsTypesConverter::m_unsupportedNodeTypeSets = {
+SCgToSCsTypesConverter::Dictionary const SCgToSCsTypesConverter::m_unsupportedNodeTypeSets = {
     {"node/const/perm/general", "sc_node"},
     {"node/const/perm/general_node", "sc_node"},
     {"node/const/perm/terminal", "sc_node"},
@@ -128,7 +132,7 @@ std::unordered_map<std::string, std::string> const SCgToSCsTypesConverter::m_uns
     {"node/meta/temp/super_group", "sc_node_super_group"},
 };
 
-std::unordered_map<std::string, std::string> const SCgToSCsTypesConverter::m_connectorTypes = {
+SCgToSCsTypesConverter::Dictionary const SCgToSCsTypesConverter::m_connectorTypes = {
     {"pair/const/-/perm/noorien", "<=>"},
     {"pair/const/-/perm/orient", "=>"},
     {"pair/const/fuz/perm/orient/membership", "/>"},
@@ -184,7 +188,7 @@ std::unordered_map<std::string, std::string> const SCgToSCsTypesConverter::m_con
     {"pair/var/orient", "_=>"},
     {"pair/var/noorient", "_<=>"}};
 
-std::unordered_map<std::string, std::string> const SCgToSCsTypesConverter::m_backwardConnectorTypes = {
+SCgToSCsTypesConverter::Dictionary const SCgToSCsTypesConverter::m_backwardConnectorTypes = {
     {"pair/const/synonym", "pair/const/-/perm/noorien"},
     {"pair/const/orient", "pair/const/-/perm/orient"},
     {"arc/const/fuz", "pair/const/fuz/perm/orient/membership"},
@@ -205,7 +209,7 @@ std::unordered_map<std::string, std::string> const SCgToSCsTypesConverter::m_bac
     {"pair/orient", "pair/-/-/-/orient"},
     {"arc/-/-", "pair/-/-/-/orient"}};
 
-std::unordered_map<std::string, std::string> const SCgToSCsTypesConverter::m_unsupportedConnectorTypes = {
+SCgToSCsTypesConverter::Dictionary const SCgToSCsTypesConverter::m_unsupportedConnectorTypes = {
     {"pair/var/-/temp/noorien", "sc_pair_var_temp_noorient"},
     {"pair/var/-/temp/orient", "sc_pair_var_temp_orient"},
 
@@ -221,39 +225,88 @@ std::unordered_map<std::string, std::string> const SCgToSCsTypesConverter::m_uns
     {"pair/meta/pos/perm/orient/membership", "sc_pair_meta_pos_perm_orient_membership"},
     {"pair/meta/pos/temp/orient/membership", "sc_pair_meta_pos_temp_orient_membership"}};
 
-std::string SCgToSCsTypesConverter::GetSCsElementDesignation(
-    std::unordered_map<std::string, std::string> const & dictionary,
-    std::string const & key)
+// Returns a pointer into the dictionary, or nullptr if the type isn't there
+std::string_view const * SCgToSCsTypesConverter::FindSCsElementDesignation(
+    Dictionary const & dictionary,
+    std::string_view key)
 {
+  GWF_COUNT_HOT_PATH(TypeTableProbes);
   auto it = dictionary.find(key);
-  return it != dictionary.cend() ? it->second : "";
+  if (it == dictionary.cend())
+  {
+    GWF_COUNT_HOT_PATH(TypeTableMisses);
+    return nullptr;
+  }
+  return &it->second;
 }
 
-void SCgToSCsTypesConverter::ConvertSCgNodeTypeToSCsNodeType(std::string const & nodeType, std::string & symbol)
+void SCgToSCsTypesConverter::ConvertSCgNodeTypeToSCsNodeType(std::string_view nodeType, std::string_view & symbol)
 {
-  symbol = GetSCsElementDesignation(m_nodeTypeSets, nodeType);
+  std::string_view const * designation = FindSCsElementDesignation(m_nodeTypeSets, nodeType);
 
-  if (symbol.empty())
-    symbol = GetSCsElementDesignation(m_nodeTypeSets, GetSCsElementDesignation(m_backwardNodeTypes, nodeType));
+  if (designation == nullptr)
+  {
+    if (std::string_view const * backwardType = FindSCsElementDesignation(m_backwardNodeTypes, nodeType))
+      designation = FindSCsElementDesignation(m_nodeTypeSets, *backwardType);
+  }
 
-  if (symbol.empty())
-    symbol = GetSCsElementDesignation(m_unsupportedNodeTypeSets, nodeType);
+  if (designation == nullptr)
+    designation = FindSCsElementDesignation(m_unsupportedNodeTypeSets, nodeType);
+
+  if (designation != nullptr)
+    symbol = *designation;
+  else
+    symbol = {};
 }
 
 bool SCgToSCsTypesConverter::ConvertSCgConnectorTypeToSCsConnectorDesignation(
-    std::string const & edgeType,
-    std::string & symbol)
+    std::string_view edgeType,
+    std::string_view & symbol)
 {
-  symbol = GetSCsElementDesignation(m_connectorTypes, edgeType);
+  std::string_view const * designation = FindSCsElementDesignation(m_connectorTypes, edgeType);
 
-  if (symbol.empty())
-    symbol = GetSCsElementDesignation(m_connectorTypes, GetSCsElementDesignation(m_backwardConnectorTypes, edgeType));
+  if (designation == nullptr)
+  {
+    if (std::string_view const * backwardType = FindSCsElementDesignation(m_backwardConnectorTypes, edgeType))
+      designation = FindSCsElementDesignation(m_connectorTypes, *backwardType);
+  }
 
-  if (symbol.empty())
+  if (designation == nullptr)
   {
-    symbol = GetSCsElementDesignation(m_unsupportedConnectorTypes, edgeType);
+    designation = FindSCsElementDesignation(m_unsupportedConnectorTypes, edgeType);
+    if (designation != nullptr)
+      symbol = *designation;
+    else
+      symbol = {};
     return true;
   }
 
+  symbol = *designation;
   return false;
 }
+
+std::vector<std::string> SCgToSCsTypesConverter::GetKnownSCgNodeTypes()
+{
+  return GetSortedKeys({&m_nodeTypeSets, &m_backwardNodeTypes, &m_unsupportedNodeTypeSets});
+}
+
+std::vector<std::string> SCgToSCsTypesConverter::GetKnownSCgConnectorTypes()
+{
+  return GetSortedKeys({&m_connectorTypes, &m_backwardConnectorTypes, &m_unsupportedConnectorTypes});
+}
+
+std::vector<std::string> SCgToSCsTypesConverter::GetSortedKeys(
+    std::initializer_list<Dictionary const *> const & dictionaries)
+{
+  std::vector<std::string> keys;
+  for (auto const * dictionary : dictionaries)
+  {
+    for (auto const & [key, value] : *dictionary)
+      keys.emplace_back(key);
+  }
+
+  // Dictionaries iteration order depends on the standard library, the sorted order doesn't
+  std::sort(keys.begin(), keys.end());
+  keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+  return keys;
+}
@@ -8,22 +8,31 @@
 
 #include <unordered_map>
 #include <string>
+#include <string_view>
+#include <vector>
 
 class SCgToSCsTypesConverter
 {
 public:
-  static void ConvertSCgNodeTypeToSCsNodeType(std::string const & nodeType, std::string & symbol);
-  static bool ConvertSCgConnectorTypeToSCsConnectorDesignation(std::string const & edgeType, std::string & symbol);
+  // Symbols are views of the dictionaries, so they stay valid for the whole run
+  static void ConvertSCgNodeTypeToSCsNodeType(std::string_view nodeType, std::string_view & symbol);
+  static bool ConvertSCgConnectorTypeToSCsConnectorDesignation(std::string_view edgeType, std::string_view & symbol);
+
+  static std::vector<std::string> GetKnownSCgNodeTypes();
+  static std::vector<std::string> GetKnownSCgConnectorTypes();
 
 private:
-  static std::string GetSCsElementDesignation(
-      std::unordered_map<std::string, std::string> const & dictionary,
-      std::string const & key);
-
-  static std::unordered_map<std::string, std::string> const m_nodeTypeSets;
-  static std::unordered_map<std::string, std::string> const m_backwardNodeTypes;
-  static std::unordered_map<std::string, std::string> const m_unsupportedNodeTypeSets;
-  static std::unordered_map<std::string, std::string> const m_connectorTypes;
-  static std::unordered_map<std::string, std::string> const m_backwardConnectorTypes;
-  static std::unordered_map<std::string, std::string> const m_unsupportedConnectorTypes;
+  using Dictionary = std::unordered_map<std::string_view, std::string_view>;
+
+  static std::string_view const * FindSCsElementDesignation(Dictionary const & dictionary, std::string_view key);
+
+  static std::vector<std::string> GetSortedKeys(
+      std::initializer_list<Dictionary const *> const & dictionaries);
+
+  static Dictionary const m_nodeTypeSets;
+  static Dictionary const m_backwardNodeTypes;
+  static Dictionary const m_unsupportedNodeTypeSets;
+  static Dictionary const m_connectorTypes;
+  static Dictionary const m_backwardConnectorTypes;
+  static Dictionary const m_unsupportedConnectorTypes;
 };
@@ -6,99 +6,305 @@
 
  #include "sc_scs_writer.hpp"
 
- #include <regex>
+ #include <algorithm>
  #include <string>
+ #include <unordered_map>
  
+ #include <sc-memory/sc_debug.hpp>
  #include <sc-memory/sc_utils.hpp>
  
  #include "sc_scg_element.hpp"
- #include "sc_scs_element.hpp"
  #include "sc_scg_to_scs_types_converter.hpp"
+ #include "gwf_hot_path_counters.hpp"
+ #include "gwf_tracer.hpp"
  
  using namespace Constants;
  
+ namespace
+ {
+ // Whether an element is named after its identifier, as it is or prefixed as a variable, and not after its id
+ bool IsNamedAfterIdentifier(std::string_view name, std::string_view identifier)
+ {
+   if (identifier.empty())
+     return false;
+   if (name.size() == identifier.size() + 1 && name.front() == UNDERSCORE[0])
+     name.remove_prefix(1);
+   return name == identifier;
+ }
+ 
+ bool IsEnglishCharacter(unsigned char character)
+ {
+   return (character >= '0' && character <= '9') || (character >= 'a' && character <= 'z')
+          || (character >= 'A' && character <= 'Z') || character == '_';
+ }
+ 
+ // Bytes of Cyrillic letters in UTF-8 are 0xD0, 0xD1 and continuation bytes, the range of bytes is the one the
+ // pattern `[\xD0\x80-\xD1\x8F...]` matches byte by byte
+ bool IsRussianCharacter(unsigned char character)
+ {
+   return IsEnglishCharacter(character) || (character >= 0x80 && character <= 0xD1) || character == '*'
+          || character == '\'' || character == ' ';
+ }
+ 
+ // Quotes and backslashes of a string are escaped by backslashes, so that it can be written between quotes
+ void AppendEscaped(Buffer & buffer, std::string_view string)
+ {
+   size_t begin = 0;
+   for (size_t i = 0; i < string.size(); ++i)
+   {
+     if (string[i] == DOUBLE_QUOTE[0] || string[i] == '\\')
+     {
+       buffer << string.substr(begin, i - begin) << "\\";
+       begin = i;
+     }
+   }
+   buffer << string.substr(begin);
+ }
+ 
+ // Format of a content is told by the extension of its file name, e.g. `png` of `image.PNG`. Extensions that aren't
+ // valid SCs names tell no format.
+ std::string_view GetFormat(std::string_view fileName)
+ {
+   size_t const dotPosition = fileName.find_last_of(".");
+   if (dotPosition == std::string_view::npos || dotPosition + 1 == fileName.size())
+     return {};
+ 
+   std::string_view const extension = fileName.substr(dotPosition + 1);
+   return std::all_of(extension.cbegin(), extension.cend(), IsEnglishCharacter) ? extension : std::string_view();
+ }
+ }  // namespace
+ 
+ SCsWriter::IdentifierIndex::IdentifierIndex(
+     SCgElements const & elementsWithoutParents,
+     std::pmr::memory_resource * resource)
+   : m_names(resource)
+   , m_mainIdentifiers(resource)
+ {
+   // Names are kept in the resource, like the elements they're made of
+   std::pmr::vector<SCgElement const *> namedElements(resource);
+   std::pmr::string mainIdentifier(resource);
+   Collect(elementsWithoutParents, namedElements, mainIdentifier);
+ 
+   // Elements named after an identifier, prefixed or not, are one SCs element, any other element is an SCs element of
+   // its own
+   std::pmr::unordered_set<SCgElement const *> elementsNamedAfterIds(resource);
+   for (SCgElement const * element : namedElements)
+   {
+     if (!IsNamedAfterIdentifier(m_names[element], element->GetIdentifier()))
+       elementsNamedAfterIds.insert(element);
+   }
+   auto const isSameElement = [&elementsNamedAfterIds](SCgElement const * first, SCgElement const * second)
+   {
+     return first == second
+            || (!elementsNamedAfterIds.count(first) && !elementsNamedAfterIds.count(second)
+                && first->GetIdentifier() == second->GetIdentifier());
+   };
+ 
+   // Identifiers written as they are can't collide, so they keep their names. Other names are known before any suffix
+   // is chosen, a suffixed name can't take a name that comes later.
+   std::pmr::unordered_map<std::string_view, SCgElement const *> owners(resource);
+   std::pmr::vector<std::pair<std::string_view, SCgElement const *>> madeNames(resource);
+   for (SCgElement const * element : namedElements)
+   {
+     std::string_view const name = m_names[element];
+     if (name == element->GetIdentifier())
+       owners.emplace(name, element);
+     else
+       madeNames.emplace_back(name, element);
+   }
+ 
+   std::sort(
+       madeNames.begin(),
+       madeNames.end(),
+       [](auto const & first, auto const & second)
+       {
+         return first.first != second.first ? first.first < second.first
+                                            : first.second->GetId() < second.second->GetId();
+       });
+   std::pmr::vector<SCgElement const *> collidingElements(resource);
+   for (auto const & [name, element] : madeNames)
+   {
+     auto const [ownerIt, isInserted] = owners.emplace(name, element);
+     if (!isInserted && !isSameElement(ownerIt->second, element))
+       collidingElements.push_back(element);
+   }
+ 
+   for (SCgElement const * element : collidingElements)
+   {
+     std::pmr::string & name = m_names[element];
+     std::pmr::string suffixedName(resource);
+     size_t suffix = 0;
+     decltype(owners)::const_iterator ownerIt;
+     do
+     {
+       suffixedName.assign(name).append(UNDERSCORE).append(std::to_string(++suffix));
+       ownerIt = owners.find(suffixedName);
+     } while (ownerIt != owners.cend() && !isSameElement(ownerIt->second, element));
+ 
+     // Elements of one SCs element share the name their first element is given
+     if (ownerIt == owners.cend())
+     {
+       SC_LOG_WARNING(
+           "SCsWriter::IdentifierIndex: Name `" << name << "` of element `" << element->GetId()
+                                                << "` is a name of another element, `" << suffixedName
+                                                << "` is used instead.");
+       ++m_collisionsCount;
+     }
+     name = std::move(suffixedName);
+     owners.emplace(name, element);
+   }
+ }
+ 
+ void SCsWriter::IdentifierIndex::Collect(
+     SCgElements const & elements,
+     std::pmr::vector<SCgElement const *> & namedElements,
+     std::pmr::string & mainIdentifier)
+ {
+   for (auto const & [id, element] : elements)
+   {
+     // Each element is named once, even if it's reached through several contours
+     if (m_names.count(element.get()))
+       continue;
+ 
+     std::pmr::string & name = m_names[element.get()];
+     namedElements.push_back(element.get());
+     std::string_view const tag = element->GetTag();
+     if (tag == ARC || tag == PAIR)
+     {
+       // Aliases of connectors are only defined when connectors are written, and ends of connectors are named before
+       name.assign(element->GetIdentifier());
+       if (name.empty())
+         name.assign("node_").append(element->GetId());
+     }
+     else
+     {
+       SCgIdentifierCorrector::GenerateSCsIdentifier(*element, name, mainIdentifier);
+       if (!mainIdentifier.empty())
+         m_mainIdentifiers.emplace(element.get(), mainIdentifier);
+     }
+ 
+     if (tag == CONTOUR)
+       Collect(std::static_pointer_cast<SCgContour>(element)->GetElements(), namedElements, mainIdentifier);
+   }
+ }
+ 
+ std::string_view SCsWriter::IdentifierIndex::GetName(SCgElementPtr const & element) const
+ {
+   auto const it = m_names.find(element.get());
+   if (it == m_names.cend())
+     SC_THROW_EXCEPTION(
+         utils::ExceptionItemNotFound,
+         "SCsWriter::IdentifierIndex::GetName: Element `" << element->GetId() << "` isn't indexed.");
+ 
+   return it->second;
+ }
+ 
+ std::string_view SCsWriter::IdentifierIndex::GetMainIdentifier(SCgElementPtr const & element) const
+ {
+   auto const it = m_mainIdentifiers.find(element.get());
+   return it == m_mainIdentifiers.cend() ? std::string_view() : std::string_view(it->second);
+ }
+ 
+ size_t SCsWriter::IdentifierIndex::GetCollisionsCount() const
+ {
+   return m_collisionsCount;
+ }
+ 
  std::string SCsWriter::MakeAlias(std::string const & prefix, std::string const & elementId)
  {
    return ALIAS_PREFIX + prefix + UNDERSCORE + utils::StringUtils::ReplaceAll(elementId, DASH, UNDERSCORE);
  }
  
- bool SCsWriter::IsVariable(std::string const & elementType)
+ bool SCsWriter::IsVariable(std::string_view elementType)
  {
-   return elementType.find(VAR) != std::string::npos;
+   return elementType.find(VAR) != std::string_view::npos;
  }
  
- bool SCsWriter::SCgIdentifierCorrector::IsRussianIdentifier(std::string const & identifier)
+ bool SCsWriter::SCgIdentifierCorrector::IsRussianIdentifier(std::string_view identifier)
  {
-   std::regex identifierPatternRus(R"(^[0-9a-zA-Z_\xD0\x80-\xD1\x8F\xD1\x90-\xD1\x8F\xD1\x91\xD0\x81*' ]*$)");
-   return std::regex_match(identifier, identifierPatternRus);
+   GWF_COUNT_HOT_PATH(RegexEvaluations);
+   return std::all_of(identifier.cbegin(), identifier.cend(), IsRussianCharacter);
  }
  
- bool SCsWriter::SCgIdentifierCorrector::IsEnglishIdentifier(std::string const & identifier)
+ bool SCsWriter::SCgIdentifierCorrector::IsEnglishIdentifier(std::string_view identifier)
  {
-   std::regex identifierPatternEng("^[0-9a-zA-Z_]*$");
-   return std::regex_match(identifier, identifierPatternEng);
+   GWF_COUNT_HOT_PATH(RegexEvaluations);
+   return std::all_of(identifier.cbegin(), identifier.cend(), IsEnglishCharacter);
  }
  
- std::string SCsWriter::SCgIdentifierCorrector::GenerateCorrectedIdentifier(
-     std::string & systemIdentifier,
-     std::string const & elementId,
+ void SCsWriter::SCgIdentifierCorrector::GenerateCorrectedIdentifier(
+     std::pmr::string & systemIdentifier,
+     std::string_view elementId,
      bool isVar)
  {
    if (systemIdentifier.empty())
-     return GenerateIdentifierForUnresolvedCharacters(systemIdentifier, elementId, isVar);
- 
-   if (isVar && systemIdentifier[0] != UNDERSCORE[0])
-     return GenerateSCsIdentifierForVariable(systemIdentifier);
- 
-   return systemIdentifier;
+     GenerateIdentifierForUnresolvedCharacters(systemIdentifier, elementId, isVar);
+   else if (isVar && systemIdentifier[0] != UNDERSCORE[0])
+     GenerateSCsIdentifierForVariable(systemIdentifier);
  }
  
- std::string SCsWriter::SCgIdentifierCorrector::GenerateIdentifierForUnresolvedCharacters(
-     std::string & systemIdentifier,
-     std::string const & elementId,
+ void SCsWriter::SCgIdentifierCorrector::GenerateIdentifierForUnresolvedCharacters(
+     std::pmr::string & systemIdentifier,
+     std::string_view elementId,
      bool isVar)
  {
-   std::string const & prefix = isVar ? EL_VAR_PREFIX : EL_PREFIX;
-   systemIdentifier = prefix + UNDERSCORE + utils::StringUtils::ReplaceAll(elementId, DASH, UNDERSCORE);
-   return systemIdentifier;
+   systemIdentifier.assign(isVar ? EL_VAR_PREFIX : EL_PREFIX).append(UNDERSCORE);
+   for (char const character : elementId)
+     systemIdentifier.push_back(character == DASH[0] ? UNDERSCORE[0] : character);
  }
  
- std::string SCsWriter::SCgIdentifierCorrector::GenerateSCsIdentifierForVariable(std::string & systemIdentifier)
+ void SCsWriter::SCgIdentifierCorrector::GenerateSCsIdentifierForVariable(std::pmr::string & systemIdentifier)
  {
-   return UNDERSCORE + systemIdentifier;
+   systemIdentifier.insert(0, UNDERSCORE);
  }
  
  void SCsWriter::SCgIdentifierCorrector::GenerateSCsIdentifier(
      SCgElementPtr const & scgElement,
      SCsElementPtr & scsElement)
  {
-   scsElement->SetIdentifierForSCs(scgElement->GetIdentifier());
-   bool isVar = SCsWriter::IsVariable(scgElement->GetType());
+   std::pmr::string systemIdentifier;
+   std::pmr::string mainIdentifier;
+   GenerateSCsIdentifier(*scgElement, systemIdentifier, mainIdentifier);
  
-   std::string const & systemIdentifier = scsElement->GetIdentifierForSCs();
-   if (!IsEnglishIdentifier(systemIdentifier))
-   {
-     if (IsRussianIdentifier(systemIdentifier))
-       scsElement->SetMainIdentifier(systemIdentifier);
+   if (!mainIdentifier.empty())
+     scsElement->SetMainIdentifier(std::string(mainIdentifier));
+   scsElement->SetIdentifierForSCs(std::string(systemIdentifier));
+ }
  
-     scsElement->SetIdentifierForSCs("");
+ void SCsWriter::SCgIdentifierCorrector::GenerateSCsIdentifier(
+     SCgElement const & scgElement,
+     std::pmr::string & systemIdentifier,
+     std::pmr::string & mainIdentifier)
+ {
+   std::string_view const id = scgElement.GetId();
+   std::string_view const tag = scgElement.GetTag();
+   mainIdentifier.clear();
+   if (tag == PAIR || tag == ARC)
+   {
+     systemIdentifier.assign(ALIAS_PREFIX).append(CONNECTOR).append(UNDERSCORE);
+     for (char const character : id)
+       systemIdentifier.push_back(character == DASH[0] ? UNDERSCORE[0] : character);
+     return;
    }
  
-   std::string id = scgElement->GetId();
-   std::string correctedIdentifier = scsElement->GetIdentifierForSCs();
-   correctedIdentifier = GenerateCorrectedIdentifier(correctedIdentifier, id, isVar);
-   scsElement->SetIdentifierForSCs(correctedIdentifier);
+   std::string_view const identifier = scgElement.GetIdentifier();
+   systemIdentifier.assign(identifier);
+   if (!IsEnglishIdentifier(identifier))
+   {
+     if (IsRussianIdentifier(identifier))
+       mainIdentifier.assign(identifier);
  
-   auto const & tag = scgElement->GetTag();
-   if (tag == PAIR || tag == ARC)
-     scsElement->SetIdentifierForSCs(SCsWriter::MakeAlias(CONNECTOR, id));
+     systemIdentifier.clear();
+   }
+ 
+   GenerateCorrectedIdentifier(systemIdentifier, id, IsVariable(scgElement.GetType()));
  }
  
  // Вспомогательная функция для рекурсивного сбора узлов
  void SCsWriter::CollectNodes(
      SCgElements const & elements,
-     std::unordered_set<SCgElementPtr> & nodes,
-     std::unordered_set<SCgElementPtr> & visitedContours)
+     SCgElementsSet & nodes,
+     SCgElementsSet & visitedContours)
  {
    for (auto const & [id, element] : elements)
    {
@@ -120,41 +326,126 @@
      std::string const & filePath,
      Buffer & buffer,
      size_t depth,
-     std::unordered_set<SCgElementPtr> & writtenElements)
+     SCgElementsSet & writtenElements)
+ {
+   IdentifierIndex const identifiers(elements, writtenElements.get_allocator().resource());
+   Write(elements, filePath, buffer, depth, writtenElements, identifiers);
+ }
+ 
+ void SCsWriter::Write(
+     SCgElements const & elements,
+     std::string const & filePath,
+     Buffer & buffer,
+     size_t depth,
+     SCgElementsSet & writtenElements,
+     IdentifierIndex const & identifiers)
+ {
+   SCgElementsSet visitedContours(writtenElements.get_allocator());
+   Write(elements, filePath, buffer, depth, writtenElements, identifiers, visitedContours);
+ }
+ 
+ void SCsWriter::Write(
+     SCgElements const & elements,
+     std::string const & filePath,
+     Buffer & buffer,
+     size_t depth,
+     SCgElementsSet & writtenElements,
+     IdentifierIndex const & identifiers,
+     SCgElementsSet & visitedContours)
  {
    // Шаг 1: Сбор всех узлов, включая вложенные в контуры
-   std::unordered_set<SCgElementPtr> allNodes;
-   std::unordered_set<SCgElementPtr> visitedContours;
+   // Контуры, обойдённые на внешних уровнях, не обходятся повторно: все их узлы уже записаны
+   // Вспомогательные контейнеры используют ресурс памяти трансляции
+   SCgElementsSet allNodes(writtenElements.get_allocator());
    CollectNodes(elements, allNodes, visitedContours);
  
    // Запись типов всех узлов
    for (auto const & node : allNodes)
    {
+     GWF_COUNT_HOT_PATH(WrittenElementsLookups);
      if (writtenElements.count(node)) continue;
      writtenElements.insert(node);
-     std::string identifier = node->GetIdentifier();
-     if (identifier.empty()) identifier = "node_" + node->GetId();
-     buffer.AddTabs(depth) << identifier << "\n";
+     buffer.AddTabs(depth) << identifiers.GetName(node) << "\n";
  
      // Запись типа узла
-     std::string elementTypeStr;
+     std::string_view elementTypeStr;
      SCgToSCsTypesConverter::ConvertSCgNodeTypeToSCsNodeType(node->GetType(), elementTypeStr);
      if (elementTypeStr.empty()) elementTypeStr = "node_";
      buffer.AddTabs(depth + 1) << "<- " << elementTypeStr << ";;\n";
  
+     // Идентификатор, не являющийся именем SCs, сохраняется основным идентификатором узла
+     std::string_view const mainIdentifier = identifiers.GetMainIdentifier(node);
+     if (!mainIdentifier.empty())
+       buffer.AddTabs(depth + 1) << SC_CONNECTOR_DCOMMON_R << SPACE << NREL_MAIN_IDTF << COLON << SPACE << OPEN_BRACKET
+                                 << mainIdentifier << CLOSE_BRACKET << ELEMENT_END << NEWLINE;
+ 
      // Проверка, является ли узел SCgLink, и запись содержимого
      auto link = std::dynamic_pointer_cast<SCgLink>(node);
-     if (link && !link->GetContentData().empty())
+     if (link && !link->GetStoredContentPath().empty())
      {
-       std::string content = link->GetContentData();
-       buffer.AddTabs(depth + 1) << "-> [" << content << "];;\n";
+       // Содержимое, сохранённое в хранилище, загружается из его файла. Файлы хранилища названы только хешами
+       // содержимого, поэтому формат содержимого записывается по расширению имени файла ссылки
+       buffer.AddTabs(depth + 1) << "-> " << DOUBLE_QUOTE << FILE_PREFIX;
+       AppendEscaped(buffer, link->GetStoredContentPath());
+       buffer << DOUBLE_QUOTE << ";;\n";
+ 
+       std::string_view const format = GetFormat(link->GetFileName());
+       if (!format.empty())
+       {
+         buffer.AddTabs(depth + 1) << SC_CONNECTOR_DCOMMON_R << SPACE << NREL_FORMAT << COLON << SPACE << "format_";
+         for (char const character : format)
+         {
+           char const lowerCharacter = character >= 'A' && character <= 'Z' ? character - 'A' + 'a' : character;
+           buffer.Append(&lowerCharacter, 1);
+         }
+         buffer << ELEMENT_END << NEWLINE;
+       }
+     }
+     else if (link && link->IsContentSpilled())
+     {
+       // Содержимое, не поместившееся в бюджет памяти, копируется из временного файла частями
+       buffer.AddTabs(depth + 1) << "-> [";
+       link->ReadSpilledContent(
+           [&buffer](char const * data, size_t size)
+           {
+             buffer.Append(data, size);
+           });
+       buffer << "];;\n";
+     }
+     else if (link && link->IsContentDeferred())
+     {
+       // Содержимое, оставленное в тексте gwf, декодируется сразу в буфер частями.
+       // Обработчик частей хранит одну ссылку на состояние, поэтому не выделяет память
+       struct
+       {
+         Buffer & m_buffer;
+         size_t m_depth;
+         bool m_isStarted;
+       } content{buffer, depth + 1, false};
+       link->ReadDeferredContent(
+           [&content](char const * data, size_t size)
+           {
+             if (!content.m_isStarted)
+             {
+               content.m_buffer.AddTabs(content.m_depth) << "-> [";
+               content.m_isStarted = true;
+             }
+             content.m_buffer.Append(data, size);
+           });
+       if (content.m_isStarted)
+         buffer << "];;\n";
+     }
+     else if (link && !link->GetContentData().empty())
+     {
+       buffer.AddTabs(depth + 1) << "-> [" << link->GetContentData() << "];;\n";
      }
      buffer << "\n";
    }
  
    // Шаг 2: Предварительная обработка для дуг
-   std::unordered_set<SCgElementPtr> complexArcs;
-   std::unordered_set<SCgElementPtr> attributeArcs;
+   // Для каждой дуги с входящими атрибутными дугами запоминается источник первой из них
+   std::pmr::unordered_map<SCgElementPtr, SCgElementPtr> complexArcs(writtenElements.get_allocator());
+   SCgElementsSet attributeArcs(writtenElements.get_allocator());
    for (auto const & [id, element] : elements)
    {
      if (element->GetTag() == ARC || element->GetTag() == PAIR)
@@ -163,7 +454,7 @@
        auto target = connector->GetTarget();
        if (target->GetTag() == ARC || target->GetTag() == PAIR)
        {
-         complexArcs.insert(target);
+         complexArcs.emplace(target, connector->GetSource());
          attributeArcs.insert(element);
        }
      }
@@ -174,43 +465,31 @@
    {
      if (element->GetTag() == ARC || element->GetTag() == PAIR)
      {
+       GWF_COUNT_HOT_PATH(WrittenElementsLookups);
        if (writtenElements.count(element)) continue;
        if (attributeArcs.count(element)) continue;
        writtenElements.insert(element);
  
        auto connector = std::dynamic_pointer_cast<SCgConnector>(element);
-       std::string sourceId = connector->GetSource()->GetIdentifier();
-       std::string targetId = connector->GetTarget()->GetIdentifier();
-       if (sourceId.empty()) sourceId = "node_" + connector->GetSource()->GetId();
-       if (targetId.empty()) targetId = "node_" + connector->GetTarget()->GetId();
+       std::string_view const sourceId = identifiers.GetName(connector->GetSource());
+       std::string_view const targetId = identifiers.GetName(connector->GetTarget());
  
-       if (complexArcs.count(element))
+       auto const complexArcIt = complexArcs.find(element);
+       if (complexArcIt != complexArcs.cend())
        {
-         std::string attrSourceId;
-         for (auto const & [incomingId, incomingElement] : elements)
-         {
-           if (incomingElement->GetTag() == ARC || incomingElement->GetTag() == PAIR)
-           {
-             auto incConnector = std::dynamic_pointer_cast<SCgConnector>(incomingElement);
-             if (incConnector->GetTarget() == element)
-             {
-               attrSourceId = incConnector->GetSource()->GetIdentifier();
-               if (attrSourceId.empty()) attrSourceId = "node_" + incConnector->GetSource()->GetId();
-               break;
-             }
-           }
-         }
+         SCgElementPtr const & attrSource = complexArcIt->second;
+         std::string_view const attrSourceId = identifiers.GetName(attrSource);
  
          if (!attrSourceId.empty())
          {
-           std::string connectorSymbol;
+           std::string_view connectorSymbol;
            SCgToSCsTypesConverter::ConvertSCgConnectorTypeToSCsConnectorDesignation(connector->GetType(), connectorSymbol);
            if (connectorSymbol.empty()) connectorSymbol = "->";
            buffer.AddTabs(depth) << sourceId << " " << connectorSymbol << " " << attrSourceId << ": " << targetId << ";;\n\n";
          }
          else
          {
-           std::string connectorSymbol;
+           std::string_view connectorSymbol;
            SCgToSCsTypesConverter::ConvertSCgConnectorTypeToSCsConnectorDesignation(connector->GetType(), connectorSymbol);
            if (connectorSymbol.empty()) connectorSymbol = "->";
            buffer.AddTabs(depth) << sourceId << " " << connectorSymbol << " " << targetId << ";;\n\n";
@@ -218,7 +497,7 @@
        }
        else
        {
-         std::string connectorSymbol;
+         std::string_view connectorSymbol;
          SCgToSCsTypesConverter::ConvertSCgConnectorTypeToSCsConnectorDesignation(connector->GetType(), connectorSymbol);
          if (connectorSymbol.empty()) connectorSymbol = "->";
          buffer.AddTabs(depth) << sourceId << " " << connectorSymbol << " " << targetId << ";;\n\n";
@@ -231,14 +510,21 @@
    {
      if (element->GetTag() == CONTOUR)
      {
+       GWF_COUNT_HOT_PATH(WrittenElementsLookups);
        if (writtenElements.count(element)) continue;
        writtenElements.insert(element);
        auto contour = std::dynamic_pointer_cast<SCgContour>(element);
-       std::string identifier = element->GetIdentifier();
-       if (identifier.empty()) identifier = "contour_" + element->GetId();
-       buffer.AddTabs(depth) << identifier << " = [*\n";
-       Write(contour->GetElements(), filePath, buffer, depth + 1, writtenElements);
-       buffer.AddTabs(depth) << "*];;\n\n";
+       buffer.AddTabs(depth) << identifiers.GetName(element) << " = [*\n";
+       GWFTracer::ScopedSpan const span("contour", element->GetId());
+       Write(contour->GetElements(), filePath, buffer, depth + 1, writtenElements, identifiers, visitedContours);
+       buffer.AddTabs(depth) << "*];;\n";
+ 
+       std::string_view const mainIdentifier = identifiers.GetMainIdentifier(element);
+       if (!mainIdentifier.empty())
+         buffer.AddTabs(depth) << identifiers.GetName(element) << SPACE << SC_CONNECTOR_DCOMMON_R << SPACE
+                               << NREL_MAIN_IDTF << COLON << SPACE << OPEN_BRACKET << mainIdentifier << CLOSE_BRACKET
+                               << ELEMENT_END << NEWLINE;
+       buffer << "\n";
      }
    }
  }
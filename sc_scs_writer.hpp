@@ -6,9 +6,13 @@
 
  #pragma once
 
+ #include <memory_resource>
  #include <string>
+ #include <string_view>
  #include <sstream>
+ #include <unordered_map>
  #include <unordered_set>
+ #include <vector>
  
  #include "buffer.hpp"
  #include "gwf_translator_constants.hpp"
@@ -17,12 +21,53 @@
  class SCsWriter
  {
  public:
+   /*!
+    * Names of elements in SCs text of one translation. Elements other than connectors are named by
+    * SCgIdentifierCorrector, so an element whose identifier isn't a valid SCs name is named after its id, and a
+    * name may coincide with a name of another element, which would merge both elements in the knowledge base. All
+    * names are hashed once, so each element is checked for a collision in constant time. Identifiers written as they
+    * are keep their names, other colliding names get the smallest numeric suffix that is free, in their order, so a
+    * diagram always gets the same names. Elements named after equal identifiers don't collide: they are one SCs
+    * element by design.
+    */
+   class IdentifierIndex
+   {
+   public:
+     explicit IdentifierIndex(
+         SCgElements const & elementsWithoutParents,
+         std::pmr::memory_resource * resource = std::pmr::get_default_resource());
+ 
+     std::string_view GetName(SCgElementPtr const & element) const;
+     // Identifier that isn't a valid SCs name but is kept as the main identifier of the element, empty if there is none
+     std::string_view GetMainIdentifier(SCgElementPtr const & element) const;
+     size_t GetCollisionsCount() const;
+ 
+   private:
+     std::pmr::unordered_map<SCgElement const *, std::pmr::string> m_names;
+     std::pmr::unordered_map<SCgElement const *, std::pmr::string> m_mainIdentifiers;
+     size_t m_collisionsCount = 0;
+ 
+     void Collect(
+         SCgElements const & elements,
+         std::pmr::vector<SCgElement const *> & namedElements,
+         std::pmr::string & mainIdentifier);
+   };
+ 
+   // Names elements of the translation by themselves
+   static void Write(
+       SCgElements const & elements,
+       std::string const & filePath,
+       Buffer & buffer,
+       size_t depth,
+       SCgElementsSet & writtenElements);
+
    static void Write(
        SCgElements const & elements,
        std::string const & filePath,
        Buffer & buffer,
        size_t depth,
-       std::unordered_set<SCgElementPtr> & writtenElements);
+       SCgElementsSet & writtenElements,
+       IdentifierIndex const & identifiers);
  
    static void WriteMainIdentifier(
        Buffer & buffer,
@@ -31,31 +76,47 @@
        std::string const & mainIdentifier);
  
    static std::string MakeAlias(std::string const & prefix, std::string const & elementId);
-   static bool IsVariable(std::string const & elementType);
+   static bool IsVariable(std::string_view elementType);
  
    class SCgIdentifierCorrector
    {
    public:
      static void GenerateSCsIdentifier(SCgElementPtr const & scgElement, SCsElementPtr & scsElement);
+     // Makes the same identifiers into strings, which keep their resource, so no memory is allocated once the strings
+     // have enough capacity. The main identifier is cleared if the element has none.
+     static void GenerateSCsIdentifier(
+         SCgElement const & scgElement,
+         std::pmr::string & systemIdentifier,
+         std::pmr::string & mainIdentifier);
  
    private:
-     static bool IsRussianIdentifier(std::string const & identifier);
-     static bool IsEnglishIdentifier(std::string const & identifier);
+     // Patterns of identifiers are matched byte by byte: std::regex allocates memory on every match
+     static bool IsRussianIdentifier(std::string_view identifier);
+     static bool IsEnglishIdentifier(std::string_view identifier);
  
-     static std::string GenerateIdentifierForUnresolvedCharacters(
-         std::string & systemIdentifier,
-         std::string const & elementId,
+     static void GenerateIdentifierForUnresolvedCharacters(
+         std::pmr::string & systemIdentifier,
+         std::string_view elementId,
          bool isVar);
-     static std::string GenerateCorrectedIdentifier(
-         std::string & systemIdentifier,
-         std::string const & elementId,
+     static void GenerateCorrectedIdentifier(
+         std::pmr::string & systemIdentifier,
+         std::string_view elementId,
          bool isVar);
-     static std::string GenerateSCsIdentifierForVariable(std::string & systemIdentifier);
+     static void GenerateSCsIdentifierForVariable(std::pmr::string & systemIdentifier);
    };
  
  private:
+   static void Write(
+       SCgElements const & elements,
+       std::string const & filePath,
+       Buffer & buffer,
+       size_t depth,
+       SCgElementsSet & writtenElements,
+       IdentifierIndex const & identifiers,
+       SCgElementsSet & visitedContours);
+ 
    static void CollectNodes(
        SCgElements const & elements,
-       std::unordered_set<SCgElementPtr> & nodes,
-       std::unordered_set<SCgElementPtr> & visitedContours);
+       SCgElementsSet & nodes,
+       SCgElementsSet & visitedContours);
  };
\ No newline at end of file
@@ -0,0 +1,103 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+/*
+ * Checks that GWFBlobStore names blobs by hashes of contents alone and that SCs text refers to them, e.g.
+ *
+ *   g++ -std=c++17 -I. -I/usr/include/libxml2 *.cpp tests/gwf_blob_store_test.cpp -lsc-memory -lxml2 -lpthread
+ *
+ * Two image links embed the same content as `image.png` and `photo.PNG`, and the store is in a directory which name
+ * has a quote and a backslash. Exits with a non-zero status if the content is stored twice, if its blob is named with
+ * an extension, if the path isn't escaped in SCs text, or if the format of a link isn't written.
+ */
+
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "buffer.hpp"
+#include "gwf_blob_store.hpp"
+#include "gwf_parser.hpp"
+#include "sc_scg_element.hpp"
+#include "sc_scs_writer.hpp"
+
+namespace
+{
+std::string MakeImageLink(std::string const & id, std::string const & fileName)
+{
+  return "<node type=\"node/const/terminal\" idtf=\"image_" + id + "\" id=\"" + id
+         + "\" parent=\"0\" left=\"0\" top=\"0\"><content type=\"4\" mime_type=\"image/png\" file_name=\"" + fileName
+         + "\">qHSbiWpR</content></node>";
+}
+
+std::string Escape(std::string const & string)
+{
+  std::string escapedString;
+  for (char const character : string)
+  {
+    if (character == '"' || character == '\\')
+      escapedString += '\\';
+    escapedString += character;
+  }
+  return escapedString;
+}
+}  // namespace
+
+int main()
+{
+  std::filesystem::path const directory =
+      std::filesystem::temp_directory_path() / "gwf_blob_store_test" / "quote\"back\\slash";
+  std::filesystem::remove_all(directory.parent_path());
+
+  std::string const xmlStr = "<?xml version=\"1.0\" encoding=\"UTF-8\"?><GWF version=\"2.0\"><staticSector>"
+                             + MakeImageLink("1", "image.png") + MakeImageLink("2", "photo.PNG")
+                             + "</staticSector></GWF>";
+
+  int status = EXIT_SUCCESS;
+  auto const fail = [&status](std::string const & message)
+  {
+    std::cerr << message << "\n";
+    status = EXIT_FAILURE;
+  };
+
+  {
+    GWFBlobStore blobStore(directory.string());
+    SCgElements elements;
+    GWFParser::Parse(xmlStr, elements, nullptr, {&blobStore});
+
+    std::string const path = std::string(std::static_pointer_cast<SCgLink>(elements.at("1"))->GetStoredContentPath());
+    if (std::static_pointer_cast<SCgLink>(elements.at("2"))->GetStoredContentPath() != path)
+      fail("Equal contents of files with different extensions are stored as different blobs.");
+    if (std::filesystem::path(path).filename() != GWFBlobStore::ComputeHash(std::string("\xa8\x74\x9b\x89\x6a\x51")))
+      fail("Blob `" + path + "` isn't named by the hash of its content alone.");
+
+    GWFBlobStore::Stats const stats = blobStore.GetStats();
+    if (stats.m_storedBlobs != 1 || stats.m_deduplicatedContents != 1)
+      fail("The content isn't stored once: " + stats.ToJSON() + ".");
+
+    Buffer buffer;
+    SCgElementsSet writtenElements;
+    SCsWriter::Write(elements, "blobs.gwf", buffer, 0, writtenElements);
+    std::string const scsText = buffer.GetValue();
+    if (scsText.find("\"file://" + Escape(path) + "\";;") == std::string::npos)
+      fail("The path of the blob isn't escaped in SCs text:\n" + scsText);
+
+    std::size_t formatsCount = 0;
+    for (std::size_t position = scsText.find("=> nrel_format: format_png;;"); position != std::string::npos;
+         position = scsText.find("=> nrel_format: format_png;;", position + 1))
+      ++formatsCount;
+    if (formatsCount != 2)
+      fail("Formats of links aren't written:\n" + scsText);
+  }
+
+  std::filesystem::remove_all(directory.parent_path());
+
+  if (status == EXIT_SUCCESS)
+    std::cout << "Equal contents have been stored once and referred to from SCs text.\n";
+  return status;
+}
@@ -0,0 +1,112 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+/*
+ * Checks that GWFParser reads link contents larger than the default limits of libxml2 on text nodes, e.g.
+ *
+ *   g++ -std=c++17 -I. -I/usr/include/libxml2 *.cpp tests/gwf_parser_test.cpp -lsc-memory -lxml2 -lpthread
+ *
+ * A diagram with a text link of 11 MB and an image link of 11 MB is read by every path of the parser: from memory,
+ * from memory with deferred image contents, and from a file in chunks. Exits with a non-zero status if any path fails
+ * or reads a content of another size.
+ */
+
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "gwf_generator.hpp"
+#include "gwf_parser.hpp"
+#include "sc_scg_element.hpp"
+
+namespace
+{
+// libxml2 refuses text nodes over 10000000 bytes unless huge documents are allowed
+std::size_t const HUGE_CONTENT_SIZE = 11 * 1024 * 1024;
+
+std::string MakeDiagram()
+{
+  GWFGenerator::Params params;
+  params.m_nodesCount = 10;
+  params.m_stringLinksCount = 1;
+  params.m_imageLinksCount = 1;
+  params.m_imageSize = HUGE_CONTENT_SIZE;
+  std::string xmlStr = GWFGenerator::Generate(params);
+
+  std::string const contentBegin = "<![CDATA[";
+  xmlStr.insert(xmlStr.find(contentBegin) + contentBegin.size(), HUGE_CONTENT_SIZE, 'a');
+  return xmlStr;
+}
+
+bool Check(std::string const & pathName, std::function<void(SCgElements &)> const & parse)
+{
+  std::size_t hugeContentsCount = 0;
+  try
+  {
+    SCgElements elements;
+    parse(elements);
+    for (auto const & [id, element] : elements)
+    {
+      auto const link = std::dynamic_pointer_cast<SCgLink>(element);
+      if (link != nullptr && link->GetContentSize() >= HUGE_CONTENT_SIZE)
+        ++hugeContentsCount;
+    }
+  }
+  catch (std::exception const & exception)
+  {
+    std::cerr << pathName << ": " << exception.what() << "\n";
+    return false;
+  }
+
+  if (hugeContentsCount != 2)
+  {
+    std::cerr << pathName << ": " << hugeContentsCount << " contents of 11 MB have been read instead of 2.\n";
+    return false;
+  }
+  return true;
+}
+}  // namespace
+
+int main()
+{
+  std::string const xmlStr = MakeDiagram();
+  std::string const filePath = (std::filesystem::temp_directory_path() / "gwf_parser_test.gwf").string();
+  std::ofstream(filePath, std::ios::binary) << xmlStr;
+
+  bool isPassed = Check(
+      "memory",
+      [&xmlStr](SCgElements & elements)
+      {
+        GWFParser::Parse(xmlStr, elements);
+      });
+  isPassed = Check(
+                 "deferred",
+                 [&xmlStr](SCgElements & elements)
+                 {
+                   GWFParser::Parse(xmlStr, elements, nullptr, {nullptr, nullptr, true});
+                 })
+             && isPassed;
+  isPassed = Check(
+                 "file",
+                 [&filePath](SCgElements & elements)
+                 {
+                   GWFParser::ParseFile(filePath, elements);
+                 })
+             && isPassed;
+
+  std::filesystem::remove(filePath);
+
+  if (!isPassed)
+    return EXIT_FAILURE;
+
+  std::cout << "Link contents of 11 MB have been read.\n";
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,105 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+/*
+ * Checks that a warm translation session doesn't allocate on the heap. Must be built with
+ * GWF_TRANSLATOR_COUNT_ALLOCATIONS defined, so that the global operator new and the libxml2 allocator are counted, e.g.
+ *
+ *   g++ -std=c++17 -DGWF_TRANSLATOR_COUNT_ALLOCATIONS -I. -I/usr/include/libxml2 *.cpp \
+ *       tests/gwf_translation_session_test.cpp -lsc-memory -lxml2 -lpthread
+ *
+ * Exits with a non-zero status if any translation after the warm-up allocates.
+ */
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "gwf_allocation_counter.hpp"
+#include "gwf_generator.hpp"
+#include "gwf_translation_session.hpp"
+
+namespace
+{
+// Translations of every file before the counted ones, the arena grows to its final size during them
+std::size_t const WARM_UP_ROUNDS = 2;
+std::size_t const COUNTED_ROUNDS = 3;
+
+// Diagrams of one shape with different seeds, so that ids, identifiers and types differ between the files
+GWFGenerator::Params MakeParams(uint64_t seed)
+{
+  GWFGenerator::Params params;
+  params.m_seed = seed;
+  params.m_nodesCount = 2000;
+  params.m_stringLinksCount = 300;
+  params.m_numericLinksCount = 100;
+  params.m_imageLinksCount = 20;
+  params.m_imageSize = 8 * 1024;
+  params.m_busesCount = 20;
+  params.m_rootContoursCount = 5;
+  params.m_contourDepth = 3;
+  params.m_contourFanOut = 2;
+  params.m_pairsCount = 2000;
+  params.m_arcsCount = 1000;
+  params.m_attributeChainsCount = 50;
+  params.m_attributeChainLength = 3;
+  params.m_hubsCount = 5;
+  params.m_hubConnectorsPercent = 20;
+  return params;
+}
+}  // namespace
+
+int main()
+{
+  if (!GWFAllocationCounter::IsExact())
+  {
+    std::cerr << "The test must be built with GWF_TRANSLATOR_COUNT_ALLOCATIONS defined.\n";
+    return EXIT_FAILURE;
+  }
+
+  std::filesystem::path const directory = std::filesystem::temp_directory_path();
+  std::vector<std::string> filenames;
+  for (uint64_t seed : {1, 2, 3})
+  {
+    std::string const & filename =
+        (directory / ("gwf_translation_session_test_" + std::to_string(seed) + ".gwf")).string();
+    std::ofstream file(filename);
+    GWFGenerator::Generate(MakeParams(seed), file);
+    filenames.push_back(filename);
+  }
+
+  int status = EXIT_SUCCESS;
+  {
+    GWFTranslationSession session;
+    for (std::size_t round = 0; round < WARM_UP_ROUNDS + COUNTED_ROUNDS; ++round)
+    {
+      for (std::string const & filename : filenames)
+      {
+        GWFAllocationCounter::Snapshot const before = GWFAllocationCounter::TakeSnapshot();
+        session.Translate(filename);
+        GWFAllocationCounter::Snapshot const after = GWFAllocationCounter::TakeSnapshot();
+
+        std::size_t const allocationsCount = after.m_allocationsCount - before.m_allocationsCount;
+        if (round >= WARM_UP_ROUNDS && allocationsCount != 0)
+        {
+          std::cerr << "Translation " << round + 1 << " of `" << filename << "` made " << allocationsCount
+                    << " heap allocations of " << after.m_allocatedBytes - before.m_allocatedBytes << " bytes.\n";
+          status = EXIT_FAILURE;
+        }
+      }
+    }
+  }
+
+  for (std::string const & filename : filenames)
+    std::filesystem::remove(filename);
+
+  if (status == EXIT_SUCCESS)
+    std::cout << "Warm translations made no heap allocations.\n";
+  return status;
+}
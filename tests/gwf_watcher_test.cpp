@@ -0,0 +1,119 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+/*
+ * Checks that a file saved twice while the translation thread of GWFWatcher is busy is translated once, from its newest
+ * content, e.g.
+ *
+ *   g++ -std=c++17 -I. -I/usr/include/libxml2 *.cpp tests/gwf_watcher_test.cpp -lsc-memory -lxml2 -lpthread
+ *
+ * The first save of the file becomes ready while the thread is blocked in a callback of another file, and the second
+ * save is still in its debounce window when the thread takes the file. Exits with a non-zero status if the file isn't
+ * translated exactly once, if any translation fails, or if the second save isn't the one translated.
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gwf_generator.hpp"
+#include "gwf_watcher.hpp"
+
+namespace
+{
+std::chrono::milliseconds const DEBOUNCE(1000);
+// Time the translation thread is blocked in the callback of the busy file
+std::chrono::milliseconds const BUSY_TIME(2000);
+
+void WriteDiagram(std::string const & filePath, uint64_t seed, std::string const & identifier)
+{
+  GWFGenerator::Params params;
+  params.m_seed = seed;
+  params.m_nodesCount = 50;
+  params.m_pairsCount = 50;
+
+  std::string xmlStr = GWFGenerator::Generate(params);
+  // The identifier of the first node tells saves apart in SCs text
+  std::size_t const identifierPosition = xmlStr.find("idtf=\"") + 6;
+  xmlStr.insert(identifierPosition, identifier);
+
+  std::ofstream(filePath) << xmlStr;
+}
+}  // namespace
+
+int main()
+{
+  std::filesystem::path const directory = std::filesystem::temp_directory_path() / "gwf_watcher_test";
+  std::filesystem::remove_all(directory);
+  std::filesystem::create_directories(directory);
+  std::string const busyFilePath = (directory / "busy.gwf").string();
+  std::string const filePath = (directory / "saved.gwf").string();
+
+  std::mutex mutex;
+  std::vector<std::string> translations;
+  std::vector<std::string> errors;
+  GWFWatcher watcher(
+      directory.string(),
+      [&](std::string const & translatedFilePath, std::string const & scsText)
+      {
+        if (translatedFilePath == busyFilePath)
+        {
+          std::this_thread::sleep_for(BUSY_TIME);
+          return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        translations.push_back(scsText);
+      },
+      [&](std::string const & failedFilePath, std::string const & errorMessage)
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        errors.push_back(failedFilePath + ": " + errorMessage);
+      },
+      DEBOUNCE);
+  watcher.Start();
+
+  auto const start = std::chrono::steady_clock::now();
+  WriteDiagram(busyFilePath, 1, "busy");
+  // Ready after the debounce window, while the translation thread is blocked in the busy callback
+  std::this_thread::sleep_until(start + DEBOUNCE + DEBOUNCE / 5);
+  WriteDiagram(filePath, 2, "first_save");
+  // Pending until after the translation thread is free again
+  std::this_thread::sleep_until(start + DEBOUNCE + BUSY_TIME - DEBOUNCE / 2);
+  WriteDiagram(filePath, 3, "second_save");
+  // Past the debounce window of the second save
+  std::this_thread::sleep_until(start + 2 * DEBOUNCE + 2 * BUSY_TIME);
+  watcher.Stop();
+
+  std::filesystem::remove_all(directory);
+
+  int status = EXIT_SUCCESS;
+  for (std::string const & error : errors)
+  {
+    std::cerr << "Translation failed: " << error << "\n";
+    status = EXIT_FAILURE;
+  }
+  if (translations.size() != 1)
+  {
+    std::cerr << "The file saved twice has been translated " << translations.size() << " times instead of once.\n";
+    status = EXIT_FAILURE;
+  }
+  else if (translations.front().find("second_save") == std::string::npos)
+  {
+    std::cerr << "The file saved twice hasn't been translated from its second save.\n";
+    status = EXIT_FAILURE;
+  }
+
+  if (status == EXIT_SUCCESS)
+    std::cout << "A file saved twice while the watcher was busy has been translated once.\n";
+  return status;
+}
@@ -0,0 +1,138 @@
+/*
+ * This source file is part of an OSTIS project. For the latest info, see http://ostis.net
+ * Distributed under the MIT License
+ * (See accompanying file COPYING.MIT or copy at http://opensource.org/licenses/MIT)
+ */
+
+/*
+ * Checks that SCsWriter::IdentifierIndex resolves names of different elements that SCgIdentifierCorrector makes equal,
+ * e.g.
+ *
+ *   g++ -std=c++17 -I. -I/usr/include/libxml2 *.cpp tests/sc_scs_writer_test.cpp -lsc-memory -lxml2 -lpthread
+ *
+ * Cases:
+ *   fallback - Russian identifiers of two nodes fall back to `..el_<id>` names, equal for ids `7-1` and `7_1`;
+ *   variable - variables named `x` are prefixed to `_x`, which is an identifier of a constant written as it is.
+ * Exits with a non-zero status if any name differs from the expected one.
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "buffer.hpp"
+#include "sc_scg_element.hpp"
+#include "sc_scs_writer.hpp"
+
+namespace
+{
+std::string const CONST_NODE_TYPE = "node/const/perm/general";
+std::string const VAR_NODE_TYPE = "node/var/general_node";
+
+class Case
+{
+public:
+  explicit Case(std::string name)
+    : m_name(std::move(name))
+  {
+  }
+
+  SCgElementPtr const & AddNode(std::string_view id, std::string_view identifier, std::string_view type)
+  {
+    auto const node = std::make_shared<SCgNode>(id, "0", identifier, type, Constants::NODE);
+    return m_elements.emplace(node->GetId(), node).first->second;
+  }
+
+  SCgElements const & GetElements() const
+  {
+    return m_elements;
+  }
+
+  void Expect(bool isExpected, std::string const & message)
+  {
+    if (!isExpected)
+    {
+      std::cerr << m_name << ": " << message << "\n";
+      m_isFailed = true;
+    }
+  }
+
+  void ExpectName(
+      SCsWriter::IdentifierIndex const & identifiers,
+      SCgElementPtr const & element,
+      std::string_view expectedName)
+  {
+    std::string_view const name = identifiers.GetName(element);
+    Expect(
+        name == expectedName,
+        "element `" + std::string(element->GetId()) + "` is named `" + std::string(name) + "` instead of `"
+            + std::string(expectedName) + "`.");
+  }
+
+  bool IsFailed() const
+  {
+    return m_isFailed;
+  }
+
+private:
+  std::string m_name;
+  SCgElements m_elements;
+  bool m_isFailed = false;
+};
+
+bool CheckFallbackNames()
+{
+  Case check("fallback");
+  SCgElementPtr const & firstNode = check.AddNode("7-1", "Яблоко", CONST_NODE_TYPE);
+  SCgElementPtr const & secondNode = check.AddNode("7_1", "Груша", CONST_NODE_TYPE);
+
+  SCsWriter::IdentifierIndex const identifiers(check.GetElements());
+  check.ExpectName(identifiers, firstNode, "..el_7_1");
+  check.ExpectName(identifiers, secondNode, "..el_7_1_1");
+  check.Expect(identifiers.GetCollisionsCount() == 1, "collisions aren't counted once.");
+  check.Expect(identifiers.GetMainIdentifier(secondNode) == "Груша", "the Russian identifier isn't kept.");
+
+  Buffer buffer;
+  SCgElementsSet writtenElements;
+  SCsWriter::Write(check.GetElements(), "fallback.gwf", buffer, 0, writtenElements, identifiers);
+  std::string const scsText = buffer.GetValue();
+  check.Expect(
+      scsText.find("..el_7_1_1\n") != std::string::npos
+          && scsText.find("=> nrel_main_idtf: [Груша];;") != std::string::npos,
+      "the suffixed name isn't written with its main identifier:\n" + scsText);
+  return !check.IsFailed();
+}
+
+bool CheckVariableNames()
+{
+  Case check("variable");
+  SCgElementPtr const & constant = check.AddNode("1", "_x", CONST_NODE_TYPE);
+  SCgElementPtr const & firstVariable = check.AddNode("2", "x", VAR_NODE_TYPE);
+  SCgElementPtr const & secondVariable = check.AddNode("3", "x", VAR_NODE_TYPE);
+  SCgElementPtr const & prefixedVariable = check.AddNode("4", "_x", VAR_NODE_TYPE);
+
+  SCsWriter::IdentifierIndex const identifiers(check.GetElements());
+  check.ExpectName(identifiers, constant, "_x");
+  check.ExpectName(identifiers, prefixedVariable, "_x");
+  // Variables with equal identifiers are one SCs element
+  check.ExpectName(identifiers, firstVariable, "_x_1");
+  check.ExpectName(identifiers, secondVariable, "_x_1");
+  check.Expect(identifiers.GetCollisionsCount() == 1, "collisions aren't counted once.");
+  return !check.IsFailed();
+}
+}  // namespace
+
+int main()
+{
+  bool isPassed = CheckFallbackNames();
+  isPassed = CheckVariableNames() && isPassed;
+
+  if (!isPassed)
+    return EXIT_FAILURE;
+
+  std::cout << "Colliding names of elements have been resolved.\n";
+  return EXIT_SUCCESS;
+}